@@ -0,0 +1,144 @@
+#include "AppendFile.h"
+
+#include <filesystem>
+#include <format>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+AppendFile::AppendFile(const std::string& path)
+    : path_{ path }
+{
+    const auto handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(handle == INVALID_HANDLE_VALUE)
+        throw std::runtime_error(std::format("File ({}) cannot be opened.", path));
+
+    file_ = reinterpret_cast<std::intptr_t>(handle);
+}
+
+AppendFile::~AppendFile() { CloseHandle(reinterpret_cast<HANDLE>(file_)); }
+
+std::uint64_t AppendFile::Size() const
+{
+    LARGE_INTEGER size;
+    GetFileSizeEx(reinterpret_cast<HANDLE>(file_), &size);
+    return static_cast<std::uint64_t>(size.QuadPart);
+}
+
+void AppendFile::ReadAt(void* data, std::size_t size, std::uint64_t offset) const
+{
+    OVERLAPPED overlapped{ };
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD read{ };
+    if(!ReadFile(reinterpret_cast<HANDLE>(file_), data, static_cast<DWORD>(size), &read, &overlapped) || read != size)
+        throw std::runtime_error(std::format("File ({}) cannot be read.", path_));
+}
+
+void AppendFile::Truncate(std::uint64_t size)
+{
+    LARGE_INTEGER position;
+    position.QuadPart = static_cast<LONGLONG>(size);
+    if(!SetFilePointerEx(reinterpret_cast<HANDLE>(file_), position, nullptr, FILE_BEGIN) || !SetEndOfFile(reinterpret_cast<HANDLE>(file_)))
+        throw std::runtime_error(std::format("File ({}) cannot be truncated.", path_));
+}
+
+void AppendFile::Write(const void* data, std::size_t size)
+{
+    DWORD written{ };
+    if(!WriteFile(reinterpret_cast<HANDLE>(file_), data, static_cast<DWORD>(size), &written, nullptr) || written != size)
+        throw std::runtime_error(std::format("File ({}) cannot be written.", path_));
+}
+
+void AppendFile::Sync()
+{
+    if(!FlushFileBuffers(reinterpret_cast<HANDLE>(file_)))
+        throw std::runtime_error(std::format("File ({}) cannot be synced.", path_));
+}
+
+void AppendFile::Replace(const std::string& from, const std::string& to)
+{
+    if(!MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+        throw std::runtime_error(std::format("File ({}) cannot be renamed to ({}).", from, to));
+}
+#else
+AppendFile::AppendFile(const std::string& path)
+    : path_{ path }
+    , file_{ ::open(path.c_str(), O_RDWR | O_CREAT, 0644) }
+{
+    if(file_ < 0)
+        throw std::runtime_error(std::format("File ({}) cannot be opened.", path));
+}
+
+AppendFile::~AppendFile() { ::close(static_cast<int>(file_)); }
+
+std::uint64_t AppendFile::Size() const
+{
+    struct stat status{ };
+    ::fstat(static_cast<int>(file_), &status);
+    return static_cast<std::uint64_t>(status.st_size);
+}
+
+void AppendFile::ReadAt(void* data, std::size_t size, std::uint64_t offset) const
+{
+    if(::pread(static_cast<int>(file_), data, size, static_cast<off_t>(offset)) != static_cast<ssize_t>(size))
+        throw std::runtime_error(std::format("File ({}) cannot be read.", path_));
+}
+
+void AppendFile::Truncate(std::uint64_t size)
+{
+    if(::ftruncate(static_cast<int>(file_), static_cast<off_t>(size)) != 0 || ::lseek(static_cast<int>(file_), static_cast<off_t>(size), SEEK_SET) < 0)
+        throw std::runtime_error(std::format("File ({}) cannot be truncated.", path_));
+}
+
+void AppendFile::Write(const void* data, std::size_t size)
+{
+    auto bytes = static_cast<const char*>(data);
+    while(size != 0)
+    {
+        const auto written = ::write(static_cast<int>(file_), bytes, size);
+        if(written < 0)
+            throw std::runtime_error(std::format("File ({}) cannot be written.", path_));
+
+        bytes += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
+
+void AppendFile::Sync()
+{
+#if defined(__APPLE__)
+    const auto result = ::fsync(static_cast<int>(file_));
+#else
+    const auto result = ::fdatasync(static_cast<int>(file_));
+#endif
+    if(result != 0)
+        throw std::runtime_error(std::format("File ({}) cannot be synced.", path_));
+}
+
+void AppendFile::Replace(const std::string& from, const std::string& to)
+{
+    if(::rename(from.c_str(), to.c_str()) != 0)
+        throw std::runtime_error(std::format("File ({}) cannot be renamed to ({}).", from, to));
+
+    // The rename is an update of the directory, which has to be synced on its own.
+    auto directory = std::filesystem::path{ to }.parent_path();
+    if(directory.empty())
+        directory = ".";
+
+    const auto fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    const bool synced = fd >= 0 && ::fsync(fd) == 0;
+    if(fd >= 0)
+        ::close(fd);
+    if(!synced)
+        throw std::runtime_error(std::format("Directory of ({}) cannot be synced.", to));
+}
+#endif
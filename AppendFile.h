@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+** AppendFile is a file opened for reading and writing (created if missing) that is only ever written at its end, the
+   way the CommandJournal, the TradeLog and BookSnapshot::Save() write theirs. It is an fd on POSIX and a HANDLE on Windows.
+** Every failure throws std::runtime_error.
+*/
+class AppendFile
+{
+public:
+    explicit AppendFile(const std::string& path);
+    AppendFile(const AppendFile&) = delete;
+    void operator=(const AppendFile&) = delete;
+    AppendFile(AppendFile&&) = delete;
+    void operator=(AppendFile&&) = delete;
+    ~AppendFile();
+
+    std::uint64_t Size() const;
+    void ReadAt(void* data, std::size_t size, std::uint64_t offset) const;
+
+    // Cuts the file at 'size' and leaves the file position there, where the next write appends.
+    void Truncate(std::uint64_t size);
+    void Write(const void* data, std::size_t size);
+
+    // Makes what was written so far durable. A failed sync may have lost any of it and a retry can't tell, the
+    // kernel may already have dropped the dirty pages, so callers must treat it as fatal for what they wrote.
+    void Sync();
+
+    // Renames 'from' over 'to' atomically and makes the rename itself durable (on POSIX by syncing the directory).
+    // 'from' must have been synced, otherwise the new name may survive a power loss while the data doesn't.
+    static void Replace(const std::string& from, const std::string& to);
+
+private:
+    std::string path_;
+    std::intptr_t file_;
+};
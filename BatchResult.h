@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Usings.h"
+#include "Trade.h"
+
+enum class CommandStatus
+{
+    Accepted,   // The command was applied (an add may still have been partly or fully filled straight away).
+    Rejected,   // Nothing was changed: duplicate OrderID, unfillable FillOrKill/FillAndKill, price off the tick grid...
+    NotFound,   // Cancel or modify of an order that isn't resting on the book.
+    RiskRejected,   // Nothing was changed: the order failed the book's pre-trade risk checks, see RiskGate.
+};
+
+// The outcome of one command, its trades are trades_[firstTrade_, firstTrade_ + tradeCount_) of the BatchResult.
+struct CommandResult
+{
+    OrderID orderId_{ };
+    CommandStatus status_{ CommandStatus::Accepted };
+    std::uint32_t firstTrade_{ };
+    std::uint32_t tradeCount_{ };
+};
+
+/*
+** BatchResult is owned by the caller of Orderbook::ProcessBatch and reused from one batch to the next.
+** ProcessBatch only appends to it, so once its vectors have grown to the size of a typical burst there is
+   no allocation left per command or per batch. Call Clear() before reusing it.
+*/
+struct BatchResult
+{
+    Trades trades_;
+    std::vector<CommandResult> results_;
+
+    void Clear()
+    {
+        trades_.clear();
+        results_.clear();
+    }
+};
@@ -0,0 +1,205 @@
+// Drives an Orderbook with a seeded synthetic order flow (see OrderFlowGenerator) through AddOrder, CancelOrder and
+// ModifyOrder, and reports the throughput and the latency percentiles of every operation type. The summary goes to
+// stderr, the machine-readable results (one JSON object) to stdout, so runs can be stored and compared.
+//
+//     Benchmark [--commands=N] [--seed=N] [--depth=N] [--label=name] [--matching=fifo|prorata|toporder]
+//               [--add=W] [--cancel=W] [--modify=W] [--market=W] [--fak=W] [--fok=W]
+//               [--gfd=R] [--aggressive=R] [--distance=TICKS] [--drift=TICKS] [--lots=N]
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+#include "Orderbook.h"
+#include "OrderFlowGenerator.h"
+#include "LatencyHistogram.h"
+#include "BookMetrics.h"
+
+namespace
+{
+    constexpr std::array<const char*, FlowOperationCount> OperationNames{ "add", "fill_and_kill", "fill_or_kill", "market", "cancel", "modify" };
+
+    struct BenchmarkOptions
+    {
+        std::size_t commands_{ 1'000'000 };
+        std::string label_{ "orderbook" };
+        std::string matching_{ "fifo" };       // The book's MatchingPolicy, see MatchingPolicy.h.
+        OrderFlowOptions flow_;
+    };
+
+    bool ParseOption(const char* argument, BenchmarkOptions& options)
+    {
+        const auto value = std::strchr(argument, '=');
+        if(!value)
+            return false;
+
+        const std::string name{ argument, value };
+        const auto number = std::atof(value + 1);
+        auto& flow = options.flow_;
+
+        if(name == "--commands") options.commands_ = static_cast<std::size_t>(number);
+        else if(name == "--label") options.label_ = value + 1;
+        else if(name == "--matching") options.matching_ = value + 1;
+        else if(name == "--seed") flow.seed_ = std::strtoull(value + 1, nullptr, 10);
+        else if(name == "--depth") flow.initialDepth_ = static_cast<std::size_t>(number);
+        else if(name == "--add") flow.addWeight_ = number;
+        else if(name == "--cancel") flow.cancelWeight_ = number;
+        else if(name == "--modify") flow.modifyWeight_ = number;
+        else if(name == "--market") flow.marketWeight_ = number;
+        else if(name == "--fak") flow.fillAndKillWeight_ = number;
+        else if(name == "--fok") flow.fillOrKillWeight_ = number;
+        else if(name == "--gfd") flow.goodForDayRatio_ = number;
+        else if(name == "--aggressive") flow.aggressiveRatio_ = number;
+        else if(name == "--distance") flow.meanDistanceTicks_ = number;
+        else if(name == "--drift") flow.midDriftTicks_ = number;
+        else if(name == "--lots") flow.meanLots_ = number;
+        else return false;
+
+        return true;
+    }
+
+    template<typename Book>
+    void Apply(Book& book, const OrderCommand& command)
+    {
+        switch(command.type_)
+        {
+        case CommandType::Add:
+            book.AddOrder(command.ToOrder());
+            break;
+        case CommandType::Cancel:
+            book.CancelOrder(command.orderId_);
+            break;
+        case CommandType::Modify:
+            book.ModifyOrder(command.ToOrderModify());
+            break;
+        case CommandType::ExpireGoodForDay:
+            book.ExpireGoodForDayOrders();
+            break;
+        case CommandType::Execute:
+        case CommandType::Reduce:
+        case CommandType::MassCancel:
+            book.Apply(command);
+            break;
+        }
+    }
+
+
+    template<typename Book>
+    void Run(const BenchmarkOptions& options, const std::vector<FlowCommand>& prefill, const std::vector<FlowCommand>& commands)
+    {
+        OrderbookOptions bookOptions;
+        bookOptions.tickSize_ = options.flow_.tickSize_;
+        bookOptions.orderCapacity_ = prefill.size() + commands.size();
+        Book book{ bookOptions };
+
+        for(const auto& command : prefill)
+            Apply(book, command.command_);
+
+        std::array<LatencyHistogram, FlowOperationCount> latencies;
+        const auto start = std::chrono::steady_clock::now();
+
+        for(const auto& command : commands)
+        {
+            const auto before = std::chrono::steady_clock::now();
+            Apply(book, command.command_);
+            const auto after = std::chrono::steady_clock::now();
+
+            latencies[static_cast<std::size_t>(command.operation_)].Record(static_cast<std::uint64_t>((after - before).count()));
+        }
+
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const auto throughput = elapsed > 0 ? static_cast<double>(commands.size()) / elapsed : 0.0;
+
+        // The steady clock ticks in nanoseconds on the platforms we run on, the results are labelled accordingly.
+        static_assert(std::is_same_v<std::chrono::steady_clock::period, std::nano>, "Latencies are reported in nanoseconds.");
+
+        std::cerr << options.label_ << ": " << commands.size() << " commands in " << elapsed << "s, " << std::fixed << std::setprecision(0)
+            << throughput << " commands/s, " << book.Size() << " resting orders\n";
+        std::cerr << std::left << std::setw(16) << "operation" << std::right << std::setw(10) << "count" << std::setw(10) << "p50"
+            << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max" << "  (ns)\n";
+
+        for(std::size_t operation = 0; operation < FlowOperationCount; ++operation)
+        {
+            const auto& histogram = latencies[operation];
+            std::cerr << std::left << std::setw(16) << OperationNames[operation] << std::right << std::setw(10) << histogram.Count()
+                << std::setw(10) << histogram.ValueAtPercentile(50) << std::setw(10) << histogram.ValueAtPercentile(99)
+                << std::setw(10) << histogram.ValueAtPercentile(99.9) << std::setw(10) << histogram.Max() << '\n';
+        }
+
+        std::cout << std::fixed << "{\"label\":\"" << options.label_ << "\",\"matching\":\"" << options.matching_ << "\",\"seed\":" << options.flow_.seed_ << ",\"commands\":" << commands.size()
+            << ",\"initial_depth\":" << prefill.size() << ",\"resting_orders\":" << book.Size() << ",\"seconds\":" << std::setprecision(6) << elapsed
+            << ",\"commands_per_second\":" << std::setprecision(0) << throughput << ",\"operations\":{";
+
+        for(std::size_t operation = 0; operation < FlowOperationCount; ++operation)
+        {
+            const auto& histogram = latencies[operation];
+            std::cout << (operation ? "," : "") << '"' << OperationNames[operation] << "\":{\"count\":" << histogram.Count()
+                << ",\"mean_ns\":" << std::setprecision(1) << histogram.Mean() << ",\"min_ns\":" << histogram.Min()
+                << ",\"p50_ns\":" << histogram.ValueAtPercentile(50) << ",\"p99_ns\":" << histogram.ValueAtPercentile(99)
+                << ",\"p999_ns\":" << histogram.ValueAtPercentile(99.9) << ",\"max_ns\":" << histogram.Max() << '}';
+        }
+
+        const auto memory = book.MemoryUsage();
+        std::cout << "},\"memory\":{\"orders_bytes\":" << memory.orders_ << ",\"levels_bytes\":" << memory.levels_
+            << ",\"index_bytes\":" << memory.index_ << ",\"bytes_per_order\":" << std::setprecision(1) << memory.BytesPerOrder() << '}';
+
+        // Built with ORDERBOOK_INSTRUMENTATION the book's own counters and gauges are reported as well.
+        if(const auto metrics = book.GetMetrics())
+        {
+            constexpr std::array<const char*, MetricCounterCount> CounterNames{ "trades", "levels_created", "levels_destroyed",
+                "orders_swept", "fill_and_kill_rejected", "fill_or_kill_rejected", "risk_rejected" };
+
+            const auto snapshot = metrics->Snapshot();
+            const auto ticksPerNanosecond = EstimateTicksPerNanosecond();
+            const auto& match = snapshot.GetLatency(MetricOperation::Match);
+
+            std::cout << ",\"book_metrics\":{\"resting_orders\":" << snapshot.restingOrders_ << ",\"bid_levels\":" << snapshot.bidLevels_
+                << ",\"ask_levels\":" << snapshot.askLevels_;
+            for(std::size_t counter = 0; counter < MetricCounterCount; ++counter)
+                std::cout << ",\"" << CounterNames[counter] << "\":" << snapshot.counters_[counter];
+
+            std::cout << ",\"match_count\":" << match.Count() << ",\"match_p99_ns\":" << std::setprecision(1) << match.ValueAtPercentile(99) / ticksPerNanosecond
+                << ",\"orders_swept_per_match_p99\":" << snapshot.ordersSweptPerMatch_.ValueAtPercentile(99) << '}';
+        }
+
+        std::cout << "}\n";
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    for(int arg = 1; arg < argc; ++arg)
+    {
+        if(!ParseOption(argv[arg], options))
+        {
+            std::cerr << "unknown option " << argv[arg] << ", see the top of Benchmark.cpp\n";
+            return 2;
+        }
+    }
+
+    // The whole flow is generated up front, so the generator's own cost never shows up in the measurements.
+    OrderFlowGenerator generator{ options.flow_ };
+    const auto prefill = generator.Prefill();
+    const auto commands = generator.Generate(options.commands_);
+
+    if(options.matching_ == "fifo")
+        Run<Orderbook>(options, prefill, commands);
+    else if(options.matching_ == "prorata")
+        Run<ProRataOrderbook>(options, prefill, commands);
+    else if(options.matching_ == "toporder")
+        Run<TopOrderProRataOrderbook>(options, prefill, commands);
+    else
+    {
+        std::cerr << "unknown matching policy " << options.matching_ << ", use fifo, prorata or toporder\n";
+        return 2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+/*
+** The memory held by an order book, by component, see Orderbook::MemoryUsage(). Everything the book keeps for reuse
+   (free order slots, the arrays of empty levels, spare index buckets) is counted, as that is what sits in the caches
+   and what a box full of books has to hold.
+** Adding up the usage of several books gives the usage of all of them.
+*/
+struct BookMemoryUsage
+{
+    std::size_t orders_{ };             // The order pool, 32 bytes per slot (see OrderRecord).
+    std::size_t levels_{ };             // Both price ladders: level slots, occupancy bitmaps and the queues of the levels.
+    std::size_t index_{ };              // The OrderID index, and the account tables of the RiskGate if the book has one.
+    std::size_t restingOrders_{ };
+
+    std::size_t Total() const { return orders_ + levels_ + index_; }
+    double BytesPerOrder() const { return restingOrders_ != 0 ? static_cast<double>(Total()) / static_cast<double>(restingOrders_) : 0.0; }
+
+    BookMemoryUsage& operator+=(const BookMemoryUsage& other)
+    {
+        orders_ += other.orders_;
+        levels_ += other.levels_;
+        index_ += other.index_;
+        restingOrders_ += other.restingOrders_;
+        return *this;
+    }
+};
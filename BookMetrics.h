@@ -0,0 +1,245 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+#include "RingBuffer.h"
+#include "LatencyHistogram.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// The time stamp counter on x86, nanoseconds of the steady clock elsewhere. See EstimateTicksPerNanosecond().
+inline std::uint64_t ReadTicks()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Measures how fast ReadTicks() runs against the steady clock, to turn the recorded ticks into nanoseconds.
+inline double EstimateTicksPerNanosecond(std::chrono::milliseconds duration = std::chrono::milliseconds{ 20 })
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto startTicks = ReadTicks();
+    std::this_thread::sleep_for(duration);
+    const auto ticks = ReadTicks() - startTicks;
+    const auto nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+    return nanoseconds > 0 ? static_cast<double>(ticks) / nanoseconds : 1.0;
+}
+
+enum class MetricOperation
+{
+    AddOrder,
+    CancelOrder,
+    ModifyOrder,
+    Apply,
+    ProcessBatch,
+    ExpireGoodForDay,
+    MassCancel,
+    Match,          // One MatchOrders() pass, also counted inside the operation that triggered it.
+    LockWait,       // Time spent acquiring ordersMutex_, this is where lock contention shows up.
+};
+
+constexpr std::size_t MetricOperationCount = 9;
+
+enum class MetricCounter
+{
+    Trades,
+    LevelsCreated,
+    LevelsDestroyed,
+    OrdersSwept,            // Resting orders filled completely by matching.
+    FillAndKillRejected,
+    FillOrKillRejected,
+    RiskRejected,
+};
+
+constexpr std::size_t MetricCounterCount = 7;
+
+// 64 buckets per power of two: latencies within about 3%, and a histogram small enough (15KB) to give every book its own.
+using MetricHistogram = BasicLatencyHistogram<SingleWriterCounter, 6>;
+
+// A copy of a book's metrics taken at one point in time, see BookMetrics::Snapshot().
+struct MetricsSnapshot
+{
+    std::array<BasicLatencyHistogram<std::uint64_t, 6>, MetricOperationCount> latencies_;     // In ticks, see ReadTicks().
+    BasicLatencyHistogram<std::uint64_t, 6> ordersSweptPerMatch_;
+    std::array<std::uint64_t, MetricCounterCount> counters_{ };
+    std::uint64_t restingOrders_{ };
+    std::uint64_t bidLevels_{ };
+    std::uint64_t askLevels_{ };
+
+    const auto& GetLatency(MetricOperation operation) const { return latencies_[static_cast<std::size_t>(operation)]; }
+    std::uint64_t GetCounter(MetricCounter counter) const { return counters_[static_cast<std::size_t>(counter)]; }
+};
+
+/*
+** BookMetrics is the instrumentation of one book. It is only written by the thread changing the book (under its
+   lock, or its single writer thread) and is read by a stats thread through Snapshot() without taking any lock.
+** Every value is a SingleWriterCounter, and the whole structure is cache line aligned in its own allocation,
+   so the stats thread never shares a cache line with the book's own data.
+*/
+struct alignas(CacheLineSize) BookMetrics
+{
+    std::array<MetricHistogram, MetricOperationCount> latencies_;
+    MetricHistogram ordersSweptPerMatch_;
+    std::array<SingleWriterCounter, MetricCounterCount> counters_;
+    SingleWriterCounter restingOrders_;
+    SingleWriterCounter bidLevels_;
+    SingleWriterCounter askLevels_;
+
+    // Values being written at the same time may be one update apart from each other, but never torn.
+    MetricsSnapshot Snapshot() const
+    {
+        MetricsSnapshot snapshot;
+        for(std::size_t operation = 0; operation < MetricOperationCount; ++operation)
+            snapshot.latencies_[operation].Merge(latencies_[operation]);
+
+        snapshot.ordersSweptPerMatch_.Merge(ordersSweptPerMatch_);
+        for(std::size_t counter = 0; counter < MetricCounterCount; ++counter)
+            snapshot.counters_[counter] = counters_[counter];
+
+        snapshot.restingOrders_ = restingOrders_;
+        snapshot.bidLevels_ = bidLevels_;
+        snapshot.askLevels_ = askLevels_;
+        return snapshot;
+    }
+};
+
+
+/*
+** Book instrumentation is compiled in only when ORDERBOOK_INSTRUMENTATION is defined (e.g. -DORDERBOOK_INSTRUMENTATION).
+** Without it MetricsRecorder is an empty class whose members do nothing, so every call site compiles away and
+   the book pays nothing at all.
+** With it the counters and gauges are always exact, and a timed operation costs two to three TSC reads and a
+   histogram bucket update. Where even that is too much, define ORDERBOOK_INSTRUMENTATION_SAMPLE_INTERVAL to a power
+   of two N: each thread then times only one operation in N (with its lock wait and matching), the others cost a branch.
+*/
+#if defined(ORDERBOOK_INSTRUMENTATION)
+
+#if !defined(ORDERBOOK_INSTRUMENTATION_SAMPLE_INTERVAL)
+#define ORDERBOOK_INSTRUMENTATION_SAMPLE_INTERVAL 1
+#endif
+
+constexpr std::uint32_t MetricSampleInterval = ORDERBOOK_INSTRUMENTATION_SAMPLE_INTERVAL;
+static_assert(std::has_single_bit(MetricSampleInterval), "ORDERBOOK_INSTRUMENTATION_SAMPLE_INTERVAL must be a power of two.");
+
+// Records the ticks between 'start' and its destruction as the latency of one operation, unless it wasn't sampled (start == 0).
+class MetricTimer
+{
+public:
+    MetricTimer(BookMetrics& metrics, MetricOperation operation, std::uint64_t start)
+        : metrics_{ metrics }
+        , operation_{ operation }
+        , start_{ start }
+    { }
+
+    MetricTimer(const MetricTimer&) = delete;
+    void operator=(const MetricTimer&) = delete;
+
+    ~MetricTimer()
+    {
+        if(start_ != 0)
+            metrics_.latencies_[static_cast<std::size_t>(operation_)].Record(ReadTicks() - start_);
+    }
+
+private:
+    BookMetrics& metrics_;
+    MetricOperation operation_;
+    std::uint64_t start_;
+};
+
+/*
+** MetricsRecorder is what the Orderbook holds and calls. LockOrders() brackets the lock with BeforeLock()/AfterLock()
+   (or calls AfterLock(0) in single writer mode), and the time read once the lock is held is also the start of the
+   operation that follows, so a locked operation costs three TSC reads and a single writer one two.
+** Its members are const so that they can be used from the book's const members. Everything it writes is written
+   while the book is held, like the book's own data.
+*/
+class MetricsRecorder
+{
+public:
+    MetricsRecorder() : metrics_{ std::make_unique<BookMetrics>() } { }
+
+    const BookMetrics* Get() const { return metrics_.get(); }
+
+    // Decides whether this operation is sampled, returns the time it started waiting for the lock or 0 if it isn't.
+    std::uint64_t BeforeLock() const { return Sampled() ? ReadTicks() : 0; }
+
+    void AfterLock(std::uint64_t lockStart) const
+    {
+        if(lockStart != 0)
+        {
+            operationStart_ = ReadTicks();
+            metrics_->latencies_[static_cast<std::size_t>(MetricOperation::LockWait)].Record(operationStart_ - lockStart);
+        }
+        else
+            operationStart_ = 0;
+    }
+
+    // Without a lock there is nothing to wait for, only the sampling decision is made.
+    void WithoutLock() const { operationStart_ = Sampled() ? ReadTicks() : 0; }
+
+    // Times the operation that started when the lock was taken.
+    [[nodiscard]] MetricTimer Time(MetricOperation operation) const { return MetricTimer{ *metrics_, operation, operationStart_ }; }
+
+    // Times a step inside the current operation, only when that operation is sampled.
+    [[nodiscard]] MetricTimer TimeStep(MetricOperation operation) const { return MetricTimer{ *metrics_, operation, operationStart_ != 0 ? ReadTicks() : 0 }; }
+
+    void Count(MetricCounter counter, std::uint64_t value = 1) const { metrics_->counters_[static_cast<std::size_t>(counter)] += value; }
+    void RecordSwept(std::uint64_t orders) const { metrics_->ordersSweptPerMatch_.Record(orders); Count(MetricCounter::OrdersSwept, orders); }
+
+    void SetDepth(std::size_t restingOrders, std::size_t bidLevels, std::size_t askLevels) const
+    {
+        metrics_->restingOrders_ = restingOrders;
+        metrics_->bidLevels_ = bidLevels;
+        metrics_->askLevels_ = askLevels;
+    }
+
+private:
+    std::unique_ptr<BookMetrics> metrics_;
+    mutable std::uint64_t operationStart_{ };
+
+    // The sampling counter is per thread, so it can be read before the book's lock is taken.
+    static bool Sampled()
+    {
+        if constexpr(MetricSampleInterval == 1)
+            return true;
+
+        thread_local std::uint32_t operations{ };
+        return (operations++ & (MetricSampleInterval - 1)) == 0;
+    }
+};
+
+#else
+
+// Compiled out: nothing is stored and every member is an inline no-op.
+class MetricsRecorder
+{
+public:
+    // The user provided destructor keeps 'unused variable' warnings away at the call sites, it still compiles to nothing.
+    struct NoTimer { ~NoTimer() { } };
+
+    const BookMetrics* Get() const { return nullptr; }
+
+    std::uint64_t BeforeLock() const { return 0; }
+    void AfterLock(std::uint64_t) const { }
+    void WithoutLock() const { }
+    NoTimer Time(MetricOperation) const { return { }; }
+    NoTimer TimeStep(MetricOperation) const { return { }; }
+    void Count(MetricCounter, std::uint64_t = 1) const { }
+    void RecordSwept(std::uint64_t) const { }
+    void SetDepth(std::size_t, std::size_t, std::size_t) const { }
+};
+
+#endif
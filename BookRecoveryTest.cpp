@@ -0,0 +1,333 @@
+// A seeded session of every command type (adds, fills, amend-downs and re-pricing modifies, cancels, executions,
+// GoodForDay expiry and mass cancels of every scope) is recovered three ways: by replaying its journal into an empty
+// book, by restoring a snapshot written to disk, and by restoring a snapshot taken mid-session and replaying the
+// journal from there. The recovered book must make the same trades and hold the same orders, levels and queue order
+// as the live one, and keep trading the same when both are driven on. A snapshot that repeats an order ID must be
+// refused without touching the book it was restored into.
+//
+//     BookRecoveryTest
+
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Orderbook.h"
+#include "CommandJournal.h"
+#include "TestCheck.h"
+
+namespace
+{
+    constexpr AccountID AccountCount = 4;
+
+    // Accounts are tracked so that orders keep their account through a recovery and can be mass cancelled by it.
+    OrderbookOptions BookOptions()
+    {
+        OrderbookOptions options;
+        options.riskLimits_.trackAccounts_ = true;
+        options.riskLimits_.accountCapacity_ = AccountCount;
+        return options;
+    }
+
+    // A seeded mix of every command a book takes, most of them against recently added orders, so that cancels,
+    // amend-downs, modifies and executions mostly find their order. The two sides only overlap at one price, so
+    // the book builds up depth and queues while some orders still trade on arrival.
+    class CommandFlow
+    {
+    public:
+        explicit CommandFlow(std::uint64_t seed) : random_{ seed } { }
+
+        OrderCommand Next()
+        {
+            const auto kind = Pick(10'000);
+            if(kind < 5'000 || targets_.empty())
+                return NextAdd();
+
+            const auto& target = targets_[Pick(targets_.size())];
+            if(kind < 6'500)
+                return OrderCommand::Cancel(target.orderId_);
+            if(kind < 7'300)
+                return OrderCommand::Modify(OrderModify{ target.orderId_, target.side_, target.price_, 1 + Pick(5) });
+            if(kind < 8'000)
+                return OrderCommand::Modify(OrderModify{ target.orderId_, target.side_, PickPrice(target.side_), 1 + Pick(40) });
+            if(kind < 8'700)
+                return OrderCommand::Reduce(target.orderId_, 1 + Pick(20));
+            if(kind < 9'300)
+                return OrderCommand::Execute(target.orderId_, 1 + Pick(10), Pick(2) ? 0 : target.price_);
+            if(kind < 9'900)
+                return OrderCommand::Cancel(nextOrderId_ + Pick(10));
+            if(kind < 9'970)
+            {
+                const auto low = 990 + static_cast<Price>(Pick(20));
+                return OrderCommand::MassCancel(MassCancelFilter::PriceRange(PickSide(), low, low + static_cast<Price>(Pick(5))));
+            }
+            if(kind < 9'990)
+                return OrderCommand::MassCancel(MassCancelFilter::Account(1 + Pick(AccountCount - 1)));
+            if(kind < 9'994)
+                return OrderCommand::MassCancel(MassCancelFilter::OneSide(PickSide()));
+            if(kind < 9'998)
+                return OrderCommand::ExpireGoodForDay();
+            return OrderCommand::MassCancel(MassCancelFilter::All());
+        }
+
+    private:
+        struct Target
+        {
+            OrderID orderId_;
+            Side side_;
+            Price price_;
+        };
+
+        std::mt19937_64 random_;
+        OrderID nextOrderId_{ 1 };
+        std::vector<Target> targets_;
+
+        std::uint32_t Pick(std::size_t count) { return static_cast<std::uint32_t>(random_() % count); }
+        Side PickSide() { return Pick(2) ? Side::Buy : Side::Sell; }
+        Price PickPrice(Side side) { return static_cast<Price>((side == Side::Buy ? 980 : 1000) + Pick(21)); }
+
+        OrderCommand NextAdd()
+        {
+            static constexpr OrderType Types[] = { OrderType::GoodTillCancel, OrderType::GoodTillCancel, OrderType::GoodTillCancel,
+                OrderType::GoodForDay, OrderType::GoodForDay, OrderType::FillAndKill, OrderType::FillOrKill, OrderType::Market };
+            const auto type = Types[Pick(std::size(Types))];
+            const auto side = PickSide();
+            const auto price = PickPrice(side);
+            const auto orderId = nextOrderId_++;
+
+            // Keep the most recent orders that may rest as the targets of the commands that need a resting order.
+            if(type == OrderType::GoodTillCancel || type == OrderType::GoodForDay)
+                targets_.push_back(Target{ orderId, side, price });
+            if(targets_.size() > 400)
+                targets_.erase(targets_.begin(), targets_.begin() + 100);
+
+            const Order order = type == OrderType::Market ? Order{ orderId, side, 1 + Pick(40), Pick(AccountCount) }
+                : Order{ type, orderId, side, price, 1 + Pick(40), Pick(AccountCount) };
+            return OrderCommand::Add(order);
+        }
+    };
+
+    bool SameTrades(const Trades& left, const Trades& right)
+    {
+        if(left.size() != right.size())
+            return false;
+
+        for(std::size_t index = 0; index < left.size(); ++index)
+        {
+            for(const auto& [one, other] : { std::pair{ left[index].GetBidTrade(), right[index].GetBidTrade() }, std::pair{ left[index].GetAskTrade(), right[index].GetAskTrade() } })
+            {
+                if(one.orderid_ != other.orderid_ || one.price_ != other.price_ || one.quantity_ != other.quantity_)
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    // The orders of both books, level by level in price order and within each level in queue order, with their
+    // quantities, types and accounts, then the level aggregates, the top of book and the account exposures.
+    void CheckSameBook(const Orderbook& live, const Orderbook& recovered, const char* what)
+    {
+        BookSnapshot liveOrders;
+        BookSnapshot recoveredOrders;
+        live.TakeSnapshot(liveOrders);
+        recovered.TakeSnapshot(recoveredOrders);
+
+        bool sameOrders = liveOrders.bidCount_ == recoveredOrders.bidCount_ && liveOrders.orders_.size() == recoveredOrders.orders_.size();
+        for(std::size_t index = 0; sameOrders && index < liveOrders.orders_.size(); ++index)
+        {
+            const auto& one = liveOrders.orders_[index];
+            const auto& other = recoveredOrders.orders_[index];
+            sameOrders = one.orderId_ == other.orderId_ && one.price_ == other.price_ && one.initialQuantity_ == other.initialQuantity_ &&
+                one.remainingQuantity_ == other.remainingQuantity_ && one.side_ == other.side_ && one.orderType_ == other.orderType_ &&
+                one.accountId_ == other.accountId_;
+        }
+        Check(sameOrders, what);
+        Check(live.Size() == recovered.Size(), "both books hold as many orders");
+
+        const auto liveLevels = live.GetOrderInfos();
+        const auto recoveredLevels = recovered.GetOrderInfos();
+        const auto sameLevels = [](const LevelInfos& one, const LevelInfos& other)
+        {
+            if(one.size() != other.size())
+                return false;
+            for(std::size_t index = 0; index < one.size(); ++index)
+            {
+                if(one[index].price != other[index].price || one[index].quantity_ != other[index].quantity_)
+                    return false;
+            }
+            return true;
+        };
+        Check(sameLevels(liveLevels.GetBids(), recoveredLevels.GetBids()) && sameLevels(liveLevels.GetAsks(), recoveredLevels.GetAsks()),
+            "both books have the same levels");
+        Check(live.GetTopOfBook().SameLevels(recovered.GetTopOfBook()), "both books publish the same top of book");
+
+        bool sameExposure = true;
+        for(AccountID account = 1; account < AccountCount; ++account)
+        {
+            const auto one = live.GetAccountExposure(account);
+            const auto other = recovered.GetAccountExposure(account);
+            sameExposure = sameExposure && one.openQuantity_ == other.openQuantity_ && one.openNotional_ == other.openNotional_;
+        }
+        Check(sameExposure, "both books count the same account exposure");
+    }
+
+    // Applies 'count' commands of the flow to every book in batches, appending the trades of the first book to 'trades'.
+    // The other books must trade exactly the same.
+    void Drive(CommandFlow& flow, std::size_t count, std::initializer_list<Orderbook*> books, Trades& trades)
+    {
+        std::vector<OrderCommand> commands;
+        BatchResult first;
+        BatchResult other;
+        bool same = true;
+
+        for(std::size_t done = 0; done < count; done += commands.size())
+        {
+            commands.clear();
+            for(std::size_t index = 0; index < 64 && done + index < count; ++index)
+                commands.push_back(flow.Next());
+
+            first.Clear();
+            (*books.begin())->ProcessBatch(commands, first);
+            for(auto book = books.begin() + 1; book != books.end(); ++book)
+            {
+                other.Clear();
+                (*book)->ProcessBatch(commands, other);
+                same = same && SameTrades(first.trades_, other.trades_);
+            }
+
+            trades.insert(trades.end(), first.trades_.begin(), first.trades_.end());
+        }
+
+        Check(same, "both books keep trading the same");
+    }
+
+    std::string TempPath(const char* name)
+    {
+        const auto path = (std::filesystem::temp_directory_path() / name).string();
+        std::filesystem::remove(path);
+        return path;
+    }
+
+    void JournalReplay()
+    {
+        const auto journalPath = TempPath("BookRecoveryTest.journal");
+        CommandFlow flow{ 12 };
+        Orderbook live{ BookOptions() };
+        Trades liveTrades;
+
+        {
+            CommandJournal journal{ journalPath, JournalOptions{ .syncOnCommit_ = false } };
+            live.AttachJournal(journal);
+            Drive(flow, 50'000, { &live }, liveTrades);
+            live.DetachJournal();
+            journal.WaitUntilDurable(journal.GetNextSequence() - 1);
+        }
+        Check(!liveTrades.empty() && live.Size() != 0, "the session trades and leaves orders resting");
+
+        Orderbook replayed{ BookOptions() };
+        Trades replayedTrades;
+        BatchResult result;
+        const JournalReader reader{ journalPath };
+        reader.Replay(replayed, result, [&replayedTrades](std::span<const JournalRecord>, const BatchResult& batch)
+            { replayedTrades.insert(replayedTrades.end(), batch.trades_.begin(), batch.trades_.end()); });
+
+        Check(SameTrades(liveTrades, replayedTrades), "the replay produces the trades of the session");
+        CheckSameBook(live, replayed, "the replayed book has the orders of the live book, in the same queue order");
+
+        // Queue priority only shows once the books trade on, so they have to keep producing the same trades.
+        Trades ignored;
+        Drive(flow, 10'000, { &live, &replayed }, ignored);
+        CheckSameBook(live, replayed, "the books stay the same after trading on");
+
+        std::filesystem::remove(journalPath);
+    }
+
+    void SnapshotRestore()
+    {
+        const auto snapshotPath = TempPath("BookRecoveryTest.snapshot");
+        CommandFlow flow{ 13 };
+        Orderbook live{ BookOptions() };
+        Trades ignored;
+        Drive(flow, 50'000, { &live }, ignored);
+
+        // Through the file, so that the encoding is part of the round trip.
+        BookSnapshot snapshot;
+        live.TakeSnapshot(snapshot);
+        snapshot.Save(snapshotPath);
+
+        // A snapshot whose last order repeats the first one's ID is refused before the book is touched, the same book
+        // then takes the good snapshot.
+        Orderbook restored{ BookOptions() };
+        auto duplicated = snapshot;
+        duplicated.orders_.back().orderId_ = duplicated.orders_.front().orderId_;
+        bool refused = false;
+        try
+        {
+            restored.RestoreSnapshot(duplicated);
+        }
+        catch(const std::logic_error&)
+        {
+            refused = true;
+        }
+        const auto infos = restored.GetOrderInfos();
+        Check(refused && restored.Size() == 0 && infos.GetBids().empty() && infos.GetAsks().empty(), "a refused snapshot leaves the book empty");
+
+        restored.RestoreSnapshot(BookSnapshot::Load(snapshotPath));
+        CheckSameBook(live, restored, "the restored book has the orders of the snapshot's book, in the same queue order");
+
+        Drive(flow, 10'000, { &live, &restored }, ignored);
+        CheckSameBook(live, restored, "the books stay the same after trading on");
+
+        std::filesystem::remove(snapshotPath);
+    }
+
+    // A snapshot taken in the middle of a session, then the journal replayed from the snapshot's sequence on.
+    void SnapshotAndJournalTail()
+    {
+        const auto journalPath = TempPath("BookRecoveryTest.tail.journal");
+        CommandFlow flow{ 1213 };
+        Orderbook live{ BookOptions() };
+        BookSnapshot snapshot;
+        Trades liveTrades;
+
+        {
+            CommandJournal journal{ journalPath, JournalOptions{ .syncOnCommit_ = false } };
+            live.AttachJournal(journal);
+            Drive(flow, 30'000, { &live }, liveTrades);
+            live.TakeSnapshot(snapshot);
+            liveTrades.clear();
+            Drive(flow, 30'000, { &live }, liveTrades);
+            live.DetachJournal();
+            journal.WaitUntilDurable(journal.GetNextSequence() - 1);
+        }
+        Check(snapshot.journalSequence_ != 0, "the snapshot records where the journal was");
+
+        Orderbook recovered{ BookOptions() };
+        recovered.RestoreSnapshot(snapshot);
+
+        Trades replayedTrades;
+        BatchResult result;
+        const JournalReader reader{ journalPath };
+        reader.Replay(recovered, result, [&replayedTrades](std::span<const JournalRecord>, const BatchResult& batch)
+            { replayedTrades.insert(replayedTrades.end(), batch.trades_.begin(), batch.trades_.end()); }, snapshot.journalSequence_);
+
+        Check(SameTrades(liveTrades, replayedTrades), "the journal tail produces the trades made after the snapshot");
+        CheckSameBook(live, recovered, "the snapshot and the journal tail rebuild the live book");
+
+        std::filesystem::remove(journalPath);
+    }
+}
+
+
+int main()
+{
+    JournalReplay();
+    SnapshotRestore();
+    SnapshotAndJournalTail();
+
+    return CheckResult("book recovery");
+}
@@ -0,0 +1,58 @@
+#include "BookSnapshot.h"
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+
+#include "AppendFile.h"
+
+void BookSnapshot::Save(const std::string& path) const
+{
+    // The snapshot is written and synced next to the old one, then renamed over it and the rename is synced too,
+    // so neither a crash nor a power loss leaves a half written snapshot behind.
+    const auto temporaryPath = path + ".tmp";
+    {
+        AppendFile file{ temporaryPath };
+
+        SnapshotHeader header;
+        header.tickSize_ = tickSize_;
+        header.bidCount_ = static_cast<std::uint32_t>(bidCount_);
+        header.orderCount_ = orders_.size();
+        header.journalSequence_ = journalSequence_;
+
+        file.Truncate(0);
+        file.Write(&header, sizeof(header));
+        file.Write(orders_.data(), orders_.size() * sizeof(SnapshotOrder));
+        file.Sync();
+    }
+
+    AppendFile::Replace(temporaryPath, path);
+}
+
+
+BookSnapshot BookSnapshot::Load(const std::string& path)
+{
+    std::ifstream file{ path, std::ios::binary };
+
+    SnapshotHeader header{ .magic_ = 0 };
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if(!file || header.magic_ != SnapshotHeader::Magic || header.version_ != SnapshotHeader{ }.version_ || header.recordSize_ != sizeof(SnapshotOrder) ||
+        header.bidCount_ > header.orderCount_)
+        throw std::runtime_error(std::format("File ({}) is not a snapshot this build can read.", path));
+
+    // A corrupt count must not size the vector, the file has to hold that many orders.
+    const auto size = std::filesystem::file_size(path);
+    if(header.orderCount_ > (size - sizeof(SnapshotHeader)) / sizeof(SnapshotOrder))
+        throw std::runtime_error(std::format("Snapshot ({}) is truncated.", path));
+
+    // The orders are read with a single call straight into their final, presized vector.
+    BookSnapshot snapshot{ header.tickSize_, header.bidCount_, header.journalSequence_, { } };
+    snapshot.orders_.resize(header.orderCount_);
+    file.read(reinterpret_cast<char*>(snapshot.orders_.data()), static_cast<std::streamsize>(snapshot.orders_.size() * sizeof(SnapshotOrder)));
+
+    if(!file)
+        throw std::runtime_error(std::format("Snapshot ({}) is truncated.", path));
+
+    return snapshot;
+}
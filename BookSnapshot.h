@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Usings.h"
+#include "Side.h"
+#include "OrderType.h"
+
+// One resting order of a snapshot, 32 bytes with no padding, written to disk as is.
+struct SnapshotOrder
+{
+    std::uint64_t orderId_{ };
+    std::int32_t price_{ };
+    std::uint32_t initialQuantity_{ };
+    std::uint32_t remainingQuantity_{ };
+    std::uint8_t side_{ };
+    std::uint8_t orderType_{ };
+    std::uint8_t reserved_[2]{ };
+    std::uint32_t accountId_{ };        // NoAccount unless the book had a RiskGate, the only place accounts are kept.
+    std::uint8_t reserved2_[4]{ };
+};
+
+static_assert(sizeof(SnapshotOrder) == 32, "SnapshotOrder is written to disk as is and must not change size.");
+
+// The snapshot file starts with this header, the orders follow it back to back.
+struct SnapshotHeader
+{
+    std::uint64_t magic_{ Magic };
+    std::uint32_t version_{ 2 };         // 2: orders carry their account.
+    std::uint32_t recordSize_{ sizeof(SnapshotOrder) };
+    std::int32_t tickSize_{ };
+    std::uint32_t bidCount_{ };
+    std::uint64_t orderCount_{ };
+    std::uint64_t journalSequence_{ };
+
+    static constexpr std::uint64_t Magic = 0x50414e534b4f4f42;     // "BOOKSNAP" read as little-endian bytes.
+};
+
+/*
+** BookSnapshot is the resting state of an Orderbook: the bids from best to worst price, then the asks from best to
+   worst price, and the orders of each level in their queue order. Nothing else is needed to rebuild the book.
+** Orderbook::TakeSnapshot() only copies the orders into 'orders_' while it holds the book, encoding and writing
+   the file with Save() happens afterwards, on whatever thread the caller likes.
+** 'journalSequence_' is the sequence number the attached CommandJournal would give the next command when the
+   snapshot was taken: restore the snapshot, then replay the journal from that sequence on.
+*/
+struct BookSnapshot
+{
+    Price tickSize_{ };
+    std::size_t bidCount_{ };                   // orders_[0, bidCount_) are bids, the rest are asks.
+    std::uint64_t journalSequence_{ };
+    std::vector<SnapshotOrder> orders_;
+
+    void Save(const std::string& path) const;
+    static BookSnapshot Load(const std::string& path);
+};
@@ -0,0 +1,125 @@
+#include "CommandJournal.h"
+
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+namespace
+{
+    void CheckHeader(const JournalHeader& header, const std::string& path)
+    {
+        if(header.magic_ != JournalHeader::Magic || header.version_ != JournalHeader{ }.version_ || header.recordSize_ != sizeof(JournalRecord))
+            throw std::runtime_error(std::format("File ({}) is not a journal this build can read.", path));
+    }
+}
+
+
+CommandJournal::CommandJournal(const std::string& path, const JournalOptions& options)
+    : options_{ options }
+    , file_{ path }
+    , firstSequence_{ }
+    , records_{ options.capacity_, options.waitStrategy_ }
+{
+    const auto size = file_.Size();
+    if(size < sizeof(JournalHeader))
+    {
+        const JournalHeader header;
+        file_.Truncate(0);
+        file_.Write(&header, sizeof(header));
+    }
+    else
+    {
+        JournalHeader header;
+        file_.ReadAt(&header, sizeof(header), 0);
+        CheckHeader(header, path);
+
+        // A record only partly written when the process died is dropped, the next one is appended in its place.
+        const auto recordCount = (size - sizeof(JournalHeader)) / sizeof(JournalRecord);
+        const auto end = sizeof(JournalHeader) + recordCount * sizeof(JournalRecord);
+        if(recordCount != 0)
+        {
+            JournalRecord last;
+            file_.ReadAt(&last, sizeof(last), end - sizeof(JournalRecord));
+            firstSequence_ = last.sequence_ + 1;
+        }
+
+        file_.Truncate(end);
+    }
+
+    group_.reserve(options_.maxGroupSize_);
+    durableSequence_.store(firstSequence_, std::memory_order_relaxed);
+    flusherThread_ = std::thread{ [this] { Run(); } };
+}
+
+CommandJournal::~CommandJournal()
+{
+    shutdown_.store(true, std::memory_order_release);
+    records_.Wake();
+    flusherThread_.join();
+}
+
+
+void CommandJournal::WaitUntilDurable(std::uint64_t sequence) const
+{
+    for(auto durable = GetDurableSequence(); durable <= sequence; durable = GetDurableSequence())
+        durableSequence_.wait(durable, std::memory_order_acquire);
+}
+
+
+void CommandJournal::Run()
+{
+    auto sequence = firstSequence_;
+
+    while(true)
+    {
+        // Whatever is queued right now becomes one group, so the busier the book the fewer syncs per record.
+        records_.ConsumeBatch(options_.maxGroupSize_, [this, &sequence](const JournalRecord& record)
+        {
+            group_.push_back(record);
+            group_.back().sequence_ = sequence++;
+        });
+
+        if(!group_.empty())
+        {
+            Commit();
+            continue;
+        }
+
+        // Records appended before the shutdown request are still written, the ring is empty by the time we leave.
+        if(shutdown_.load(std::memory_order_acquire))
+            return;
+
+        records_.WaitForData();
+    }
+}
+
+
+void CommandJournal::Commit()
+{
+    // A journal that can't be written can't be recovered from either, so a failed write or sync ends the process
+    // (the exception leaves the flusher thread) rather than letting the book carry on unjournaled. Either throws
+    // before the group is counted as durable, so no caller of WaitUntilDurable() is ever told it is.
+    file_.Write(group_.data(), group_.size() * sizeof(JournalRecord));
+    if(options_.syncOnCommit_)
+        file_.Sync();
+
+    durableSequence_.fetch_add(group_.size(), std::memory_order_release);
+    durableSequence_.notify_all();
+    group_.clear();
+}
+
+
+JournalReader::JournalReader(const std::string& path)
+    : file_{ path }
+{
+    const auto bytes = file_.Bytes();
+
+    JournalHeader header{ .magic_ = 0 };
+    if(bytes.size() >= sizeof(JournalHeader))
+        std::memcpy(&header, bytes.data(), sizeof(header));
+    CheckHeader(header, path);
+
+    // The mapping is page aligned and the header is 16 bytes long, so the records are suitably aligned in place.
+    const auto recordCount = (bytes.size() - sizeof(JournalHeader)) / sizeof(JournalRecord);
+    records_ = { reinterpret_cast<const JournalRecord*>(bytes.data() + sizeof(JournalHeader)), recordCount };
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "OrderCommand.h"
+#include "BatchResult.h"
+#include "RingBuffer.h"
+#include "Orderbook.h"
+#include "MappedFile.h"
+#include "AppendFile.h"
+
+/*
+** JournalRecord is the on-disk form of one accepted command: 32 bytes, no padding, fixed field widths,
+   so that a journal written on one build reads back the same on another.
+** 'sequence_' starts at zero for the first record ever written and goes up by one per record.
+*/
+struct JournalRecord
+{
+    std::uint64_t sequence_{ };
+    std::uint64_t orderId_{ };
+    std::int32_t price_{ };
+    std::uint32_t quantity_{ };
+    std::uint8_t type_{ };
+    std::uint8_t orderType_{ };
+    std::uint8_t side_{ };
+    std::uint8_t scope_{ };
+    std::uint32_t accountId_{ };        // Zero in journals written before orders had accounts, which reads back as NoAccount.
+
+    // A mass cancel has no OrderID, the high price of its range takes that field.
+    static JournalRecord FromCommand(const OrderCommand& command)
+    {
+        const auto orderId = command.type_ == CommandType::MassCancel ? std::uint64_t{ static_cast<std::uint32_t>(command.highPrice_) } : command.orderId_;
+        return JournalRecord{ 0, orderId, command.price_, command.quantity_, static_cast<std::uint8_t>(command.type_),
+            static_cast<std::uint8_t>(command.orderType_), static_cast<std::uint8_t>(command.side_), static_cast<std::uint8_t>(command.scope_), command.accountId_ };
+    }
+
+    OrderCommand ToCommand() const
+    {
+        const bool massCancel = static_cast<CommandType>(type_) == CommandType::MassCancel;
+        return OrderCommand{ static_cast<CommandType>(type_), static_cast<OrderType>(orderType_), static_cast<Side>(side_), massCancel ? 0 : orderId_, price_, quantity_,
+            accountId_, static_cast<MassCancelScope>(scope_), massCancel ? static_cast<Price>(static_cast<std::uint32_t>(orderId_)) : 0 };
+    }
+};
+
+static_assert(sizeof(JournalRecord) == 32, "JournalRecord is written to disk as is and must not change size.");
+
+// The journal file starts with this header, the records follow it back to back.
+struct JournalHeader
+{
+    std::uint64_t magic_{ Magic };
+    std::uint32_t version_{ 1 };
+    std::uint32_t recordSize_{ sizeof(JournalRecord) };
+
+    static constexpr std::uint64_t Magic = 0x4c4e524a4b4f4f42;     // "BOOKJRNL" read as little-endian bytes.
+};
+
+struct JournalOptions
+{
+    std::size_t capacity_{ 1 << 16 };       // Records buffered between the book and the flusher, Append() waits once they are all in use.
+    std::size_t maxGroupSize_{ 4096 };      // Most records the flusher writes (and syncs) at once.
+    bool syncOnCommit_{ true };             // Sync every group to stable storage, off means the OS decides when the data reaches the disk.
+    WaitStrategy waitStrategy_{ WaitStrategy::Blocking };
+};
+
+/*
+** CommandJournal is a write-ahead log of the commands a book accepted. Attach it with Orderbook::AttachJournal().
+** Append() only copies the record into a lock-free ring, a background flusher drains the ring and writes
+   whatever has piled up as one group: one write and one sync for the whole group (group commit). The book
+   thread therefore never waits on I/O, only on the ring when the flusher has fallen 'capacity_' records behind.
+** Opening an existing journal appends to it, a record torn by a crash is cut off first.
+** Replaying the journal into an empty book built with the same OrderbookOptions rebuilds the book and produces
+   the same trades, in the same order, see JournalReader.
+*/
+class CommandJournal
+{
+public:
+    explicit CommandJournal(const std::string& path, const JournalOptions& options = { });
+    CommandJournal(const CommandJournal&) = delete;
+    void operator=(const CommandJournal&) = delete;
+    CommandJournal(CommandJournal&&) = delete;
+    void operator=(CommandJournal&&) = delete;
+
+    // Writes out everything appended so far before closing the file.
+    ~CommandJournal();
+
+    // Returns the sequence number of the record. Called by the book, under its lock or on its single writer thread.
+    std::uint64_t Append(const OrderCommand& command)
+    {
+        return firstSequence_ + records_.Push(JournalRecord::FromCommand(command));
+    }
+
+    // The sequence number the next appended record will get. Exact when the book holding the journal is not appending.
+    std::uint64_t GetNextSequence() const { return firstSequence_ + records_.PushedCount(); }
+
+    // Every record with a sequence number below this one has been written (and synced, with syncOnCommit_).
+    std::uint64_t GetDurableSequence() const { return durableSequence_.load(std::memory_order_acquire); }
+
+    // Blocks until the record with this sequence number is durable.
+    void WaitUntilDurable(std::uint64_t sequence) const;
+
+private:
+    JournalOptions options_;
+    AppendFile file_;
+    std::uint64_t firstSequence_;
+    RingBuffer<JournalRecord, ProducerMode::Multi> records_;
+    std::vector<JournalRecord> group_;
+    alignas(CacheLineSize) std::atomic<std::uint64_t> durableSequence_;
+    std::atomic<bool> shutdown_{ false };
+    std::thread flusherThread_;
+
+    void Run();
+    void Commit();
+};
+
+/*
+** JournalReader memory-maps a journal read-only, the records are used in place without being copied or parsed.
+** A trailing partial record (a crash in the middle of a write) is ignored.
+*/
+class JournalReader
+{
+public:
+    explicit JournalReader(const std::string& path);
+    JournalReader(const JournalReader&) = delete;
+    void operator=(const JournalReader&) = delete;
+    JournalReader(JournalReader&&) = delete;
+    void operator=(JournalReader&&) = delete;
+
+    std::span<const JournalRecord> Records() const { return records_; }
+
+    // The records from 'sequence' on, this is the tail to replay on top of a BookSnapshot (see BookSnapshot::journalSequence_).
+    std::span<const JournalRecord> RecordsFrom(std::uint64_t sequence) const
+    {
+        // Sequence numbers go up by one per record, so the record is found by its offset from the first one.
+        if(records_.empty() || sequence <= records_.front().sequence_)
+            return records_;
+
+        return records_.subspan(static_cast<std::size_t>(std::min<std::uint64_t>(sequence - records_.front().sequence_, records_.size())));
+    }
+
+    // Feeds every record from 'fromSequence' on through book.ProcessBatch(), 'batchSize' at a time, reusing 'result'
+    // between batches. After each batch onBatch(records, result) is called with the records of that batch and their results.
+    // The book must use the matching policy of the book that wrote the journal to reproduce its trades.
+    template<typename MatchingPolicy, typename Function>
+    std::uint64_t Replay(BasicOrderbook<MatchingPolicy>& book, BatchResult& result, Function onBatch, std::uint64_t fromSequence = 0, std::size_t batchSize = 4096) const;
+
+    template<typename MatchingPolicy>
+    std::uint64_t Replay(BasicOrderbook<MatchingPolicy>& book, std::uint64_t fromSequence = 0, std::size_t batchSize = 4096) const
+    {
+        BatchResult result;
+        return Replay(book, result, [](std::span<const JournalRecord>, const BatchResult&) { }, fromSequence, batchSize);
+    }
+
+private:
+    MappedFile file_;
+    std::span<const JournalRecord> records_;
+};
+
+
+template<typename MatchingPolicy, typename Function>
+std::uint64_t JournalReader::Replay(BasicOrderbook<MatchingPolicy>& book, BatchResult& result, Function onBatch, std::uint64_t fromSequence, std::size_t batchSize) const
+{
+    const auto records = RecordsFrom(fromSequence);
+    std::vector<OrderCommand> commands;
+    commands.reserve(batchSize);
+
+    for(std::size_t first = 0; first < records.size(); first += batchSize)
+    {
+        const auto batch = records.subspan(first, std::min(batchSize, records.size() - first));
+
+        commands.clear();
+        for(const auto& record : batch)
+            commands.push_back(record.ToCommand());
+
+        result.Clear();
+        book.ProcessBatch(commands, result);
+        onBatch(batch, result);
+    }
+
+    return records.size();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "OrderbookEvent.h"
+#include "RingBuffer.h"
+
+/*
+** EventRingSink is the built-in EventSink: it copies every event into a preallocated SPSC ring that a consumer
+   thread (drop-copy, market data, risk...) drains with Poll(), so publishing an event never allocates.
+** The book thread never waits for the consumer. If the ring is full the event is dropped and counted instead,
+   size the ring for the worst burst you expect between two polls.
+*/
+class EventRingSink
+{
+public:
+    explicit EventRingSink(std::size_t capacity = 1 << 16)
+        : events_{ capacity, WaitStrategy::BusySpin }      // Polled, its consumer never waits on it.
+    { }
+
+    void OnEvent(const OrderbookEvent& event)
+    {
+        if(!events_.TryPush(event))
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Calls function(event) for up to 'maxCount' events in the order they happened. Only one thread may poll.
+    template<typename Function>
+    std::size_t Poll(Function function, std::size_t maxCount = static_cast<std::size_t>(-1))
+    {
+        return events_.ConsumeBatch(maxCount, function);
+    }
+
+    std::uint64_t GetDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    RingBuffer<OrderbookEvent, ProducerMode::Single> events_;
+    std::atomic<std::uint64_t> dropped_{ };
+};
@@ -0,0 +1,77 @@
+#include "ExpiryScheduler.h"
+
+#include <algorithm>
+
+ExpiryScheduler::ExpiryScheduler(const ExpirySchedulerOptions& options)
+    : options_{ options }
+    , nextClose_{ NextCloseAfter(options_.clock_()) }
+    , schedulerThread_{ [this] { Run(); } }
+{ }
+
+ExpiryScheduler::~ExpiryScheduler()
+{
+    {
+        std::scoped_lock targetsLock{ targetsMutex_ };
+        shutdown_ = true;
+    }
+    shutdownConditionVariable_.notify_one();
+    schedulerThread_.join();
+}
+
+
+void ExpiryScheduler::Register(ExpiryTarget target)
+{
+    std::scoped_lock targetsLock{ targetsMutex_ };
+    targets_.push_back(target);
+}
+
+void ExpiryScheduler::Unregister(ExpiryTarget target)
+{
+    std::scoped_lock targetsLock{ targetsMutex_ };
+    targets_.erase(std::remove(targets_.begin(), targets_.end(), target), targets_.end());
+}
+
+
+std::chrono::system_clock::time_point ExpiryScheduler::GetNextClose() const
+{
+    std::scoped_lock targetsLock{ targetsMutex_ };
+    return nextClose_;
+}
+
+
+std::chrono::system_clock::time_point ExpiryScheduler::NextCloseAfter(std::chrono::system_clock::time_point now) const
+{
+    using namespace std::chrono;
+
+    // The venue's day starts at local midnight, the close is 'sessionClose_' into it, and it is turned back into UTC.
+    const auto localDay = floor<days>(now + options_.utcOffset_);
+    system_clock::time_point close = localDay + options_.sessionClose_ - options_.utcOffset_;
+
+    if(close <= now)
+        close += days{ 1 };
+
+    return close;
+}
+
+
+void ExpiryScheduler::Run()
+{
+    std::unique_lock targetsLock{ targetsMutex_ };
+
+    while(!shutdown_)
+    {
+        const auto now = options_.clock_();
+        if(now >= nextClose_)
+        {
+            for(const auto& target : targets_)
+                target();
+
+            nextClose_ = NextCloseAfter(now);
+            continue;
+        }
+
+        // The injected clock doesn't have to follow the steady clock, so we never sleep longer than the poll interval.
+        const auto till = std::min<std::chrono::system_clock::duration>(nextClose_ - now, options_.pollInterval_);
+        shutdownConditionVariable_.wait_for(targetsLock, till, [this] { return shutdown_; });
+    }
+}
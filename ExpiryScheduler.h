@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Returns the current time, it is injected so that the session close can be driven by a simulated or replayed clock.
+using ExpiryClock = std::function<std::chrono::system_clock::time_point()>;
+
+struct ExpirySchedulerOptions
+{
+    std::chrono::minutes sessionClose_{ 16 * 60 };          // Time of day, in venue local time, at which GoodForDay orders expire.
+    std::chrono::minutes utcOffset_{ };                     // Venue local time minus UTC (e.g. -5h for New York in winter).
+    std::chrono::milliseconds pollInterval_{ 1000 };        // Longest the scheduler sleeps before it reads the clock again.
+    ExpiryClock clock_{ [] { return std::chrono::system_clock::now(); } };
+};
+
+/*
+** ExpiryTarget is a non-owning reference to any object with a 'void OnSessionClose()' member: an Orderbook,
+   an OrderbookSequencer or an OrderbookEngine. It is bound the same way an EventSink is.
+*/
+class ExpiryTarget
+{
+public:
+    template<typename Target>
+    ExpiryTarget(Target& target)
+        : context_{ &target }
+        , onSessionClose_{ [](void* context) { static_cast<Target*>(context)->OnSessionClose(); } }
+    { }
+
+    void operator()() const { onSessionClose_(context_); }
+
+    bool operator==(const ExpiryTarget& other) const { return context_ == other.context_; }
+
+private:
+    void* context_;
+    void (*onSessionClose_)(void*);
+};
+
+/*
+** ExpiryScheduler is the one timer thread shared by every book of the process. At each session close it calls
+   OnSessionClose() on every registered target, and the targets expire their GoodForDay orders on their own thread.
+** The close is worked out from the injected clock in UTC plus the configured offset, so no platform specific
+   local time function is needed. If the clock jumps over several closes, the targets are only called once.
+** Targets are called on the scheduler's thread while it holds its lock: once Unregister() returns the target
+   won't be called anymore, but a target must never call back into the scheduler.
+*/
+class ExpiryScheduler
+{
+public:
+    explicit ExpiryScheduler(const ExpirySchedulerOptions& options = { });
+    ExpiryScheduler(const ExpiryScheduler&) = delete;
+    void operator=(const ExpiryScheduler&) = delete;
+    ExpiryScheduler(ExpiryScheduler&&) = delete;
+    void operator=(ExpiryScheduler&&) = delete;
+    ~ExpiryScheduler();
+
+    // Targets are not owned by the scheduler and must outlive their registration.
+    void Register(ExpiryTarget target);
+    void Unregister(ExpiryTarget target);
+
+    std::chrono::system_clock::time_point GetNextClose() const;
+
+private:
+    ExpirySchedulerOptions options_;
+    mutable std::mutex targetsMutex_;
+    std::condition_variable shutdownConditionVariable_;
+    std::vector<ExpiryTarget> targets_;
+    std::chrono::system_clock::time_point nextClose_;
+    bool shutdown_{ false };
+    std::thread schedulerThread_;
+
+    void Run();
+    std::chrono::system_clock::time_point NextCloseAfter(std::chrono::system_clock::time_point now) const;
+};
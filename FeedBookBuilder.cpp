@@ -0,0 +1,103 @@
+#include "FeedBookBuilder.h"
+
+FeedBookBuilder::FeedBookBuilder(const FeedBookBuilderOptions& options)
+    : options_{ options }
+    , books_( options.instrumentCapacity_ )
+{
+    options_.bookOptions_.singleWriter_ = true;
+    options_.bookOptions_.bookBuilding_ = true;
+}
+
+
+Orderbook& FeedBookBuilder::GetOrCreateBook(std::uint16_t stockLocate)
+{
+    if(stockLocate >= books_.size())
+        books_.resize(static_cast<std::size_t>(stockLocate) + 1);
+
+    auto& book = books_[stockLocate];
+    if(!book)
+    {
+        book = std::make_unique<Orderbook>(options_.bookOptions_);
+        ++bookCount_;
+    }
+
+    return *book;
+}
+
+
+BookMemoryUsage FeedBookBuilder::MemoryUsage() const
+{
+    BookMemoryUsage usage;
+    for(const auto& book : books_)
+    {
+        if(book)
+            usage += book->MemoryUsage();
+    }
+
+    return usage;
+}
+
+
+void FeedBookBuilder::Apply(std::uint16_t stockLocate, const OrderCommand& command)
+{
+    // Only adds create books, anything else for an instrument without a book refers to an order it can't hold.
+    const auto book = GetBook(stockLocate);
+    const auto status = book ? book->Apply(command) : CommandStatus::NotFound;
+
+    if(status == CommandStatus::NotFound)
+        ++stats_.notFound_;
+    else if(status == CommandStatus::Rejected)
+        ++stats_.rejected_;
+}
+
+
+void FeedBookBuilder::OnAdd(const FeedAdd& message)
+{
+    ++stats_.adds_;
+    const Order order{ OrderType::GoodTillCancel, message.orderId_, message.side_, message.price_, message.quantity_ };
+    if(GetOrCreateBook(message.stockLocate_).Apply(OrderCommand::Add(order)) != CommandStatus::Accepted)
+        ++stats_.rejected_;
+}
+
+
+void FeedBookBuilder::OnExecute(const FeedExecute& message)
+{
+    ++stats_.executions_;
+    Apply(message.stockLocate_, OrderCommand::Execute(message.orderId_, message.quantity_, message.price_));
+}
+
+
+void FeedBookBuilder::OnCancel(const FeedCancel& message)
+{
+    ++stats_.cancels_;
+    Apply(message.stockLocate_, OrderCommand::Reduce(message.orderId_, message.quantity_));
+}
+
+
+void FeedBookBuilder::OnDelete(const FeedDelete& message)
+{
+    ++stats_.deletes_;
+    Apply(message.stockLocate_, OrderCommand::Cancel(message.orderId_));
+}
+
+
+void FeedBookBuilder::OnReplace(const FeedReplace& message)
+{
+    ++stats_.replaces_;
+
+    // The new order inherits the side of the one it replaces, which only the book knows.
+    const auto book = GetBook(message.stockLocate_);
+    const auto handle = book ? book->FindOrder(message.orderId_) : InvalidOrderHandle;
+    if(handle == InvalidOrderHandle)
+    {
+        ++stats_.notFound_;
+        return;
+    }
+
+    const auto side = book->GetOrder(handle).GetSide();
+    book->Apply(OrderCommand::Cancel(message.orderId_));
+
+    const Order order{ OrderType::GoodTillCancel, message.newOrderId_, side, message.price_, message.quantity_ };
+    if(book->Apply(OrderCommand::Add(order)) != CommandStatus::Accepted)
+        ++stats_.rejected_;
+}
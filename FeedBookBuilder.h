@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "Orderbook.h"
+#include "ItchDecoder.h"
+
+struct FeedBookBuilderOptions
+{
+    // The settings of every book, built as single writer book building books whatever is set here. ITCH prices have
+    // four decimals, so a tick of 100 is one cent. Orders priced off that grid are rejected and counted (see FeedStats).
+    // The ladders start small since a feed has thousands of instruments, they grow where an instrument needs it.
+    OrderbookOptions bookOptions_{ .tickSize_ = 100, .initialLevels_ = 256 };
+    std::size_t instrumentCapacity_{ 1 << 16 };     // Stock locates are 2-byte integers, so no feed has more than this.
+};
+
+struct FeedStats
+{
+    std::uint64_t adds_{ };
+    std::uint64_t executions_{ };
+    std::uint64_t cancels_{ };
+    std::uint64_t deletes_{ };
+    std::uint64_t replaces_{ };
+    std::uint64_t rejected_{ };         // Messages the book turned down, e.g. an add priced off the tick grid.
+    std::uint64_t notFound_{ };         // Messages for orders the book doesn't hold, usually orders it had rejected.
+};
+
+/*
+** FeedBookBuilder rebuilds the books of a whole market-by-order feed: ItchDecoder decodes the stream in place and
+   every message is applied straight to the book of its instrument, found by the message's stock locate.
+** The books are in book building mode: the feed's orders rest where the venue put them without being matched here,
+   and the venue's executions fill them through CommandType::Execute.
+** A FeedBookBuilder is driven by one thread, and its books are single writer books owned by that thread.
+*/
+class FeedBookBuilder
+{
+public:
+    explicit FeedBookBuilder(const FeedBookBuilderOptions& options = { });
+    FeedBookBuilder(const FeedBookBuilder&) = delete;
+    void operator=(const FeedBookBuilder&) = delete;
+    FeedBookBuilder(FeedBookBuilder&&) = delete;
+    void operator=(FeedBookBuilder&&) = delete;
+
+    // Decodes and applies every complete message of 'bytes', and returns how many bytes that was, see ItchDecoder::Decode.
+    std::size_t Process(std::span<const std::byte> bytes) { return decoder_.Decode(bytes, *this); }
+
+    // The book of a stock locate, null until the feed has added an order for it.
+    Orderbook* GetBook(std::uint16_t stockLocate) const { return stockLocate < books_.size() ? books_[stockLocate].get() : nullptr; }
+    std::size_t GetBookCount() const { return bookCount_; }
+
+    // The memory of all the books together, see Orderbook::MemoryUsage().
+    BookMemoryUsage MemoryUsage() const;
+
+    const ItchDecoder& GetDecoder() const { return decoder_; }
+    const FeedStats& GetStats() const { return stats_; }
+
+    // The ItchDecoder handler, called from Process().
+    void OnAdd(const FeedAdd& message);
+    void OnExecute(const FeedExecute& message);
+    void OnCancel(const FeedCancel& message);
+    void OnDelete(const FeedDelete& message);
+    void OnReplace(const FeedReplace& message);
+
+private:
+    FeedBookBuilderOptions options_;
+    ItchDecoder decoder_;
+    std::vector<std::unique_ptr<Orderbook>> books_;
+    std::size_t bookCount_{ };
+    FeedStats stats_;
+
+    Orderbook& GetOrCreateBook(std::uint16_t stockLocate);
+    void Apply(std::uint16_t stockLocate, const OrderCommand& command);
+};
@@ -0,0 +1,84 @@
+// Rebuilds every book of an ITCH 5.0 capture file (2-byte length prefixed messages, see ItchDecoder) with a
+// FeedBookBuilder, and reports the decode and book building rate with the state of the books at the end.
+//
+//     FeedReplay <capture> [--tick-size N] [--print-books]
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+
+#include "FeedBookBuilder.h"
+#include "MappedFile.h"
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cerr << "usage: FeedReplay <capture> [--tick-size N] [--print-books]\n";
+        return 2;
+    }
+
+    FeedBookBuilderOptions options;
+    bool printBooks = false;
+    for(int arg = 2; arg < argc; ++arg)
+    {
+        if(std::strcmp(argv[arg], "--tick-size") == 0 && arg + 1 < argc)
+            options.bookOptions_.tickSize_ = static_cast<Price>(std::atoi(argv[++arg]));
+        else if(std::strcmp(argv[arg], "--print-books") == 0)
+            printBooks = true;
+    }
+
+    try
+    {
+        const MappedFile capture{ argv[1] };
+        FeedBookBuilder builder{ options };
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto consumed = builder.Process(capture.Bytes());
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const auto& decoder = builder.GetDecoder();
+        const auto& stats = builder.GetStats();
+        const auto messages = static_cast<double>(decoder.GetMessageCount());
+
+        std::cerr << decoder.GetMessageCount() << " messages (" << decoder.GetSkippedCount() << " skipped) in " << elapsed << "s, "
+            << (elapsed > 0 ? messages / elapsed : 0.0) << " messages/s, " << builder.GetBookCount() << " books\n"
+            << stats.adds_ << " adds, " << stats.executions_ << " executions, " << stats.cancels_ << " cancels, " << stats.deletes_ << " deletes, "
+            << stats.replaces_ << " replaces, " << stats.rejected_ << " rejected, " << stats.notFound_ << " not found\n";
+
+        const auto memory = builder.MemoryUsage();
+        std::cerr << memory.restingOrders_ << " resting orders in " << memory.Total() / 1024 << " KB (orders " << memory.orders_ / 1024
+            << " KB, levels " << memory.levels_ / 1024 << " KB, index " << memory.index_ / 1024 << " KB), "
+            << memory.BytesPerOrder() << " bytes per order\n";
+
+        if(consumed != capture.Bytes().size())
+            std::cerr << "the capture ends with an incomplete message (" << capture.Bytes().size() - consumed << " bytes)\n";
+
+        if(printBooks)
+        {
+            for(std::uint32_t locate = 0; locate <= 0xffff; ++locate)
+            {
+                const auto book = builder.GetBook(static_cast<std::uint16_t>(locate));
+                if(!book)
+                    continue;
+
+                const auto depth = book->GetDepth();
+                std::cout << locate << ' ' << book->Size() << " orders";
+                if(depth.bidCount_ != 0)
+                    std::cout << " bid " << depth.bids_[0].quantity_ << '@' << depth.bids_[0].price;
+                if(depth.askCount_ != 0)
+                    std::cout << " ask " << depth.asks_[0].quantity_ << '@' << depth.asks_[0].price;
+                std::cout << '\n';
+            }
+        }
+    }
+    catch(const std::exception& exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
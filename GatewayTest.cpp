@@ -0,0 +1,163 @@
+// Connects GatewayClients to an OrderGateway in the same process and trades through the shared memory rings. A client
+// may only cancel, modify or reduce its own orders, and never reuse a live OrderID. Both legs of a trade hear of their
+// fill at the execution price, the aggressor under its request, the resting order under none. A client that goes away
+// has what it left resting cancelled, and GoodForDay orders expire at the session close; either way their IDs are
+// free again.
+//
+//     GatewayTest
+
+#include <memory>
+#include <vector>
+
+#include "OrderGateway.h"
+#include "TestCheck.h"
+
+namespace
+{
+    constexpr SymbolID Symbol = 7;
+
+    // Every test runs its own gateway, so that a failed check doesn't leave orders behind for the next one.
+    GatewayOptions Options()
+    {
+        GatewayOptions options;
+        options.name_ = "/orderbook-gateway-test";
+        options.clientCapacity_ = 4;
+        options.requestCapacity_ = 64;
+        options.responseCapacity_ = 64;
+        return options;
+    }
+
+    OrderCommand Add(OrderID orderId, Side side, Price price, Quantity quantity, OrderType orderType = OrderType::GoodTillCancel)
+    {
+        return OrderCommand::Add(Order{ orderType, orderId, side, price, quantity });
+    }
+
+    // Submits one request, lets the gateway apply it and returns the responses the client got for it.
+    std::vector<GatewayResponse> Send(OrderGateway& gateway, GatewayClient& client, const OrderCommand& command, std::uint64_t* requestId = nullptr)
+    {
+        std::vector<GatewayResponse> responses;
+        Check(client.Submit(Symbol, command, requestId), "a request fits in an empty ring");
+        gateway.Poll();
+        client.PollResponses(responses);
+        return responses;
+    }
+
+    CommandStatus StatusOf(const std::vector<GatewayResponse>& responses)
+    {
+        return !responses.empty() && responses.front().type_ == GatewayResponseType::Result ? responses.front().status_ : CommandStatus::Rejected;
+    }
+
+    bool Resting(OrderGateway& gateway, OrderID orderId)
+    {
+        const auto book = gateway.GetBook(Symbol);
+        return book && book->FindOrder(orderId) != InvalidOrderHandle;
+    }
+
+    void Ownership()
+    {
+        OrderGateway gateway{ Options() };
+        GatewayClient owner{ Options().name_ };
+        GatewayClient other{ Options().name_ };
+        Check(gateway.GetClientCount() == 2, "both clients are connected");
+
+        Check(StatusOf(Send(gateway, owner, Add(1, Side::Buy, 100, 10))) == CommandStatus::Accepted, "a new order is accepted");
+        Check(gateway.GetBook(Symbol)->GetOrder(gateway.GetBook(Symbol)->FindOrder(1)).GetOrderId() == 1, "the order rests in the symbol's book");
+
+        Check(StatusOf(Send(gateway, other, OrderCommand::Cancel(1))) == CommandStatus::NotFound, "another client can't cancel the order");
+        Check(StatusOf(Send(gateway, other, OrderCommand::Modify(OrderModify{ 1, Side::Buy, 101, 5 }))) == CommandStatus::NotFound, "another client can't modify the order");
+        Check(StatusOf(Send(gateway, other, OrderCommand::Reduce(1, 5))) == CommandStatus::NotFound, "another client can't reduce the order");
+        Check(StatusOf(Send(gateway, other, Add(1, Side::Sell, 110, 10))) == CommandStatus::Rejected, "a live OrderID can't be added again");
+        Check(StatusOf(Send(gateway, other, OrderCommand::Execute(1, 5, 100))) == CommandStatus::Rejected, "clients can't execute orders");
+        Check(StatusOf(Send(gateway, other, OrderCommand::MassCancel(MassCancelFilter::All()))) == CommandStatus::Rejected, "clients can't mass cancel");
+        Check(Resting(gateway, 1) && gateway.GetBook(Symbol)->GetOrder(gateway.GetBook(Symbol)->FindOrder(1)).GetRemainingQuantity() == 10,
+            "the order is untouched by the refused requests");
+
+        Check(StatusOf(Send(gateway, owner, OrderCommand::Reduce(1, 4))) == CommandStatus::Accepted, "the owner can reduce its order");
+        Check(StatusOf(Send(gateway, owner, OrderCommand::Cancel(1))) == CommandStatus::Accepted && !Resting(gateway, 1), "the owner can cancel its order");
+        Check(StatusOf(Send(gateway, other, Add(1, Side::Sell, 110, 10))) == CommandStatus::Accepted, "a cancelled order's ID can be used again");
+    }
+
+    void FillsToBothLegs()
+    {
+        OrderGateway gateway{ Options() };
+        GatewayClient seller{ Options().name_ };
+        GatewayClient buyer{ Options().name_ };
+
+        Check(StatusOf(Send(gateway, seller, Add(10, Side::Sell, 100, 30))) == CommandStatus::Accepted, "the resting order is accepted");
+
+        // Bought above the resting price, both legs trade at the resting order's price.
+        std::uint64_t requestId{ };
+        const auto buyerResponses = Send(gateway, buyer, Add(20, Side::Buy, 105, 50), &requestId);
+        Check(buyerResponses.size() == 2 && StatusOf(buyerResponses) == CommandStatus::Accepted && buyerResponses[0].requestId_ == requestId,
+            "the aggressor gets its result first");
+        Check(buyerResponses.size() == 2 && buyerResponses[1].type_ == GatewayResponseType::Fill && buyerResponses[1].orderId_ == 20 &&
+            buyerResponses[1].requestId_ == requestId && buyerResponses[1].price_ == 100 && buyerResponses[1].quantity_ == 30,
+            "the aggressor's fill carries its request and the execution price");
+
+        std::vector<GatewayResponse> sellerResponses;
+        seller.PollResponses(sellerResponses);
+        Check(sellerResponses.size() == 1 && sellerResponses[0].type_ == GatewayResponseType::Fill && sellerResponses[0].orderId_ == 10 &&
+            sellerResponses[0].requestId_ == 0 && sellerResponses[0].price_ == 100 && sellerResponses[0].quantity_ == 30,
+            "the resting order's owner gets its fill, under no request");
+
+        // The filled order is no one's anymore, the rest of the aggressor still belongs to the buyer.
+        Check(StatusOf(Send(gateway, seller, Add(10, Side::Sell, 110, 5))) == CommandStatus::Accepted, "a filled order's ID can be used again");
+        Check(Resting(gateway, 20) && StatusOf(Send(gateway, seller, OrderCommand::Cancel(20))) == CommandStatus::NotFound,
+            "the rest of a partly filled order still belongs to its client");
+        Check(seller.GetLostResponses() == 0 && buyer.GetLostResponses() == 0, "no response was dropped");
+    }
+
+    void CancelOnDisconnect()
+    {
+        OrderGateway gateway{ Options() };
+        GatewayClient stays{ Options().name_ };
+        auto leaves = std::make_unique<GatewayClient>(Options().name_);
+
+        Check(StatusOf(Send(gateway, *leaves, Add(30, Side::Buy, 99, 10))) == CommandStatus::Accepted, "the leaving client's bid is accepted");
+        Check(StatusOf(Send(gateway, *leaves, Add(31, Side::Sell, 101, 10))) == CommandStatus::Accepted, "the leaving client's ask is accepted");
+        Check(StatusOf(Send(gateway, stays, Add(32, Side::Buy, 98, 10))) == CommandStatus::Accepted, "the staying client's bid is accepted");
+
+        // A request still queued when the client goes away is applied before its orders are cancelled.
+        Check(leaves->Submit(Symbol, Add(33, Side::Buy, 97, 10)), "a last request is queued");
+        leaves.reset();
+        gateway.Poll();
+
+        Check(gateway.GetClientCount() == 1, "the slot of the client that left is free");
+        Check(!Resting(gateway, 30) && !Resting(gateway, 31) && !Resting(gateway, 33), "the orders of the client that left are cancelled");
+        Check(Resting(gateway, 32), "the other client's orders stay");
+
+        GatewayClient joins{ Options().name_ };
+        Check(StatusOf(Send(gateway, joins, Add(30, Side::Buy, 99, 10))) == CommandStatus::Accepted, "the cancelled orders' IDs can be used again");
+        Check(StatusOf(Send(gateway, joins, OrderCommand::Cancel(32))) == CommandStatus::NotFound, "a new client in the slot owns none of the others' orders");
+    }
+
+    void SessionClose()
+    {
+        OrderGateway gateway{ Options() };
+        GatewayClient client{ Options().name_ };
+
+        Check(StatusOf(Send(gateway, client, Add(40, Side::Buy, 99, 10, OrderType::GoodForDay))) == CommandStatus::Accepted, "a GoodForDay order is accepted");
+        Check(StatusOf(Send(gateway, client, Add(41, Side::Buy, 98, 10))) == CommandStatus::Accepted, "a GoodTillCancel order is accepted");
+
+        gateway.OnSessionClose();
+        Check(Resting(gateway, 40), "the close only takes effect in the next Poll()");
+        gateway.Poll();
+
+        Check(!Resting(gateway, 40) && Resting(gateway, 41), "only the GoodForDay order expires");
+        Check(StatusOf(Send(gateway, client, Add(40, Side::Sell, 120, 10))) == CommandStatus::Accepted, "an expired order's ID can be used again");
+
+        gateway.Poll();
+        Check(Resting(gateway, 40), "the close is only applied once");
+    }
+}
+
+
+int main()
+{
+    Ownership();
+    FillsToBothLegs();
+    CancelOnDisconnect();
+    SessionClose();
+
+    return CheckResult("gateway");
+}
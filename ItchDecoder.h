@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <span>
+
+#include "Usings.h"
+#include "Side.h"
+
+// The order messages of a market-by-order feed, decoded into plain values. Prices are the feed's own integers.
+struct FeedAdd
+{
+    std::uint16_t stockLocate_;
+    std::uint64_t timestamp_;       // Nanoseconds since midnight.
+    OrderID orderId_;
+    Side side_;
+    Quantity quantity_;
+    Price price_;
+};
+
+struct FeedExecute
+{
+    std::uint16_t stockLocate_;
+    std::uint64_t timestamp_;
+    OrderID orderId_;
+    Quantity quantity_;
+    Price price_;                   // 0 when the execution happened at the order's own price.
+};
+
+struct FeedCancel
+{
+    std::uint16_t stockLocate_;
+    std::uint64_t timestamp_;
+    OrderID orderId_;
+    Quantity quantity_;             // The partial cancel: shares taken off, not shares left.
+};
+
+struct FeedDelete
+{
+    std::uint16_t stockLocate_;
+    std::uint64_t timestamp_;
+    OrderID orderId_;
+};
+
+// The original order is deleted and the new one takes its side with a new id, price and quantity (losing its priority).
+struct FeedReplace
+{
+    std::uint16_t stockLocate_;
+    std::uint64_t timestamp_;
+    OrderID orderId_;
+    OrderID newOrderId_;
+    Quantity quantity_;
+    Price price_;
+};
+
+/*
+** ItchDecoder reads the order messages of a NASDAQ TotalView-ITCH 5.0 stream: 'A'/'F' add, 'E'/'C' execute,
+   'X' cancel, 'D' delete and 'U' replace. Every message is preceded by its length as a 2-byte big-endian integer,
+   the framing of ITCH capture files and of the messages inside MoldUDP64 packets.
+** The fields are read in place from the caller's bytes (a MappedFile, a received packet or a slot of a RingBuffer)
+   and handed to the Handler by value, nothing is copied beforehand or allocated. Any other message type is skipped
+   by its length.
+** Decode() stops at the first message that isn't complete yet and returns the bytes it consumed, so a stream that
+   arrives in chunks is decoded by passing the unconsumed tail again together with the next chunk.
+** The Handler provides OnAdd(const FeedAdd&), OnExecute(const FeedExecute&), OnCancel(const FeedCancel&),
+   OnDelete(const FeedDelete&) and OnReplace(const FeedReplace&), see FeedBookBuilder.
+*/
+class ItchDecoder
+{
+public:
+    template<typename Handler>
+    std::size_t Decode(std::span<const std::byte> bytes, Handler& handler)
+    {
+        const auto data = reinterpret_cast<const unsigned char*>(bytes.data());
+        std::size_t offset{ };
+
+        while(bytes.size() - offset >= 2)
+        {
+            const auto length = static_cast<std::size_t>(ReadBigEndian<2>(data + offset));
+            if(bytes.size() - offset - 2 < length)
+                break;
+
+            const auto message = data + offset + 2;
+            offset += 2 + length;
+            ++messageCount_;
+
+            if(!DecodeMessage(message, length, handler))
+                ++skippedCount_;
+        }
+
+        return offset;
+    }
+
+    std::uint64_t GetMessageCount() const { return messageCount_; }
+    std::uint64_t GetSkippedCount() const { return skippedCount_; }
+
+private:
+    std::uint64_t messageCount_{ };
+    std::uint64_t skippedCount_{ };
+
+    // Every message starts with its type, the stock locate, a tracking number and a 6-byte timestamp.
+    static constexpr std::size_t HeaderSize = 11;
+
+    template<std::size_t Size>
+    static std::uint64_t ReadBigEndian(const unsigned char* data)
+    {
+        std::uint64_t value{ };
+        for(std::size_t byte = 0; byte < Size; ++byte)
+            value = value << 8 | data[byte];
+
+        return value;
+    }
+
+    static Price ReadPrice(const unsigned char* data) { return static_cast<Price>(ReadBigEndian<4>(data)); }
+    static Quantity ReadQuantity(const unsigned char* data) { return static_cast<Quantity>(ReadBigEndian<4>(data)); }
+
+    // Returns false for the message types the book doesn't need, and for messages too short for their type.
+    template<typename Handler>
+    static bool DecodeMessage(const unsigned char* message, std::size_t length, Handler& handler)
+    {
+        // The shortest order message is a delete, anything shorter is of another type.
+        if(length < 19)
+            return false;
+
+        const auto stockLocate = static_cast<std::uint16_t>(ReadBigEndian<2>(message + 1));
+        const auto timestamp = ReadBigEndian<6>(message + 5);
+        const auto orderId = static_cast<OrderID>(ReadBigEndian<8>(message + HeaderSize));
+
+        switch(message[0])
+        {
+        case 'A':       // Add order, 'F' carries the attribution of the participant as well.
+        case 'F':
+            if(length < 36)
+                return false;
+            handler.OnAdd(FeedAdd{ stockLocate, timestamp, orderId, message[19] == 'B' ? Side::Buy : Side::Sell,
+                ReadQuantity(message + 20), ReadPrice(message + 32) });
+            return true;
+        case 'E':       // Executed at the order's price.
+            if(length < 31)
+                return false;
+            handler.OnExecute(FeedExecute{ stockLocate, timestamp, orderId, ReadQuantity(message + 19), 0 });
+            return true;
+        case 'C':       // Executed at another price, e.g. in a cross.
+            if(length < 36)
+                return false;
+            handler.OnExecute(FeedExecute{ stockLocate, timestamp, orderId, ReadQuantity(message + 19), ReadPrice(message + 32) });
+            return true;
+        case 'X':
+            if(length < 23)
+                return false;
+            handler.OnCancel(FeedCancel{ stockLocate, timestamp, orderId, ReadQuantity(message + 19) });
+            return true;
+        case 'D':
+            handler.OnDelete(FeedDelete{ stockLocate, timestamp, orderId });
+            return true;
+        case 'U':
+            if(length < 35)
+                return false;
+            handler.OnReplace(FeedReplace{ stockLocate, timestamp, orderId, static_cast<OrderID>(ReadBigEndian<8>(message + 19)),
+                ReadQuantity(message + 27), ReadPrice(message + 31) });
+            return true;
+        default:
+            return false;
+        }
+    }
+};
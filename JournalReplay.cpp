@@ -0,0 +1,116 @@
+// Rebuilds an order book from a CommandJournal, optionally on top of a BookSnapshot, and reports how long it took with
+// a checksum of the trades, so that two replays (or a replay and the live session) can be compared for bit-identical output.
+//
+//     JournalReplay <journal> [--snapshot file] [--tick-size N] [--print-trades]
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "BookSnapshot.h"
+#include "CommandJournal.h"
+#include "Orderbook.h"
+
+namespace
+{
+    // FNV-1a over the fields of every trade, in trade order.
+    struct TradeChecksum
+    {
+        std::uint64_t value_{ 0xcbf29ce484222325 };
+
+        void Add(std::uint64_t field)
+        {
+            for(int byte = 0; byte < 8; ++byte, field >>= 8)
+                value_ = (value_ ^ (field & 0xff)) * 0x100000001b3;
+        }
+
+        void Add(const TradeInfo& trade)
+        {
+            Add(trade.orderid_);
+            Add(static_cast<std::uint32_t>(trade.price_));
+            Add(trade.quantity_);
+        }
+    };
+}
+
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cerr << "usage: JournalReplay <journal> [--snapshot file] [--tick-size N] [--print-trades]\n";
+        return 2;
+    }
+
+    OrderbookOptions options;
+    bool printTrades = false;
+    const char* snapshotPath = nullptr;
+    for(int arg = 2; arg < argc; ++arg)
+    {
+        if(std::strcmp(argv[arg], "--tick-size") == 0 && arg + 1 < argc)
+            options.tickSize_ = static_cast<Price>(std::atoi(argv[++arg]));
+        else if(std::strcmp(argv[arg], "--snapshot") == 0 && arg + 1 < argc)
+            snapshotPath = argv[++arg];
+        else if(std::strcmp(argv[arg], "--print-trades") == 0)
+            printTrades = true;
+    }
+
+    try
+    {
+        const JournalReader journal{ argv[1] };
+        const auto start = std::chrono::steady_clock::now();
+
+        // The snapshot already holds the effect of every command before its journal sequence, only the tail is replayed.
+        BookSnapshot snapshot;
+        if(snapshotPath)
+        {
+            snapshot = BookSnapshot::Load(snapshotPath);
+            options.tickSize_ = snapshot.tickSize_;
+        }
+
+        const auto tail = journal.RecordsFrom(snapshot.journalSequence_);
+        options.orderCapacity_ = snapshot.orders_.size() + tail.size();
+
+        Orderbook book{ options };
+        if(snapshotPath)
+            book.RestoreSnapshot(snapshot);
+
+        BatchResult result;
+        TradeChecksum checksum;
+        std::uint64_t tradeCount{ };
+        const auto replayed = journal.Replay(book, result, [&](std::span<const JournalRecord> records, const BatchResult& batch)
+        {
+            for(const auto& commandResult : batch.results_)
+            {
+                for(auto index = commandResult.firstTrade_; index < commandResult.firstTrade_ + commandResult.tradeCount_; ++index)
+                {
+                    const auto& trade = batch.trades_[index];
+                    checksum.Add(trade.GetBidTrade());
+                    checksum.Add(trade.GetAskTrade());
+
+                    if(printTrades)
+                        std::cout << records[&commandResult - batch.results_.data()].sequence_ << ' '
+                            << trade.GetBidTrade().orderid_ << ' ' << trade.GetAskTrade().orderid_ << ' '
+                            << trade.GetBidTrade().price_ << ' ' << trade.GetAskTrade().price_ << ' '
+                            << trade.GetBidTrade().quantity_ << '\n';
+                }
+
+                tradeCount += commandResult.tradeCount_;
+            }
+        }, snapshot.journalSequence_);
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cerr << "restored " << snapshot.orders_.size() << " orders and replayed " << replayed << " commands in " << elapsed << "s (" << (elapsed > 0 ? replayed / elapsed : 0.0) << "/s), "
+            << tradeCount << " trades, " << book.Size() << " resting orders, trade checksum " << std::hex << checksum.value_ << '\n';
+    }
+    catch(const std::exception& exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <limits>
+
+/*
+** SingleWriterCounter is a counter with exactly one writing thread at a time and any number of readers.
+** The writer updates it with a plain load and store instead of an atomic read-modify-write, so it costs
+   the same as an ordinary integer, while readers on other threads still see whole, untorn values.
+*/
+class SingleWriterCounter
+{
+public:
+    SingleWriterCounter(std::uint64_t value = 0) : value_{ value } { }
+    SingleWriterCounter(const SingleWriterCounter& other) : value_{ other.Load() } { }
+    SingleWriterCounter& operator=(const SingleWriterCounter& other) { return *this = other.Load(); }
+
+    SingleWriterCounter& operator=(std::uint64_t value) { value_.store(value, std::memory_order_relaxed); return *this; }
+    SingleWriterCounter& operator+=(std::uint64_t value) { return *this = Load() + value; }
+    SingleWriterCounter& operator++() { return *this += 1; }
+
+    operator std::uint64_t() const { return Load(); }
+    std::uint64_t Load() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::uint64_t> value_;
+};
+
+/*
+** LatencyHistogram counts values (nanoseconds, cycles...) in log-linear buckets, the way an HDR histogram does.
+** Values below 2^LinearBits get a bucket each, above that every power of two is split into 2^(LinearBits - 1)
+   buckets. With the default of 8 any value is recorded with less than 1% error, and the whole 64-bit range fits
+   in a fixed array: Record() never allocates and only costs a bit scan, so it is cheap enough for the hot path.
+** The counters are plain integers by default. BasicLatencyHistogram<SingleWriterCounter> is the same histogram
+   for one writing thread that other threads read while it is being written, see BookMetrics.
+** Percentiles are reported as the highest value of their bucket, so they never understate the latency.
+*/
+template<typename Counter = std::uint64_t, int LinearBits = 8>
+class BasicLatencyHistogram
+{
+public:
+    void Record(std::uint64_t value)
+    {
+        ++counts_[IndexOf(value)];
+        ++count_;
+        sum_ += value;
+        if(value < min_)
+            min_ = value;
+        if(value > max_)
+            max_ = value;
+    }
+
+    std::uint64_t Count() const { return count_; }
+    std::uint64_t Min() const { return count_ == 0 ? 0 : static_cast<std::uint64_t>(min_); }
+    std::uint64_t Max() const { return max_; }
+    double Mean() const { return count_ == 0 ? 0.0 : static_cast<double>(sum_) / static_cast<double>(count_); }
+
+    // 'percentile' goes from 0 to 100, e.g. 99.9. The result is clamped to the largest value actually recorded.
+    std::uint64_t ValueAtPercentile(double percentile) const
+    {
+        if(count_ == 0)
+            return 0;
+
+        const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(percentile / 100.0 * static_cast<double>(count_) + 0.5));
+        std::uint64_t seen{ };
+        for(std::size_t index = 0; index < counts_.size(); ++index)
+        {
+            seen += counts_[index];
+            if(seen >= rank)
+                return std::min<std::uint64_t>(HighestValueAt(index), max_);
+        }
+
+        return max_;
+    }
+
+    // Adds the counts of another histogram with the same buckets, whatever its counters are.
+    template<typename OtherCounter>
+    void Merge(const BasicLatencyHistogram<OtherCounter, LinearBits>& other)
+    {
+        for(std::size_t index = 0; index < counts_.size(); ++index)
+            counts_[index] += static_cast<std::uint64_t>(other.counts_[index]);
+
+        count_ += static_cast<std::uint64_t>(other.count_);
+        sum_ += static_cast<std::uint64_t>(other.sum_);
+        if(static_cast<std::uint64_t>(other.min_) < min_)
+            min_ = static_cast<std::uint64_t>(other.min_);
+        if(static_cast<std::uint64_t>(other.max_) > max_)
+            max_ = static_cast<std::uint64_t>(other.max_);
+    }
+
+    void Reset() { *this = BasicLatencyHistogram{ }; }
+
+private:
+    template<typename, int>
+    friend class BasicLatencyHistogram;
+
+    static constexpr std::uint64_t LinearCount = std::uint64_t{ 1 } << LinearBits;
+    static constexpr std::uint64_t SubBucketCount = LinearCount / 2;        // Buckets per power of two above the linear range.
+    static constexpr std::size_t BucketCount = LinearCount + (64 - LinearBits) * SubBucketCount;
+
+    std::array<Counter, BucketCount> counts_{ };
+    Counter count_{ };
+    Counter sum_{ };
+    Counter min_{ std::numeric_limits<std::uint64_t>::max() };
+    Counter max_{ };
+
+    static std::size_t IndexOf(std::uint64_t value)
+    {
+        if(value < LinearCount)
+            return static_cast<std::size_t>(value);
+
+        // The top LinearBits bits of the value pick the bucket within its power of two, the rest is dropped.
+        const auto shift = static_cast<std::uint64_t>(std::bit_width(value) - LinearBits);
+        return static_cast<std::size_t>(LinearCount + (shift - 1) * SubBucketCount + ((value >> shift) - SubBucketCount));
+    }
+
+    static std::uint64_t HighestValueAt(std::size_t index)
+    {
+        if(index < LinearCount)
+            return index;
+
+        const auto shift = (index - LinearCount) / SubBucketCount + 1;
+        const auto top = (index - LinearCount) % SubBucketCount + SubBucketCount;
+        return ((top + 1) << shift) - 1;
+    }
+};
+
+using LatencyHistogram = BasicLatencyHistogram<>;
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <bit>
+#include <algorithm>
+
+/*
+** LevelBitmap keeps one bit per price level telling us whether that level currently has resting orders.
+** The bits are stored in layers: layer 0 holds the actual level bits and every word of layer N+1 summarises
+   64 words of layer N (bit set --> that word has at least one level occupied).
+** This lets us find the next occupied level with a handful of find-first-set instructions instead of
+   walking over every empty price between two levels.
+*/
+class LevelBitmap
+{
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    void Resize(std::size_t bits)
+    {
+        // Resizing always clears the bitmap, the PriceLadder re-populates it after moving its levels.
+        layers_.clear();
+        size_ = bits;
+
+        std::size_t words = (bits + 63) / 64;
+        do
+        {
+            words = words == 0 ? 1 : words;
+            layers_.emplace_back(words, 0);
+            words = (words + 63) / 64;
+        } while(layers_.back().size() > 1);
+    }
+
+    std::size_t Size() const { return size_; }
+
+    std::size_t MemoryUsage() const
+    {
+        std::size_t bytes = layers_.capacity() * sizeof(layers_[0]);
+        for(const auto& layer : layers_)
+            bytes += layer.capacity() * sizeof(std::uint64_t);
+
+        return bytes;
+    }
+    bool Empty() const { return layers_.empty() || layers_.back()[0] == 0; }
+
+    bool Test(std::size_t index) const
+    {
+        return (layers_[0][index / 64] >> (index % 64)) & 1;
+    }
+
+    void Set(std::size_t index)
+    {
+        for(auto& layer : layers_)
+        {
+            auto& word = layer[index / 64];
+            const bool wasEmpty = word == 0;
+            word |= Bit(index % 64);
+
+            // If the word already had a bit set then every layer above already knows about it.
+            if(!wasEmpty)
+                return;
+
+            index /= 64;
+        }
+    }
+
+    void Clear(std::size_t index)
+    {
+        for(auto& layer : layers_)
+        {
+            auto& word = layer[index / 64];
+            word &= ~Bit(index % 64);
+
+            // Only when the whole word becomes empty do we need to clear the summary bit above it.
+            if(word != 0)
+                return;
+
+            index /= 64;
+        }
+    }
+
+    std::size_t FindFirst() const { return FindNext(0); }
+    std::size_t FindLast() const { return size_ == 0 ? npos : FindPrev(size_ - 1); }
+
+    // Returns the first set bit at or after 'index' (npos if there is none).
+    std::size_t FindNext(std::size_t index) const
+    {
+        return index >= size_ ? npos : FindNextAt(0, index);
+    }
+
+    // Returns the last set bit at or before 'index' (npos if there is none).
+    std::size_t FindPrev(std::size_t index) const
+    {
+        return index == npos || size_ == 0 ? npos : FindPrevAt(0, std::min(index, size_ - 1));
+    }
+
+private:
+    std::vector<std::vector<std::uint64_t>> layers_;
+    std::size_t size_{ };
+
+    static constexpr std::uint64_t Bit(std::size_t bit) { return std::uint64_t{ 1 } << bit; }
+
+    std::size_t FindNextAt(std::size_t layer, std::size_t index) const
+    {
+        const auto& words = layers_[layer];
+        auto wordIndex = index / 64;
+        if(wordIndex >= words.size())
+            return npos;
+
+        auto word = words[wordIndex] & (~std::uint64_t{ 0 } << (index % 64));
+        if(word == 0)
+        {
+            // Nothing left in this word, ask the layer above which word is the next non-empty one.
+            if(layer + 1 == layers_.size())
+                return npos;
+
+            wordIndex = FindNextAt(layer + 1, wordIndex + 1);
+            if(wordIndex == npos)
+                return npos;
+
+            word = words[wordIndex];
+        }
+
+        return wordIndex * 64 + std::countr_zero(word);
+    }
+
+    std::size_t FindPrevAt(std::size_t layer, std::size_t index) const
+    {
+        const auto& words = layers_[layer];
+        auto wordIndex = index / 64;
+
+        auto word = words[wordIndex] & (~std::uint64_t{ 0 } >> (63 - index % 64));
+        if(word == 0)
+        {
+            if(layer + 1 == layers_.size() || wordIndex == 0)
+                return npos;
+
+            wordIndex = FindPrevAt(layer + 1, wordIndex - 1);
+            if(wordIndex == npos)
+                return npos;
+
+            word = words[wordIndex];
+        }
+
+        return wordIndex * 64 + 63 - std::countl_zero(word);
+    }
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "Usings.h"
+#include "OrderPool.h"
+#include "QuantityKernels.h"
+
+/*
+** LevelQueue is the FIFO queue of one price level, stored as a structure of arrays: the handles of the orders in
+   queue order, and their remaining quantities in a parallel array. A sweep reads the quantities contiguously
+   (see CountFilled) instead of following a link per order through the pool.
+** Every order keeps its position in the queue (OrderPool::GetQueuePosition), so a cancel is O(1): the entry becomes
+   a hole (InvalidOrderHandle and a quantity of 0) that scans step over for free. Holes at the front are dropped at
+   once, the others when the arrays are full, by moving the live entries to the front (Compact).
+** Clear() keeps the capacity of the arrays, so a price level that empties and fills up again doesn't allocate.
+*/
+class LevelQueue
+{
+public:
+    using Position = std::uint32_t;
+
+    bool Empty() const { return live_ == 0; }
+    std::size_t Size() const { return live_; }
+
+    // From the front of the queue on, holes included. The first entry is always an order unless the queue is empty.
+    std::span<const OrderHandle> Handles() const { return { handles_.data() + head_, handles_.size() - head_ }; }
+    std::span<const Quantity> Quantities() const { return { quantities_.data() + head_, quantities_.size() - head_ }; }
+
+    OrderHandle Front() const { return handles_[head_]; }
+    Position FrontPosition() const { return head_; }
+
+    // Appends an order and returns its position. Making room may move other orders, each is then reported
+    // through relocate(handle, newPosition).
+    template<typename Relocate>
+    Position PushBack(OrderHandle handle, Quantity quantity, Relocate&& relocate)
+    {
+        if(live_ == 0)
+            Clear();
+        else if(handles_.size() == handles_.capacity() && handles_.size() >= 2 * live_)
+            Compact(relocate);
+
+        handles_.push_back(handle);
+        quantities_.push_back(quantity);
+        ++live_;
+        return static_cast<Position>(handles_.size() - 1);
+    }
+
+    // Whether the next PushBack() gets a position no higher than 'maxPosition', compacting the queue when dropping its
+    // holes is what makes room. Moved orders are reported like in PushBack(). Nothing changes if it returns false.
+    template<typename Relocate>
+    bool MakeRoom(Position maxPosition, Relocate&& relocate)
+    {
+        if(live_ == 0 || handles_.size() <= maxPosition)
+            return true;
+
+        if(live_ > maxPosition)
+            return false;
+
+        Compact(relocate);
+        return true;
+    }
+
+    void SetQuantity(Position position, Quantity quantity) { quantities_[position] = quantity; }
+
+    // Removes the order at 'position'. The arrays aren't moved, so spans from Handles()/Quantities() stay valid.
+    void Erase(Position position)
+    {
+        handles_[position] = InvalidOrderHandle;
+        quantities_[position] = 0;
+        --live_;
+
+        if(position == head_)
+        {
+            while(head_ < handles_.size() && handles_[head_] == InvalidOrderHandle)
+                ++head_;
+        }
+    }
+
+    // The bytes of the arrays, which a cleared queue keeps.
+    std::size_t MemoryUsage() const { return handles_.capacity() * sizeof(OrderHandle) + quantities_.capacity() * sizeof(Quantity); }
+
+    void Clear()
+    {
+        handles_.clear();
+        quantities_.clear();
+        head_ = 0;
+        live_ = 0;
+    }
+
+private:
+    std::vector<OrderHandle> handles_;
+    std::vector<Quantity> quantities_;
+    Position head_{ };
+    std::size_t live_{ };
+
+    template<typename Relocate>
+    void Compact(Relocate& relocate)
+    {
+        std::size_t next{ };
+        for(auto index = static_cast<std::size_t>(head_); index < handles_.size(); ++index)
+        {
+            if(handles_[index] == InvalidOrderHandle)
+                continue;
+
+            handles_[next] = handles_[index];
+            quantities_[next] = quantities_[index];
+            relocate(handles_[next], static_cast<Position>(next));
+            ++next;
+        }
+
+        handles_.resize(next);
+        quantities_.resize(next);
+        head_ = 0;
+    }
+};
@@ -0,0 +1,86 @@
+#include "MappedFile.h"
+
+#include <format>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path)
+{
+#if defined(_WIN32)
+    const auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error(std::format("File ({}) cannot be opened.", path));
+
+    LARGE_INTEGER size{ };
+    GetFileSizeEx(file, &size);
+    size_ = static_cast<std::size_t>(size.QuadPart);
+
+    // An empty file can't be mapped, it simply has no bytes.
+    if(size_ != 0)
+    {
+        const auto mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        mapping_ = mappingHandle ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if(!mapping_)
+        {
+            if(mappingHandle)
+                CloseHandle(mappingHandle);
+            CloseHandle(file);
+            throw std::runtime_error(std::format("File ({}) cannot be mapped.", path));
+        }
+        mappingHandle_ = reinterpret_cast<std::intptr_t>(mappingHandle);
+    }
+
+    // The mapping stays valid once the file is closed.
+    CloseHandle(file);
+#else
+    const auto file = ::open(path.c_str(), O_RDONLY);
+    if(file < 0)
+        throw std::runtime_error(std::format("File ({}) cannot be opened.", path));
+
+    struct stat status{ };
+    ::fstat(file, &status);
+    size_ = static_cast<std::size_t>(status.st_size);
+
+    // An empty file can't be mapped, it simply has no bytes.
+    if(size_ != 0)
+    {
+        int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+        flags |= MAP_POPULATE;      // Fault the whole file in up front, reading it then runs from memory.
+#endif
+        mapping_ = ::mmap(nullptr, size_, PROT_READ, flags, file, 0);
+        if(mapping_ == MAP_FAILED)
+        {
+            mapping_ = nullptr;
+            ::close(file);
+            throw std::runtime_error(std::format("File ({}) cannot be mapped.", path));
+        }
+        ::madvise(mapping_, size_, MADV_SEQUENTIAL);
+    }
+
+    // The mapping stays valid once the file is closed.
+    ::close(file);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    if(!mapping_)
+        return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(mapping_);
+    CloseHandle(reinterpret_cast<HANDLE>(mappingHandle_));
+#else
+    ::munmap(mapping_, size_);
+#endif
+}
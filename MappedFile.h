@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+/*
+** MappedFile maps a whole file read-only into memory, its bytes are then read in place without being copied.
+** The pages are faulted in up front and read sequentially, which is how journals and feed captures are replayed.
+*/
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    void operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    void operator=(MappedFile&&) = delete;
+    ~MappedFile();
+
+    std::span<const std::byte> Bytes() const { return { static_cast<const std::byte*>(mapping_), size_ }; }
+
+private:
+    void* mapping_{ nullptr };
+    std::size_t size_{ };
+    std::intptr_t mappingHandle_{ };
+};
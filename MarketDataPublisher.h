@@ -0,0 +1,184 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+
+#include "Usings.h"
+#include "Side.h"
+#include "LevelInfo.h"
+
+enum class L2Action
+{
+    Added,
+    Changed,
+    Removed,
+};
+
+// One change of one price level. Applying the updates in sequence order to a copy of the book keeps it in sync.
+struct L2Update
+{
+    std::uint64_t sequence_{ };
+    Side side_{ Side::Buy };
+    L2Action action_{ L2Action::Changed };
+    Price price_{ };
+    Quantity quantity_{ };
+    Quantity count_{ };
+};
+
+// The best 'depth' levels of each side, best price first. 'sequence_' is the last L2Update included in it.
+struct DepthSnapshot
+{
+    static constexpr std::size_t MaxDepth = 32;
+
+    std::uint64_t sequence_{ };
+    std::array<LevelInfo, MaxDepth> bids_{ };
+    std::array<LevelInfo, MaxDepth> asks_{ };
+    std::size_t bidCount_{ };
+    std::size_t askCount_{ };
+};
+
+// Lives inside every price level, it remembers where the level's not yet published L2Update is (conflation mode).
+struct L2PendingSlot
+{
+    std::uint32_t index_{ };
+    std::uint32_t generation_{ };   // Only valid while it matches the publisher's generation, which moves on with every drain.
+};
+
+/*
+** MarketDataPublisher turns the level changes of the Orderbook into market data, incrementally:
+** - A sequence numbered stream of L2Updates (level added / changed / removed), kept until DrainUpdates() is called.
+   In conflation mode all the changes a level goes through between two drains are merged into a single update,
+   which keeps the place of the level's first change but the sequence number of its last one. A level that is added
+   and removed again between two drains is never published.
+** - A cached DepthSnapshot of the top levels. It is only rebuilt when a change touches those levels, and reading it
+   is a copy of a fixed size structure no matter how deep the book is.
+*/
+class MarketDataPublisher
+{
+public:
+    MarketDataPublisher(std::size_t depth, bool publishUpdates, bool conflate)
+        : depth_{ std::min(depth, DepthSnapshot::MaxDepth) }
+        , publishUpdates_{ publishUpdates }
+        , conflate_{ conflate }
+    { }
+
+    void OnLevelChanged(Side side, Price price, Quantity quantity, Quantity count, L2Action action, L2PendingSlot& slot)
+    {
+        ++sequence_;
+
+        if(AffectsDepth(side, price))
+            (side == Side::Buy ? bidsDirty_ : asksDirty_) = true;
+
+        if(!publishUpdates_)
+            return;
+
+        const L2Update update{ sequence_, side, action, price, quantity, count };
+
+        if(conflate_ && slot.generation_ == generation_ && slot.index_ < updates_.size())
+        {
+            // Merge into the update already waiting for this level. A level that was added since the last
+            // drain is still 'Added' for the consumer, and if it is gone again the consumer needn't hear of it.
+            auto& pending = updates_[slot.index_];
+            if(pending.sequence_ == DroppedSequence)
+            {
+                --droppedCount_;
+                pending = update;
+                return;
+            }
+
+            const auto previousAction = pending.action_;
+            if(previousAction == L2Action::Added && action == L2Action::Removed)
+            {
+                pending.sequence_ = DroppedSequence;
+                ++droppedCount_;
+                return;
+            }
+
+            pending = update;
+            if(previousAction == L2Action::Added)
+                pending.action_ = L2Action::Added;
+            return;
+        }
+
+        if(conflate_)
+            slot = L2PendingSlot{ static_cast<std::uint32_t>(updates_.size()), generation_ };
+
+        updates_.push_back(update);
+    }
+
+    // Rebuilds the cached depth of the sides that were touched, walking at most 'depth' levels of each.
+    template<typename BidLadder, typename AskLadder>
+    void RefreshDepth(const BidLadder& bids, const AskLadder& asks)
+    {
+        if(bidsDirty_)
+            Rebuild(bids, snapshot_.bids_, snapshot_.bidCount_);
+
+        if(asksDirty_)
+            Rebuild(asks, snapshot_.asks_, snapshot_.askCount_);
+
+        bidsDirty_ = asksDirty_ = false;
+        snapshot_.sequence_ = sequence_;
+    }
+
+    // Appends every pending update to 'updates' and starts a new conflation window.
+    std::size_t DrainUpdates(std::vector<L2Update>& updates)
+    {
+        const auto count = updates_.size() - droppedCount_;
+        if(droppedCount_ == 0)
+            updates.insert(updates.end(), updates_.begin(), updates_.end());
+        else
+            std::copy_if(updates_.begin(), updates_.end(), std::back_inserter(updates),
+                [](const L2Update& update) { return update.sequence_ != DroppedSequence; });
+
+        updates_.clear();
+        droppedCount_ = 0;
+        ++generation_;
+        return count;
+    }
+
+    const DepthSnapshot& GetDepth() const { return snapshot_; }
+    std::uint64_t GetSequence() const { return sequence_; }
+
+private:
+    // Marks a pending update that conflated away to nothing. Real sequence numbers start at 1.
+    static constexpr std::uint64_t DroppedSequence = 0;
+
+    std::size_t depth_;
+    bool publishUpdates_;
+    bool conflate_;
+
+    std::uint64_t sequence_{ };
+    std::uint32_t generation_{ 1 };
+    std::vector<L2Update> updates_;
+    std::size_t droppedCount_{ };
+
+    DepthSnapshot snapshot_;
+    bool bidsDirty_{ false };
+    bool asksDirty_{ false };
+
+    // A change can only alter the cached depth if that side isn't full yet or the price is at or better than its last level.
+    bool AffectsDepth(Side side, Price price) const
+    {
+        const auto count = side == Side::Buy ? snapshot_.bidCount_ : snapshot_.askCount_;
+        if(depth_ == 0)
+            return false;
+
+        if(count < depth_)
+            return true;
+
+        const auto last = side == Side::Buy ? snapshot_.bids_[count - 1].price : snapshot_.asks_[count - 1].price;
+        return side == Side::Buy ? price >= last : price <= last;
+    }
+
+    template<typename Ladder>
+    void Rebuild(const Ladder& ladder, std::array<LevelInfo, DepthSnapshot::MaxDepth>& levels, std::size_t& count)
+    {
+        count = 0;
+        for(auto index = ladder.Best(); index != ladder.npos && count < depth_; index = ladder.NextWorse(index))
+            levels[count++] = LevelInfo{ ladder.PriceAt(index), ladder.LevelAt(index).data_.quantity_ };
+    }
+};
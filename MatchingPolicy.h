@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "Usings.h"
+#include "LevelQueue.h"
+#include "QuantityKernels.h"
+
+/*
+** A matching policy decides how an incoming order's quantity is shared out over the resting orders of the
+   price level it trades against. The Orderbook takes it as a template parameter (see BasicOrderbook), so a
+   venue picks its algorithm when it builds its books and the choice costs no dispatch at all.
+** Every policy provides
+       template<typename Fill>
+       static Quantity Allocate(const LevelQueue& orders, Quantity levelQuantity, Quantity quantity, Fill&& fill);
+   which fills up to 'quantity' from 'orders', whose remaining quantities add up to 'levelQuantity', by calling
+   fill(handle, quantity) for every allocation, and returns the quantity it allocated. It never allocates more
+   than an order's remaining quantity. 'fill' keeps the queue's quantities up to date and may erase the order it
+   was given (once it is filled), so the policies step over the holes that leaves (InvalidOrderHandle, quantity 0).
+** The policies only read the queue's contiguous quantities to decide, the orders themselves aren't touched.
+** Allocations are deterministic: the same book and the same order always produce the same fills, so a journal
+   replays into the same trades whatever the policy.
+*/
+
+// Price-time priority: the oldest order at the price is filled first, completely, before the next one is touched.
+struct FifoMatching
+{
+    template<typename Fill>
+    static Quantity Allocate(const LevelQueue& orders, Quantity, Quantity quantity, Fill&& fill)
+    {
+        const auto handles = orders.Handles();
+        const auto quantities = orders.Quantities();
+
+        // The orders filled completely are found with one prefix scan, then filled without looking at them again.
+        Quantity allocated{ };
+        const auto filled = CountFilled(quantities.data(), quantities.size(), quantity, allocated);
+        for(std::size_t index = 0; index < filled; ++index)
+        {
+            if(handles[index] != InvalidOrderHandle)
+                fill(handles[index], quantities[index]);
+        }
+
+        // The scan stops at an order too big for what is left, which takes the rest (holes never stop it).
+        if(filled < quantities.size() && allocated < quantity)
+        {
+            fill(handles[filled], quantity - allocated);
+            return quantity;
+        }
+
+        return allocated;
+    }
+};
+
+/*
+** Pro-rata: every resting order gets the share of the incoming quantity its size is of the level, rounded down.
+   What the rounding leaves over is then filled in queue order. An order that takes the whole level fills everyone.
+** Used by futures venues where queue position matters less than size, see e.g. CME's allocation algorithms.
+*/
+struct ProRataMatching
+{
+    template<typename Fill>
+    static Quantity Allocate(const LevelQueue& orders, Quantity levelQuantity, Quantity quantity, Fill&& fill)
+    {
+        if(quantity >= levelQuantity)
+            return FifoMatching::Allocate(orders, levelQuantity, quantity, fill);
+
+        // With less than the level to share out, no share can fill its order completely.
+        const auto handles = orders.Handles();
+        const auto quantities = orders.Quantities();
+
+        Quantity allocated{ };
+        for(std::size_t index = 0; index < quantities.size(); ++index)
+        {
+            const auto share = static_cast<Quantity>(std::uint64_t{ quantities[index] } * quantity / levelQuantity);
+            if(share != 0)
+            {
+                allocated += share;
+                fill(handles[index], share);
+            }
+        }
+
+        return allocated + FifoMatching::Allocate(orders, levelQuantity - allocated, quantity - allocated, fill);
+    }
+};
+
+// The order at the head of the queue, the first to rest at the price, is filled first. The rest is shared out pro-rata.
+struct TopOrderProRataMatching
+{
+    template<typename Fill>
+    static Quantity Allocate(const LevelQueue& orders, Quantity levelQuantity, Quantity quantity, Fill&& fill)
+    {
+        if(orders.Empty() || quantity == 0)
+            return 0;
+
+        const auto top = std::min(orders.Quantities()[0], quantity);
+        fill(orders.Front(), top);
+        return top + ProRataMatching::Allocate(orders, levelQuantity - top, quantity - top, fill);
+    }
+};
@@ -0,0 +1,122 @@
+// Four sell orders of 10, 20, 30 and 40 rest at one price, then a buy order takes 35, 100 or 130 of them, or takes
+// from the level after some of the four were cancelled. The trades returned by AddOrder are compared, fill by fill,
+// with what FIFO, pro-rata and top order pro-rata allocate, and whatever wasn't filled must still rest in the book.
+//
+//     MatchingPolicyTest
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#include "Orderbook.h"
+#include "TestCheck.h"
+
+namespace
+{
+    // The resting sell orders 1 to 4 of 10, 20, 30 and 40, all at this price, bought by order 100.
+    constexpr Price LevelPrice = 100;
+    constexpr OrderID Aggressor = 100;
+    constexpr Quantity RestingQuantity(OrderID orderId) { return static_cast<Quantity>(orderId * 10); }
+
+    // The resting order and quantity of every trade, in the order the trades were made.
+    using Fills = std::vector<std::pair<OrderID, Quantity>>;
+
+    template<typename Book>
+    void ExpectFills(const char* what, std::initializer_list<OrderID> cancels, Quantity quantity, const Fills& expected)
+    {
+        Book book;
+        for(OrderID orderId = 1; orderId <= 4; ++orderId)
+            book.AddOrder(Order{ OrderType::GoodTillCancel, orderId, Side::Sell, LevelPrice, RestingQuantity(orderId) });
+        for(const auto orderId : cancels)
+            book.CancelOrder(orderId);
+
+        Fills fills;
+        bool aggressorSide = true;
+        for(const auto& trade : book.AddOrder(Order{ OrderType::GoodTillCancel, Aggressor, Side::Buy, LevelPrice, quantity }))
+        {
+            fills.emplace_back(trade.GetAskTrade().orderid_, trade.GetAskTrade().quantity_);
+            aggressorSide = aggressorSide && trade.GetBidTrade().orderid_ == Aggressor && trade.GetAskTrade().price_ == LevelPrice;
+        }
+        Check(fills == expected, what);
+        Check(aggressorSide, "every trade is between the aggressor and the level");
+
+        // Every resting order keeps what wasn't allocated to it, and is gone once it has nothing left.
+        Quantity restingLeft{ };
+        std::size_t restingOrders{ };
+        Quantity filled{ };
+        bool ordersLeft = true;
+        for(OrderID orderId = 1; orderId <= 4; ++orderId)
+        {
+            Quantity left = std::count(cancels.begin(), cancels.end(), orderId) != 0 ? 0 : RestingQuantity(orderId);
+            for(const auto& [filledId, filledQuantity] : expected)
+            {
+                if(filledId == orderId)
+                {
+                    left -= filledQuantity;
+                    filled += filledQuantity;
+                }
+            }
+
+            const auto handle = book.FindOrder(orderId);
+            ordersLeft = ordersLeft && (left == 0 ? handle == InvalidOrderHandle : handle != InvalidOrderHandle && book.GetOrder(handle).GetRemainingQuantity() == left);
+            restingLeft += left;
+            restingOrders += left != 0 ? 1 : 0;
+        }
+        Check(ordersLeft, "the resting orders keep what wasn't allocated to them");
+
+        // The level aggregates agree with the orders, and the aggressor rests with what it couldn't fill.
+        const auto infos = book.GetOrderInfos();
+        Check(restingLeft == 0 ? infos.GetAsks().empty() : infos.GetAsks().size() == 1 && infos.GetAsks()[0].quantity_ == restingLeft,
+            "the level holds what its orders have left");
+        Check(quantity == filled ? infos.GetBids().empty() : infos.GetBids().size() == 1 && infos.GetBids()[0].quantity_ == quantity - filled,
+            "the aggressor rests with what it didn't fill");
+        Check(book.Size() == restingOrders + (quantity != filled ? 1 : 0), "the book counts the orders left");
+    }
+
+    void Fifo()
+    {
+        const Fills wholeLevel{ { 1, 10 }, { 2, 20 }, { 3, 30 }, { 4, 40 } };
+        ExpectFills<Orderbook>("fifo: below the level fills in queue order", { }, 35, { { 1, 10 }, { 2, 20 }, { 3, 5 } });
+        ExpectFills<Orderbook>("fifo: the level's quantity fills everyone", { }, 100, wholeLevel);
+        ExpectFills<Orderbook>("fifo: above the level fills everyone", { }, 130, wholeLevel);
+        ExpectFills<Orderbook>("fifo: holes are stepped over", { 2 }, 45, { { 1, 10 }, { 3, 30 }, { 4, 5 } });
+    }
+
+    void ProRata()
+    {
+        // Shares of 35/100 round down to 3, 7, 10 and 14, the 1 left over goes to the head of the queue.
+        const Fills wholeLevel{ { 1, 10 }, { 2, 20 }, { 3, 30 }, { 4, 40 } };
+        ExpectFills<ProRataOrderbook>("pro-rata: below the level shares by size", { }, 35, { { 1, 3 }, { 2, 7 }, { 3, 10 }, { 4, 14 }, { 1, 1 } });
+        ExpectFills<ProRataOrderbook>("pro-rata: the level's quantity fills everyone", { }, 100, wholeLevel);
+        ExpectFills<ProRataOrderbook>("pro-rata: above the level fills everyone", { }, 130, wholeLevel);
+
+        // Shares of 45/80 round down to 5, 16 and 22, the hole gets nothing and the 2 left over go to the head.
+        ExpectFills<ProRataOrderbook>("pro-rata: a hole gets no share", { 2 }, 45, { { 1, 5 }, { 3, 16 }, { 4, 22 }, { 1, 2 } });
+        ExpectFills<ProRataOrderbook>("pro-rata: exact shares past a cancelled head", { 1, 3 }, 30, { { 2, 10 }, { 4, 20 } });
+    }
+
+    void TopOrderProRata()
+    {
+        // The head takes its 10, then 25/90 of the others rounds down to 5, 8 and 11 and the 1 left over goes to the new head.
+        const Fills wholeLevel{ { 1, 10 }, { 2, 20 }, { 3, 30 }, { 4, 40 } };
+        ExpectFills<TopOrderProRataOrderbook>("top order: below the level", { }, 35, { { 1, 10 }, { 2, 5 }, { 3, 8 }, { 4, 11 }, { 2, 1 } });
+        ExpectFills<TopOrderProRataOrderbook>("top order: less than the top order", { }, 5, { { 1, 5 } });
+        ExpectFills<TopOrderProRataOrderbook>("top order: the level's quantity fills everyone", { }, 100, wholeLevel);
+        ExpectFills<TopOrderProRataOrderbook>("top order: above the level fills everyone", { }, 130, wholeLevel);
+
+        // Once the head is filled the queue starts past the hole, 35/70 of 30 and 40 are exact.
+        ExpectFills<TopOrderProRataOrderbook>("top order: the rest is shared past a hole", { 2 }, 45, { { 1, 10 }, { 3, 15 }, { 4, 20 } });
+    }
+}
+
+
+int main()
+{
+    Fifo();
+    ProRata();
+    TopOrderProRata();
+
+    return CheckResult("matching policy");
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <list>
+#include <memory>
 #include <exception>
 #include <format>
 
@@ -13,18 +14,19 @@
 class Order
 {
 public:
-    Order(OrderType orderType, OrderID orderid, Side side, Price price, Quantity quantity)
+    Order(OrderType orderType, OrderID orderid, Side side, Price price, Quantity quantity, AccountID accountId = NoAccount)
         : orderType_{ orderType }
         , orderId_{ orderid }
         , side_{ side }
         , price_{ price }
         , initialQuantity_{ quantity }
         , remainingQuantity_{ quantity }
+        , accountId_{ accountId }
         { }
 
 
-        Order(OrderID orderId, Side side, Quantity quantity)
-            :Order(OrderType::Market, orderId, side, Constants::InvalidPrice, quantity)
+        Order(OrderID orderId, Side side, Quantity quantity, AccountID accountId = NoAccount)
+            :Order(OrderType::Market, orderId, side, Constants::InvalidPrice, quantity, accountId)
         { }
 
         OrderType GetOrderType() const{ return orderType_; };
@@ -33,6 +35,7 @@ public:
         Price GetPrice() const{ return price_; }
         Quantity GetInitialQuantity() const{ return initialQuantity_; }
         Quantity GetRemainingQuantity() const{ return remainingQuantity_; }
+        AccountID GetAccountId() const{ return accountId_; }
         Quantity GetFilledQuantity() const{ return GetInitialQuantity() - GetRemainingQuantity(); }
         bool isFilled() const { return GetRemainingQuantity() == 0; }
         void Fill(Quantity quantity)
@@ -43,6 +46,16 @@ public:
             remainingQuantity_ -= quantity;
         }
 
+        // Amend-down: the order becomes what a fresh order of 'quantity' would be, without losing its place in the queue.
+        void ReduceQuantity(Quantity quantity)
+        {
+            if(quantity == 0 || quantity > GetRemainingQuantity())
+                throw std::logic_error(std::format("Order ({}) can only be reduced to a quantity between 1 and its remaining quantity.", GetOrderId()));
+
+            initialQuantity_ = quantity;
+            remainingQuantity_ = quantity;
+        }
+
         void ToGoodTillCancel(Price price)
         {
             if(GetOrderType() != OrderType::Market)
@@ -59,6 +72,7 @@ private:
     Price price_ ;
     Quantity initialQuantity_ ;
     Quantity remainingQuantity_ ;
+    AccountID accountId_ ;
 };
 
 
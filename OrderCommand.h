@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Order.h"
+#include "OrderModify.h"
+
+enum class CommandType
+{
+    Add,
+    Cancel,
+    Modify,
+    ExpireGoodForDay,   // Cancels every GoodForDay order of the book, sent when the trading session closes.
+    Execute,            // Fills quantity_ of a resting order against a counterparty outside of the book, e.g. an execution reported by a market feed.
+    Reduce,             // Takes quantity_ off a resting order without touching its place in the queue, the whole order once nothing is left.
+    MassCancel,         // Cancels every resting order a MassCancelFilter selects.
+};
+
+enum class MassCancelScope : std::uint8_t
+{
+    All,            // Every resting order of the book.
+    OneSide,        // Every order of 'side_'.
+    PriceRange,     // The orders of 'side_' priced from 'lowPrice_' to 'highPrice_', both included.
+    Account,        // Every order of 'accountId_', the book has to track accounts (see RiskLimits::trackAccounts_).
+};
+
+// Which orders a mass cancel takes off the book.
+struct MassCancelFilter
+{
+    MassCancelScope scope_{ MassCancelScope::All };
+    Side side_{ Side::Buy };
+    Price lowPrice_{ };
+    Price highPrice_{ };
+    AccountID accountId_{ };
+
+    static MassCancelFilter All() { return MassCancelFilter{ }; }
+    static MassCancelFilter OneSide(Side side) { return MassCancelFilter{ MassCancelScope::OneSide, side }; }
+    static MassCancelFilter PriceRange(Side side, Price lowPrice, Price highPrice) { return MassCancelFilter{ MassCancelScope::PriceRange, side, lowPrice, highPrice }; }
+    static MassCancelFilter Account(AccountID accountId) { return MassCancelFilter{ MassCancelScope::Account, Side::Buy, 0, 0, accountId }; }
+};
+
+/*
+** OrderCommand is a plain, fixed-size description of one request to the Orderbook (add, cancel, modify, expire, execute, reduce or mass cancel).
+** Being trivially copyable it can be queued between threads, batched or written to disk without any allocation,
+   and it is turned back into an Order/OrderModify only when it is applied to a book.
+*/
+struct OrderCommand
+{
+    CommandType type_{ CommandType::Add };
+    OrderType orderType_{ OrderType::GoodTillCancel };
+    Side side_{ Side::Buy };
+    OrderID orderId_{ };
+    Price price_{ };
+    Quantity quantity_{ };
+    AccountID accountId_{ };            // Add and MassCancel, see Order::GetAccountId().
+    MassCancelScope scope_{ };          // MassCancel only, with side_, price_ (the low price) and highPrice_.
+    Price highPrice_{ };
+
+    static OrderCommand Add(const Order& order)
+    {
+        return OrderCommand{ CommandType::Add, order.GetOrderType(), order.GetSide(), order.GetOrderId(), order.GetPrice(), order.GetRemainingQuantity(),
+            order.GetAccountId() };
+    }
+
+    static OrderCommand Cancel(OrderID orderId)
+    {
+        return OrderCommand{ CommandType::Cancel, OrderType::GoodTillCancel, Side::Buy, orderId, 0, 0 };
+    }
+
+    static OrderCommand Modify(const OrderModify& modify)
+    {
+        return OrderCommand{ CommandType::Modify, OrderType::GoodTillCancel, modify.GetSide(), modify.GetOrderId(), modify.GetPrice(), modify.GetQuantity() };
+    }
+
+    static OrderCommand ExpireGoodForDay()
+    {
+        return OrderCommand{ CommandType::ExpireGoodForDay, OrderType::GoodForDay, Side::Buy, 0, 0, 0 };
+    }
+
+    // 'price' is the execution price when it differs from the order's own price, 0 means the order's price.
+    static OrderCommand Execute(OrderID orderId, Quantity quantity, Price price = 0)
+    {
+        return OrderCommand{ CommandType::Execute, OrderType::GoodTillCancel, Side::Buy, orderId, price, quantity };
+    }
+
+    static OrderCommand Reduce(OrderID orderId, Quantity quantity)
+    {
+        return OrderCommand{ CommandType::Reduce, OrderType::GoodTillCancel, Side::Buy, orderId, 0, quantity };
+    }
+
+    static OrderCommand MassCancel(const MassCancelFilter& filter)
+    {
+        return OrderCommand{ CommandType::MassCancel, OrderType::GoodTillCancel, filter.side_, 0, filter.lowPrice_, 0, filter.accountId_, filter.scope_, filter.highPrice_ };
+    }
+
+    Order ToOrder() const { return Order{ orderType_, orderId_, side_, price_, quantity_, accountId_ }; }
+    OrderModify ToOrderModify() const { return OrderModify{ orderId_, side_, price_, quantity_ }; }
+    MassCancelFilter ToMassCancelFilter() const { return MassCancelFilter{ scope_, side_, price_, highPrice_, accountId_ }; }
+};
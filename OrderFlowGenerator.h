@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "Usings.h"
+#include "OrderCommand.h"
+
+// What a generated command stands for, it is how the benchmark groups its latencies.
+enum class FlowOperation
+{
+    Add,            // A GoodTillCancel or GoodForDay limit order.
+    FillAndKill,
+    FillOrKill,
+    Market,
+    Cancel,
+    Modify,
+};
+
+constexpr std::size_t FlowOperationCount = 6;
+
+struct FlowCommand
+{
+    FlowOperation operation_{ FlowOperation::Add };
+    OrderCommand command_;
+};
+
+struct OrderFlowOptions
+{
+    std::uint64_t seed_{ 1 };               // The same seed always produces the same flow.
+
+    // Relative weights of the operations, they don't need to add up to anything in particular.
+    double addWeight_{ 45 };
+    double cancelWeight_{ 40 };
+    double modifyWeight_{ 10 };
+    double marketWeight_{ 1 };
+    double fillAndKillWeight_{ 3 };
+    double fillOrKillWeight_{ 1 };
+
+    double goodForDayRatio_{ 0.1 };         // Share of the limit adds that are GoodForDay rather than GoodTillCancel.
+    double aggressiveRatio_{ 0.05 };        // Share of the limit adds priced through the opposite touch.
+
+    Price midPrice_{ 10'000 };
+    Price tickSize_{ 1 };
+    double meanDistanceTicks_{ 8 };         // Passive orders sit this many ticks behind their touch on average (geometric).
+    double midDriftTicks_{ 0.02 };          // Average move of the mid price per command, a random walk.
+
+    Quantity lotSize_{ 100 };
+    double meanLots_{ 3 };                  // Order sizes are 1 + geometric lots, so most orders are small and a few are large.
+
+    std::size_t initialDepth_{ 10'000 };    // Passive orders added by Prefill() before measuring.
+};
+
+/*
+** OrderFlowGenerator produces a seeded, reproducible stream of FlowCommands that looks like a real order flow:
+   prices cluster around a slowly drifting mid price, sizes are skewed towards small orders, and cancels and
+   modifies target orders the generator added earlier.
+** The generator doesn't look at the book, so some cancels and modifies target orders that have traded away
+   in the meantime; they are answered with NotFound like they would be on a real venue.
+*/
+class OrderFlowGenerator
+{
+public:
+    explicit OrderFlowGenerator(const OrderFlowOptions& options = { })
+        : options_{ options }
+        , random_{ options.seed_ }
+        , operation_{ { options.addWeight_, options.fillAndKillWeight_, options.fillOrKillWeight_,
+            options.marketWeight_, options.cancelWeight_, options.modifyWeight_ } }
+        , distance_{ 1.0 / (1.0 + std::max(options.meanDistanceTicks_, 0.0)) }
+        , lots_{ 1.0 / (1.0 + std::max(options.meanLots_, 0.0)) }
+        , mid_{ static_cast<double>(options.midPrice_ / options.tickSize_) }
+    { }
+
+    // The passive orders that build the initial book on both sides of the mid price.
+    std::vector<FlowCommand> Prefill()
+    {
+        std::vector<FlowCommand> commands;
+        commands.reserve(options_.initialDepth_);
+        for(std::size_t count = 0; count < options_.initialDepth_; ++count)
+            commands.push_back(AddLimit(OrderType::GoodTillCancel, NextSide(), false));
+
+        return commands;
+    }
+
+    FlowCommand Next()
+    {
+        mid_ += std::uniform_real_distribution<double>{ -2 * options_.midDriftTicks_, 2 * options_.midDriftTicks_ }(random_);
+
+        const auto operation = static_cast<FlowOperation>(operation_(random_));
+        if((operation == FlowOperation::Cancel || operation == FlowOperation::Modify) && live_.empty())
+            return AddLimit(OrderType::GoodTillCancel, NextSide(), false);
+
+        switch(operation)
+        {
+        case FlowOperation::Add:
+            return AddLimit(Chance(options_.goodForDayRatio_) ? OrderType::GoodForDay : OrderType::GoodTillCancel, NextSide(), Chance(options_.aggressiveRatio_));
+        case FlowOperation::FillAndKill:
+            return Aggressive(FlowOperation::FillAndKill, OrderType::FillAndKill);
+        case FlowOperation::FillOrKill:
+            return Aggressive(FlowOperation::FillOrKill, OrderType::FillOrKill);
+        case FlowOperation::Market:
+        {
+            const Order order{ nextOrderId_++, NextSide(), NextQuantity() };
+            return FlowCommand{ FlowOperation::Market, OrderCommand::Add(order) };
+        }
+        case FlowOperation::Cancel:
+        {
+            // Swap-and-pop keeps picking and forgetting a random live order O(1).
+            const auto index = std::uniform_int_distribution<std::size_t>{ 0, live_.size() - 1 }(random_);
+            const auto orderId = live_[index].orderId_;
+            live_[index] = live_.back();
+            live_.pop_back();
+            return FlowCommand{ FlowOperation::Cancel, OrderCommand::Cancel(orderId) };
+        }
+        case FlowOperation::Modify:
+        {
+            // Half of the modifies shrink the order in place, the other half move it to a new price.
+            auto& order = live_[std::uniform_int_distribution<std::size_t>{ 0, live_.size() - 1 }(random_)];
+            const auto price = Chance(0.5) ? order.price_ : PassivePrice(order.side_);
+            const OrderModify modify{ order.orderId_, order.side_, price, NextQuantity() };
+            order.price_ = price;
+            return FlowCommand{ FlowOperation::Modify, OrderCommand::Modify(modify) };
+        }
+        }
+
+        return AddLimit(OrderType::GoodTillCancel, NextSide(), false);
+    }
+
+    std::vector<FlowCommand> Generate(std::size_t count)
+    {
+        std::vector<FlowCommand> commands;
+        commands.reserve(count);
+        for(std::size_t index = 0; index < count; ++index)
+            commands.push_back(Next());
+
+        return commands;
+    }
+
+private:
+    struct LiveOrder
+    {
+        OrderID orderId_;
+        Side side_;
+        Price price_;
+    };
+
+    OrderFlowOptions options_;
+    std::mt19937_64 random_;
+    std::discrete_distribution<int> operation_;
+    std::geometric_distribution<int> distance_;
+    std::geometric_distribution<int> lots_;
+    double mid_;
+    OrderID nextOrderId_{ 1 };
+    std::vector<LiveOrder> live_;
+
+    bool Chance(double probability) { return std::uniform_real_distribution<double>{ }(random_) < probability; }
+    Side NextSide() { return Chance(0.5) ? Side::Buy : Side::Sell; }
+    Quantity NextQuantity() { return options_.lotSize_ * static_cast<Quantity>(1 + lots_(random_)); }
+    Price ToPrice(std::int64_t tick) const { return static_cast<Price>(std::max<std::int64_t>(tick, 1) * options_.tickSize_); }
+
+    // Bids rest below the mid price and asks above it, most of them close to the touch.
+    Price PassivePrice(Side side)
+    {
+        const auto distance = 1 + distance_(random_);
+        const auto mid = static_cast<std::int64_t>(mid_);
+        return ToPrice(side == Side::Buy ? mid - distance : mid + distance);
+    }
+
+    // A few ticks through the mid price, so the order reaches into the opposite side.
+    Price AggressivePrice(Side side)
+    {
+        const auto distance = 1 + distance_(random_) / 4;
+        const auto mid = static_cast<std::int64_t>(mid_);
+        return ToPrice(side == Side::Buy ? mid + distance : mid - distance);
+    }
+
+    FlowCommand AddLimit(OrderType orderType, Side side, bool aggressive)
+    {
+        const Order order{ orderType, nextOrderId_++, side, aggressive ? AggressivePrice(side) : PassivePrice(side), NextQuantity() };
+        live_.push_back(LiveOrder{ order.GetOrderId(), side, order.GetPrice() });
+        return FlowCommand{ FlowOperation::Add, OrderCommand::Add(order) };
+    }
+
+    FlowCommand Aggressive(FlowOperation operation, OrderType orderType)
+    {
+        const auto side = NextSide();
+        const Order order{ orderType, nextOrderId_++, side, AggressivePrice(side), NextQuantity() };
+        return FlowCommand{ operation, OrderCommand::Add(order) };
+    }
+};
@@ -0,0 +1,404 @@
+#include "OrderGateway.h"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+enum class GatewaySlotState : std::uint32_t
+{
+    Free,
+    Connected,
+    Disconnected,   // Set by the client when it goes away, the gateway then cleans up after it.
+};
+
+// The start of the segment. magic_ is stored last by the gateway, a client that sees it sees the whole layout.
+struct alignas(CacheLineSize) GatewayHeader
+{
+    std::atomic<std::uint64_t> magic_{ };
+    std::uint32_t version_{ };
+    std::uint32_t gatewayProcess_{ };
+    std::uint64_t clientCapacity_{ };
+    std::uint64_t requestCapacity_{ };
+    std::uint64_t responseCapacity_{ };
+};
+
+// The control block of a client slot, followed in the segment by the slot's request ring and response ring.
+struct alignas(CacheLineSize) GatewaySlot
+{
+    std::atomic<std::uint32_t> owner_{ };      // Process id of the client holding the slot, 0 while it is free. Claimed with a CAS.
+    std::atomic<GatewaySlotState> state_{ GatewaySlotState::Free };
+    std::atomic<std::uint64_t> lostResponses_{ };
+};
+
+namespace
+{
+    constexpr std::uint64_t GatewayMagic = 0x3159415754474F42;    // "OBGTWAY1"
+    constexpr std::uint32_t GatewayVersion = 1;
+
+    constexpr std::size_t AlignUp(std::size_t bytes) { return (bytes + CacheLineSize - 1) / CacheLineSize * CacheLineSize; }
+
+    // Where everything is in the segment, worked out the same way by the gateway and by every client.
+    struct GatewayLayout
+    {
+        std::size_t requestCapacity_;
+        std::size_t responseCapacity_;
+        std::size_t requestsOffset_;        // From the start of a slot.
+        std::size_t responsesOffset_;
+        std::size_t slotBytes_;
+
+        GatewayLayout(std::size_t requestCapacity, std::size_t responseCapacity)
+            : requestCapacity_{ requestCapacity }
+            , responseCapacity_{ responseCapacity }
+            , requestsOffset_{ AlignUp(sizeof(GatewaySlot)) }
+            , responsesOffset_{ requestsOffset_ + AlignUp(SharedRing<GatewayRequest>::BytesFor(requestCapacity)) }
+            , slotBytes_{ responsesOffset_ + AlignUp(SharedRing<GatewayResponse>::BytesFor(responseCapacity)) }
+        { }
+
+        std::size_t SegmentBytes(std::size_t clientCapacity) const { return AlignUp(sizeof(GatewayHeader)) + clientCapacity * slotBytes_; }
+        std::byte* Slot(std::byte* segment, std::size_t slot) const { return segment + AlignUp(sizeof(GatewayHeader)) + slot * slotBytes_; }
+    };
+
+    GatewayOptions Normalized(GatewayOptions options)
+    {
+        options.clientCapacity_ = std::max(options.clientCapacity_, std::size_t{ 1 });
+        options.requestCapacity_ = std::bit_ceil(std::max(options.requestCapacity_, std::size_t{ 2 }));
+        options.responseCapacity_ = std::bit_ceil(std::max(options.responseCapacity_, std::size_t{ 2 }));
+        options.bookOptions_.singleWriter_ = true;     // Only the thread calling Poll() ever touches the books.
+        return options;
+    }
+
+    // A segment of the same name is removed only if the gateway that created it is gone, a live one keeps it and
+    // creating ours fails. A segment without a gateway process (its creator died before writing it) is gone too.
+    const std::string& ReclaimName(const std::string& name)
+    {
+        try
+        {
+            const SharedMemory existing{ name, SharedMemory::Mode::Open };
+            const auto header = std::launder(reinterpret_cast<const GatewayHeader*>(existing.Data()));
+            if(existing.Size() >= sizeof(GatewayHeader) && header->gatewayProcess_ != 0 && IsProcessAlive(header->gatewayProcess_))
+                return name;
+        }
+        catch(const std::runtime_error&)
+        {
+            // Nothing of that name, or nothing that can be mapped.
+        }
+
+        SharedMemory::Remove(name);
+        return name;
+    }
+}
+
+
+OrderGateway::OrderGateway(const GatewayOptions& options)
+    : options_{ Normalized(options) }
+    , memory_{ ReclaimName(options_.name_), SharedMemory::Mode::Create,
+        GatewayLayout{ options_.requestCapacity_, options_.responseCapacity_ }.SegmentBytes(options_.clientCapacity_) }
+    , nextLivenessCheck_{ std::chrono::steady_clock::now() + options_.livenessInterval_ }
+{
+    const GatewayLayout layout{ options_.requestCapacity_, options_.responseCapacity_ };
+    const auto header = new(memory_.Data()) GatewayHeader{ };
+    header->version_ = GatewayVersion;
+    header->gatewayProcess_ = CurrentProcessId();
+    header->clientCapacity_ = options_.clientCapacity_;
+    header->requestCapacity_ = options_.requestCapacity_;
+    header->responseCapacity_ = options_.responseCapacity_;
+
+    clients_.resize(options_.clientCapacity_);
+    for(std::size_t slot = 0; slot < clients_.size(); ++slot)
+    {
+        const auto memory = layout.Slot(memory_.Data(), slot);
+        SharedRing<GatewayRequest>::Initialize(memory + layout.requestsOffset_);
+        SharedRing<GatewayResponse>::Initialize(memory + layout.responsesOffset_);
+
+        auto& client = clients_[slot];
+        client.control_ = new(memory) GatewaySlot{ };
+        client.requests_ = SharedRing<GatewayRequest>{ memory + layout.requestsOffset_, layout.requestCapacity_ };
+        client.responses_ = SharedRing<GatewayResponse>{ memory + layout.responsesOffset_, layout.responseCapacity_ };
+    }
+
+    header->magic_.store(GatewayMagic, std::memory_order_release);
+}
+
+OrderGateway::~OrderGateway()
+{
+    // Connected clients see the gateway gone through GatewayClient::IsGatewayAlive().
+    std::launder(reinterpret_cast<GatewayHeader*>(memory_.Data()))->magic_.store(0, std::memory_order_release);
+}
+
+
+std::size_t OrderGateway::Poll()
+{
+    std::size_t applied{ };
+    for(std::uint32_t client = 0; client < clients_.size(); ++client)
+    {
+        const auto state = clients_[client].control_->state_.load(std::memory_order_acquire);
+        if(state == GatewaySlotState::Connected)
+            applied += PollClient(client, false);
+        else if(state == GatewaySlotState::Disconnected)
+        {
+            applied += PollClient(client, true);
+            Disconnect(client);
+        }
+    }
+
+    // A crashed client never says goodbye. Checking its process costs a system call, so it's only done now and then.
+    const auto now = std::chrono::steady_clock::now();
+    if(now >= nextLivenessCheck_)
+    {
+        for(std::uint32_t client = 0; client < clients_.size(); ++client)
+        {
+            const auto owner = clients_[client].control_->owner_.load(std::memory_order_acquire);
+            if(owner != 0 && !IsProcessAlive(owner))
+            {
+                applied += PollClient(client, true);
+                Disconnect(client);
+            }
+        }
+
+        nextLivenessCheck_ = now + options_.livenessInterval_;
+    }
+
+    if(sessionClosed_.exchange(false, std::memory_order_acq_rel))
+        ExpireGoodForDay();
+
+    return applied;
+}
+
+
+void OrderGateway::OnSessionClose()
+{
+    sessionClosed_.store(true, std::memory_order_release);
+}
+
+
+std::size_t OrderGateway::PollClient(std::uint32_t client, bool disconnecting)
+{
+    auto& slot = clients_[client];
+
+    // A client that doesn't keep up with its responses isn't served until it does. Once it is gone there's nobody left to wait for.
+    if(!disconnecting && slot.responses_.FreeSlots() <= slot.responses_.Capacity() / 2)
+        return 0;
+
+    const auto maxCount = disconnecting ? static_cast<std::size_t>(-1) : options_.batchSize_;
+    return slot.requests_.ConsumeBatch(maxCount, [this, client](const GatewayRequest& request) { Apply(client, request); });
+}
+
+
+void OrderGateway::Apply(std::uint32_t client, const GatewayRequest& request)
+{
+    auto command = request.command_;
+    GatewayResponse result{ .type_ = GatewayResponseType::Result, .status_ = CommandStatus::Rejected, .symbol_ = request.symbol_,
+        .requestId_ = request.requestId_, .orderId_ = command.orderId_ };
+
+    // The ownership checks come first, a request the client isn't entitled to never reaches the book.
+    const auto owner = owners_.find(command.orderId_);
+    switch(command.type_)
+    {
+    case CommandType::Add:
+        if(owner != owners_.end())
+        {
+            Respond(client, result);
+            return;
+        }
+        owners_.emplace(command.orderId_, OrderOwner{ client, request.symbol_ });
+        command.accountId_ = ClientAccount(client);
+        break;
+    case CommandType::Cancel:
+    case CommandType::Modify:
+    case CommandType::Reduce:
+        if(owner == owners_.end() || owner->second.client_ != client || owner->second.symbol_ != request.symbol_)
+        {
+            result.status_ = CommandStatus::NotFound;
+            Respond(client, result);
+            return;
+        }
+        break;
+    case CommandType::ExpireGoodForDay:
+    case CommandType::Execute:
+    case CommandType::MassCancel:
+        Respond(client, result);
+        return;
+    }
+
+    auto& book = GetOrCreateBook(request.symbol_);
+    result_.Clear();
+    book.ProcessBatch({ &command, 1 }, result_);
+    result.status_ = result_.results_.front().status_;
+    Respond(client, result);
+
+    // Every side of every trade that belongs to a client is reported to it, the aggressor and the resting orders alike.
+    // Both sides traded at the execution price, the price of the resting side, not at their own limits.
+    for(const auto& trade : result_.trades_)
+    {
+        const auto price = command.side_ == Side::Buy ? trade.GetAskTrade().price_ : trade.GetBidTrade().price_;
+        for(const auto& info : { trade.GetBidTrade(), trade.GetAskTrade() })
+        {
+            const auto filled = owners_.find(info.orderid_);
+            if(filled == owners_.end())
+                continue;
+
+            const auto fillClient = filled->second.client_;
+            Respond(fillClient, GatewayResponse{ .type_ = GatewayResponseType::Fill, .symbol_ = request.symbol_,
+                .requestId_ = fillClient == client ? request.requestId_ : 0, .orderId_ = info.orderid_, .price_ = price, .quantity_ = info.quantity_ });
+        }
+    }
+
+    // Orders that are no longer on the book, filled, cancelled or never accepted, don't belong to anyone anymore.
+    for(const auto& trade : result_.trades_)
+    {
+        Release(trade.GetBidTrade().orderid_, book);
+        Release(trade.GetAskTrade().orderid_, book);
+    }
+    Release(command.orderId_, book);
+}
+
+
+void OrderGateway::Respond(std::uint32_t client, const GatewayResponse& response)
+{
+    auto& slot = clients_[client];
+    if(!slot.responses_.TryPush(response))
+        slot.control_->lostResponses_.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void OrderGateway::Release(OrderID orderId, Orderbook& book)
+{
+    if(book.FindOrder(orderId) == InvalidOrderHandle)
+        owners_.erase(orderId);
+}
+
+
+void OrderGateway::Disconnect(std::uint32_t client)
+{
+    // Whatever the client still has resting is cancelled, there is nobody left to manage those orders. Each book
+    // finds them through the client's account, the other clients' orders are never visited.
+    cancelled_.clear();
+    for(auto& [symbol, book] : books_)
+        book->MassCancel(MassCancelFilter::Account(ClientAccount(client)), &cancelled_);
+
+    for(const auto orderId : cancelled_)
+        owners_.erase(orderId);
+
+    // The slot is ready for the next client before it is handed out, owner_ going back to 0 is what hands it out.
+    auto& slot = clients_[client];
+    slot.requests_.Reset();
+    slot.responses_.Reset();
+    slot.control_->lostResponses_.store(0, std::memory_order_relaxed);
+    slot.control_->state_.store(GatewaySlotState::Free, std::memory_order_relaxed);
+    slot.control_->owner_.store(0, std::memory_order_release);
+}
+
+
+void OrderGateway::ExpireGoodForDay()
+{
+    // Like the orders of a client that is gone, expired orders don't belong to anyone anymore and their IDs can be used again.
+    cancelled_.clear();
+    for(auto& [symbol, book] : books_)
+        book->ExpireGoodForDayOrders(&cancelled_);
+
+    for(const auto orderId : cancelled_)
+        owners_.erase(orderId);
+}
+
+
+Orderbook& OrderGateway::GetOrCreateBook(SymbolID symbol)
+{
+    auto& book = books_[symbol];
+    if(!book)
+    {
+        auto bookOptions = options_.bookOptions_;
+        bookOptions.riskLimits_.trackAccounts_ = true;
+        bookOptions.riskLimits_.accountCapacity_ = std::max(bookOptions.riskLimits_.accountCapacity_, options_.clientCapacity_ + 1);
+        book = std::make_unique<Orderbook>(bookOptions);
+    }
+
+    return *book;
+}
+
+
+Orderbook* OrderGateway::GetBook(SymbolID symbol) const
+{
+    const auto it = books_.find(symbol);
+    return it != books_.end() ? it->second.get() : nullptr;
+}
+
+
+std::size_t OrderGateway::GetClientCount() const
+{
+    std::size_t connected{ };
+    for(const auto& client : clients_)
+        connected += client.control_->state_.load(std::memory_order_relaxed) == GatewaySlotState::Connected;
+
+    return connected;
+}
+
+
+GatewayClient::GatewayClient(const std::string& name)
+    : memory_{ name, SharedMemory::Mode::Open }
+{
+    header_ = std::launder(reinterpret_cast<const GatewayHeader*>(memory_.Data()));
+    if(memory_.Size() < sizeof(GatewayHeader) || header_->magic_.load(std::memory_order_acquire) != GatewayMagic || header_->version_ != GatewayVersion)
+        throw std::runtime_error(std::format("Shared memory ({}) is not a gateway this build can connect to.", name));
+
+    const GatewayLayout layout{ header_->requestCapacity_, header_->responseCapacity_ };
+    if(memory_.Size() < layout.SegmentBytes(header_->clientCapacity_))
+        throw std::runtime_error(std::format("Gateway ({}) is truncated.", name));
+
+    // A slot is claimed by writing our process id into its owner, which is also how the gateway tells whether we are still alive.
+    const auto process = CurrentProcessId();
+    for(slot_ = 0; slot_ < header_->clientCapacity_; ++slot_)
+    {
+        const auto control = std::launder(reinterpret_cast<GatewaySlot*>(layout.Slot(memory_.Data(), slot_)));
+        std::uint32_t expected{ };
+        if(control->owner_.compare_exchange_strong(expected, process, std::memory_order_acq_rel))
+        {
+            control_ = control;
+            break;
+        }
+    }
+
+    if(!control_)
+        throw std::runtime_error(std::format("Gateway ({}) has no free client slot.", name));
+
+    const auto memory = layout.Slot(memory_.Data(), slot_);
+    requests_ = SharedRing<GatewayRequest>{ memory + layout.requestsOffset_, layout.requestCapacity_ };
+    responses_ = SharedRing<GatewayResponse>{ memory + layout.responsesOffset_, layout.responseCapacity_ };
+    control_->state_.store(GatewaySlotState::Connected, std::memory_order_release);
+}
+
+GatewayClient::~GatewayClient()
+{
+    control_->state_.store(GatewaySlotState::Disconnected, std::memory_order_release);
+}
+
+
+bool GatewayClient::Submit(SymbolID symbol, const OrderCommand& command, std::uint64_t* requestId)
+{
+    const GatewayRequest request{ nextRequestId_, symbol, command };
+    if(!requests_.TryPush(request))
+        return false;
+
+    if(requestId)
+        *requestId = nextRequestId_;
+
+    ++nextRequestId_;
+    return true;
+}
+
+
+std::size_t GatewayClient::PollResponses(std::vector<GatewayResponse>& responses, std::size_t maxCount)
+{
+    return responses_.ConsumeBatch(maxCount, [&responses](const GatewayResponse& response) { responses.push_back(response); });
+}
+
+
+bool GatewayClient::IsGatewayAlive() const
+{
+    return header_->magic_.load(std::memory_order_acquire) == GatewayMagic && IsProcessAlive(header_->gatewayProcess_);
+}
+
+
+std::uint64_t GatewayClient::GetLostResponses() const
+{
+    return control_->lostResponses_.load(std::memory_order_relaxed);
+}
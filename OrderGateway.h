@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Usings.h"
+#include "Orderbook.h"
+#include "OrderCommand.h"
+#include "BatchResult.h"
+#include "SharedMemory.h"
+
+// Laid out in the gateway's shared memory segment, see OrderGateway.cpp.
+struct GatewayHeader;
+struct GatewaySlot;
+
+// What a client process submits: a command for the book of 'symbol_'. 'requestId_' is the client's own, its responses carry it back.
+struct GatewayRequest
+{
+    std::uint64_t requestId_{ };
+    SymbolID symbol_{ };
+    OrderCommand command_;
+};
+
+enum class GatewayResponseType : std::uint8_t
+{
+    Result,     // The outcome of one request, always sent before the fills it caused.
+    Fill,       // One of the client's orders traded, as the aggressor or while resting.
+};
+
+struct GatewayResponse
+{
+    GatewayResponseType type_{ GatewayResponseType::Result };
+    CommandStatus status_{ CommandStatus::Accepted };   // Result only.
+    SymbolID symbol_{ };
+    std::uint64_t requestId_{ };    // The request answered, or that caused the fill. 0 for a fill of a resting order caused by someone else.
+    OrderID orderId_{ };
+    Price price_{ };                // Fill only: the price and quantity this order traded, the price is the execution price (the resting order's).
+    Quantity quantity_{ };
+};
+
+struct GatewayOptions
+{
+    std::string name_{ "/orderbook-gateway" };      // The shared memory name clients connect to.
+    std::size_t clientCapacity_{ 16 };              // Client processes connected at the same time.
+    std::size_t requestCapacity_{ 1 << 12 };        // Size of every client's request ring (rounded up to a power of two).
+    std::size_t responseCapacity_{ 1 << 14 };       // Size of every client's response ring.
+    std::size_t batchSize_{ 256 };                  // Maximum requests applied per client per Poll(), so one busy client can't starve the others.
+    std::chrono::milliseconds livenessInterval_{ 100 };    // How often the client processes are checked for crashes.
+    OrderbookOptions bookOptions_;                  // Used for every book the gateway creates.
+};
+
+/*
+** OrderGateway lets strategy processes on the same host trade on books owned by the matching process, without a
+   socket or a system call on the data path. It creates a SharedMemory segment holding, for every client slot, an SPSC
+   request ring (client to gateway) and an SPSC response ring (gateway to client) of fixed-size records, see SharedRing.
+** The matching process calls Poll() in its loop. Poll() drains the request rings of the connected clients, applies each
+   request to the book of its symbol (single writer books, created by the first request for their symbol), and answers
+   with a Result and one Fill per trade of the client's orders, including the resting orders another client traded against.
+** Every order belongs to the client that added it: OrderIDs are unique across the gateway, and a client can only cancel,
+   modify or reduce its own orders. Execute, ExpireGoodForDay and MassCancel aren't taken from clients.
+** Orders are added under the account of their client's slot (ClientAccount()), whatever account the request carried,
+   so the risk limits of bookOptions_ apply per client.
+** A client that disconnects, or whose process is found dead (checked every livenessInterval_), has its remaining
+   requests applied and then every order it still has resting cancelled (a mass cancel of its account on each book),
+   after which its slot is reused.
+** GoodForDay orders expire when an ExpiryScheduler calls the gateway's OnSessionClose() (never register its books,
+   they are single writer books): the next Poll() expires them on every book and forgets who owned them.
+** A client whose response ring is more than half full isn't drained until it catches up. A fill that still finds its
+   owner's ring full is dropped and counted, see GatewayClient::GetLostResponses().
+*/
+class OrderGateway
+{
+public:
+    explicit OrderGateway(const GatewayOptions& options = { });
+    OrderGateway(const OrderGateway&) = delete;
+    void operator=(const OrderGateway&) = delete;
+    OrderGateway(OrderGateway&&) = delete;
+    void operator=(OrderGateway&&) = delete;
+    ~OrderGateway();
+
+    // Applies the pending requests of every connected client and returns how many there were. One thread only.
+    std::size_t Poll();
+
+    // Called by an ExpiryScheduler at the close of the session, from any thread. The GoodForDay orders of every book
+    // are expired by the next Poll(), after the requests it applies.
+    void OnSessionClose();
+
+    // Null until a client has sent a request for the symbol. Only for the thread calling Poll().
+    Orderbook* GetBook(SymbolID symbol) const;
+    std::size_t GetClientCount() const;
+
+    static AccountID ClientAccount(std::uint32_t client) { return client + 1; }
+
+private:
+    // The gateway's own view of a client slot.
+    struct Client
+    {
+        GatewaySlot* control_{ nullptr };
+        SharedRing<GatewayRequest> requests_;
+        SharedRing<GatewayResponse> responses_;
+    };
+
+    struct OrderOwner
+    {
+        std::uint32_t client_;
+        SymbolID symbol_;
+    };
+
+    GatewayOptions options_;
+    SharedMemory memory_;
+    std::vector<Client> clients_;
+    std::unordered_map<SymbolID, std::unique_ptr<Orderbook>> books_;
+    std::unordered_map<OrderID, OrderOwner> owners_;
+    BatchResult result_;
+    OrderIDs cancelled_;
+    std::chrono::steady_clock::time_point nextLivenessCheck_;
+    std::atomic<bool> sessionClosed_{ false };
+
+    std::size_t PollClient(std::uint32_t client, bool disconnecting);
+    void Apply(std::uint32_t client, const GatewayRequest& request);
+    void Respond(std::uint32_t client, const GatewayResponse& response);
+    void Release(OrderID orderId, Orderbook& book);
+    void Disconnect(std::uint32_t client);
+    void ExpireGoodForDay();
+    Orderbook& GetOrCreateBook(SymbolID symbol);
+};
+
+/*
+** GatewayClient is the client process's end of an OrderGateway: it claims a free slot of the gateway's segment and
+   submits requests and polls responses through that slot's rings. Submit() and PollResponses() are a handful of
+   loads and stores on shared memory, neither ever blocks or enters the kernel.
+** Submit() is for one thread and PollResponses() for one thread (they may be different ones).
+** Destroying the client disconnects it, the gateway then cancels every order it still has resting.
+*/
+class GatewayClient
+{
+public:
+    explicit GatewayClient(const std::string& name = "/orderbook-gateway");
+    GatewayClient(const GatewayClient&) = delete;
+    void operator=(const GatewayClient&) = delete;
+    GatewayClient(GatewayClient&&) = delete;
+    void operator=(GatewayClient&&) = delete;
+    ~GatewayClient();
+
+    // Returns false if the request ring is full, otherwise 'requestId' (if given) receives the id the responses carry.
+    bool Submit(SymbolID symbol, const OrderCommand& command, std::uint64_t* requestId = nullptr);
+
+    // Appends up to 'maxCount' responses to 'responses'.
+    std::size_t PollResponses(std::vector<GatewayResponse>& responses, std::size_t maxCount = static_cast<std::size_t>(-1));
+
+    // False once the process running the gateway has gone away, nothing submitted from then on is applied.
+    // Checking the process is a system call, this is for a watchdog and not for the trading loop.
+    bool IsGatewayAlive() const;
+
+    // Fills the gateway dropped because the response ring was full.
+    std::uint64_t GetLostResponses() const;
+    std::size_t GetSlot() const { return slot_; }
+
+private:
+    SharedMemory memory_;
+    const GatewayHeader* header_{ nullptr };
+    GatewaySlot* control_{ nullptr };
+    std::size_t slot_{ };
+    std::uint64_t nextRequestId_{ 1 };
+    SharedRing<GatewayRequest> requests_;
+    SharedRing<GatewayResponse> responses_;
+};
@@ -0,0 +1,343 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <bit>
+#include <algorithm>
+
+#include "Usings.h"
+#include "OrderPool.h"
+
+/*
+** OrderIndex maps an OrderID to the OrderHandle of the resting order, it replaces the std::unordered_map we used before.
+** It is a flat open-addressing table using Robin Hood hashing: every bucket remembers how far it is from its home bucket,
+   and an insert takes the bucket of any entry that is closer to home than the one being inserted. This keeps probe
+   sequences short, and lets Erase() shift the following entries back instead of leaving tombstones behind.
+** For venues that hand out sequential OrderIDs the index can run in 'dense' mode, where IDs close to the ones already
+   seen are stored in a plain array indexed by (orderId - denseBase_). IDs far away from that window still go to the table.
+   The window follows the live IDs: when it has to make room for a new ID it first slides past its empty low end (and
+   moves the few stragglers of a mostly empty window to the table), so it is as large as the span of the live IDs
+   rather than the span of every ID of the session.
+** Find, Insert and Erase all hash the key once, so a cancel is a single probe. Insert finds a duplicate on the probe
+   that places the new entry.
+*/
+class OrderIndex
+{
+public:
+    explicit OrderIndex(std::size_t capacityHint = 0, bool denseIds = false, OrderID firstDenseId = 0)
+        : denseIds_{ denseIds }
+        , denseBase_{ firstDenseId }
+    {
+        Reserve(capacityHint);
+    }
+
+    std::size_t Size() const { return size_; }
+    std::size_t MemoryUsage() const { return buckets_.capacity() * sizeof(Bucket) + dense_.capacity() * sizeof(OrderHandle); }
+
+    void Reserve(std::size_t capacity)
+    {
+        if(denseIds_ && dense_.size() < capacity)
+        {
+            dense_.resize(capacity, InvalidOrderHandle);
+            MoveTableIntoDense();
+        }
+
+        // Keep the load factor of the table under 80%, the buckets are always a power of two.
+        const auto buckets = std::bit_ceil(std::max<std::size_t>(16, capacity + capacity / 4 + 1));
+        if(buckets > buckets_.size())
+            Rehash(buckets);
+    }
+
+    // Returns InvalidOrderHandle if there is no order with that ID.
+    OrderHandle Find(OrderID orderId) const
+    {
+        if(IsDense(orderId))
+            return dense_[orderId - denseBase_];
+
+        std::uint32_t distance = 1;
+        for(auto index = Home(orderId); ; index = (index + 1) & mask_, ++distance)
+        {
+            const auto& bucket = buckets_[index];
+
+            // Robin Hood ordering means that once we reach a bucket closer to home than we are, the key isn't there.
+            if(bucket.distance_ < distance)
+                return InvalidOrderHandle;
+
+            if(bucket.key_ == orderId)
+                return bucket.value_;
+        }
+    }
+
+    // Returns false (and leaves the index untouched) if the ID is already present.
+    bool Insert(OrderID orderId, OrderHandle handle)
+    {
+        if(denseIds_ && !IsDense(orderId))
+            MakeDenseRoom(orderId);
+
+        if(IsDense(orderId))
+        {
+            auto& slot = dense_[orderId - denseBase_];
+            if(slot != InvalidOrderHandle)
+                return false;
+
+            slot = handle;
+            ++denseCount_;
+            ++size_;
+            return true;
+        }
+
+        if((tableSize_ + 1) * 5 > buckets_.size() * 4)
+            Rehash(buckets_.size() * 2);
+
+        if(!InsertIntoTable(orderId, handle))
+            return false;
+
+        ++size_;
+        return true;
+    }
+
+    // Removes the ID and returns the handle it was mapped to, or InvalidOrderHandle if it wasn't present.
+    OrderHandle Erase(OrderID orderId)
+    {
+        if(IsDense(orderId))
+        {
+            auto& slot = dense_[orderId - denseBase_];
+            const auto handle = slot;
+            if(handle != InvalidOrderHandle)
+            {
+                slot = InvalidOrderHandle;
+                --denseCount_;
+                --size_;
+            }
+            return handle;
+        }
+
+        const auto handle = EraseFromTable(orderId);
+        if(handle != InvalidOrderHandle)
+            --size_;
+        return handle;
+    }
+
+    /*
+    ** Removes every entry, keeping the storage.
+    ** The dense window is dropped rather than wiped, it starts over at the next ID and is refilled as IDs come, so
+       the wipe is paid by the inserts that use it. The table is only wiped if it holds anything, which with dense IDs
+       is the odd straggler at most.
+    */
+    void Clear()
+    {
+        if(denseCount_ != 0)
+            dense_.clear();
+        if(tableSize_ != 0)
+            std::fill(buckets_.begin(), buckets_.end(), Bucket{ });
+
+        denseCount_ = 0;
+        tableSize_ = 0;
+        size_ = 0;
+    }
+
+    // Calls function(orderId, handle) for every entry, in no particular order.
+    template<typename Function>
+    void ForEach(Function function) const
+    {
+        for(std::size_t offset = 0; denseCount_ != 0 && offset < dense_.size(); ++offset)
+        {
+            if(dense_[offset] != InvalidOrderHandle)
+                function(denseBase_ + offset, dense_[offset]);
+        }
+
+        for(std::size_t index = 0; tableSize_ != 0 && index < buckets_.size(); ++index)
+        {
+            if(buckets_[index].distance_ != 0)
+                function(buckets_[index].key_, buckets_[index].value_);
+        }
+    }
+
+private:
+    struct Bucket
+    {
+        OrderID key_{ };
+        OrderHandle value_{ InvalidOrderHandle };
+        std::uint32_t distance_{ };     // Probe distance from the home bucket plus one, zero marks an empty bucket.
+    };
+
+    std::vector<Bucket> buckets_;
+    std::size_t mask_{ };
+    int shift_{ 64 };
+    std::size_t tableSize_{ };
+    std::size_t size_{ };
+
+    static constexpr std::size_t MinDenseSize = 1024;
+
+    bool denseIds_;
+    OrderID denseBase_;
+    std::vector<OrderHandle> dense_;
+    std::size_t denseCount_{ };
+
+    OrderHandle EraseFromTable(OrderID orderId)
+    {
+        std::uint32_t distance = 1;
+        for(auto index = Home(orderId); ; index = (index + 1) & mask_, ++distance)
+        {
+            auto& bucket = buckets_[index];
+            if(bucket.distance_ < distance)
+                return InvalidOrderHandle;
+
+            if(bucket.key_ != orderId)
+                continue;
+
+            const auto handle = bucket.value_;
+
+            // Backward shift deletion: pull every following displaced entry one bucket closer to its home.
+            auto hole = index;
+            for(auto next = (hole + 1) & mask_; buckets_[next].distance_ > 1; next = (next + 1) & mask_)
+            {
+                buckets_[hole] = buckets_[next];
+                --buckets_[hole].distance_;
+                hole = next;
+            }
+            buckets_[hole] = Bucket{ };
+
+            --tableSize_;
+            return handle;
+        }
+    }
+
+    // Fibonacci hashing spreads sequential IDs evenly over the table.
+    std::size_t Home(OrderID orderId) const
+    {
+        return static_cast<std::size_t>((orderId * 0x9E3779B97F4A7C15ull) >> shift_);
+    }
+
+    bool IsDense(OrderID orderId) const
+    {
+        return orderId >= denseBase_ && orderId - denseBase_ < dense_.size();
+    }
+
+    // The dense window only follows IDs that are close to it, a stray huge ID must not blow up the array.
+    bool ShouldGrowDense(OrderID orderId) const
+    {
+        return orderId >= denseBase_ && orderId - denseBase_ < std::max(dense_.size() * 2, MinDenseSize);
+    }
+
+    // Moves the window so that it covers 'orderId', if that ID is close enough to it. Every ID the window covers
+    // afterwards is in the array, every other one is in the table.
+    void MakeDenseRoom(OrderID orderId)
+    {
+        // An empty window simply starts over at this ID.
+        if(denseCount_ == 0)
+        {
+            denseBase_ = orderId;
+            if(dense_.size() < MinDenseSize)
+                dense_.resize(MinDenseSize, InvalidOrderHandle);
+            MoveTableIntoDense();
+            return;
+        }
+
+        if(!ShouldGrowDense(orderId))
+            return;
+
+        // Slide past the empty low end when that frees at least half the window. A window that is mostly empty
+        // slides by half even if a few old orders are still in that half, they move to the table.
+        auto shift = FirstDenseOffset();
+        if(shift < dense_.size() / 2 && denseCount_ * 4 < dense_.size())
+            shift = dense_.size() / 2;
+        if(shift >= dense_.size() / 2)
+            SlideDense(shift);
+
+        if(orderId - denseBase_ >= dense_.size())
+            dense_.resize(std::max(std::bit_ceil(static_cast<std::size_t>(orderId - denseBase_ + 1)), dense_.size() * 2), InvalidOrderHandle);
+
+        MoveTableIntoDense();
+    }
+
+    std::size_t FirstDenseOffset() const
+    {
+        std::size_t offset{ };
+        while(offset < dense_.size() && dense_[offset] == InvalidOrderHandle)
+            ++offset;
+        return offset;
+    }
+
+    void SlideDense(std::size_t shift)
+    {
+        for(std::size_t offset = 0; offset < shift; ++offset)
+        {
+            if(dense_[offset] == InvalidOrderHandle)
+                continue;
+
+            if((tableSize_ + 1) * 5 > buckets_.size() * 4)
+                Rehash(buckets_.size() * 2);
+            InsertIntoTable(denseBase_ + offset, dense_[offset]);
+            --denseCount_;
+        }
+
+        std::copy(dense_.begin() + static_cast<std::ptrdiff_t>(shift), dense_.end(), dense_.begin());
+        std::fill(dense_.end() - static_cast<std::ptrdiff_t>(shift), dense_.end(), InvalidOrderHandle);
+        denseBase_ += shift;
+    }
+
+    // IDs that had to go to the table before may be covered by the window now, they are moved over.
+    void MoveTableIntoDense()
+    {
+        if(tableSize_ == 0)
+            return;
+
+        std::vector<Bucket> moved;
+        for(const auto& bucket : buckets_)
+        {
+            if(bucket.distance_ != 0 && IsDense(bucket.key_))
+                moved.push_back(bucket);
+        }
+
+        for(const auto& bucket : moved)
+        {
+            EraseFromTable(bucket.key_);
+            dense_[bucket.key_ - denseBase_] = bucket.value_;
+            ++denseCount_;
+        }
+    }
+
+    // Returns false (and inserts nothing) if the key is already in the table. Robin Hood ordering means an existing
+    // entry is met before the probe first displaces another entry, so that is the only stretch checked.
+    bool InsertIntoTable(OrderID orderId, OrderHandle handle)
+    {
+        Bucket entry{ orderId, handle, 1 };
+        bool placing = false;
+        for(auto index = Home(orderId); ; index = (index + 1) & mask_, ++entry.distance_)
+        {
+            auto& bucket = buckets_[index];
+            if(bucket.distance_ == 0)
+            {
+                bucket = entry;
+                ++tableSize_;
+                return true;
+            }
+
+            if(!placing && bucket.key_ == orderId)
+                return false;
+
+            // Take the bucket from an entry that is closer to its home ("richer") and carry on inserting that one.
+            if(bucket.distance_ < entry.distance_)
+            {
+                std::swap(bucket, entry);
+                placing = true;
+            }
+        }
+    }
+    void Rehash(std::size_t bucketCount)
+    {
+        std::vector<Bucket> old = std::move(buckets_);
+        buckets_.assign(bucketCount, Bucket{ });
+        mask_ = bucketCount - 1;
+        shift_ = 64 - std::countr_zero(bucketCount);
+        tableSize_ = 0;
+
+        for(const auto& bucket : old)
+        {
+            if(bucket.distance_ != 0)
+                InsertIntoTable(bucket.key_, bucket.value_);
+        }
+    }
+};
@@ -0,0 +1,214 @@
+// Puts an OrderIndex through keys picked to collide on the same home slot, erases from the middle of their runs and
+// checks what backward shift leaves behind, grows the table past its load factor, and moves the dense window: IDs
+// below it, a stray huge ID, and cancels that let it slide forward. Random sessions of inserts and erases are then
+// compared with a std::map, with and without the dense window.
+//
+//     OrderIndexTest
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "OrderIndex.h"
+#include "TestCheck.h"
+
+namespace
+{
+    bool Matches(const OrderIndex& index, const std::map<OrderID, OrderHandle>& expected)
+    {
+        if(index.Size() != expected.size())
+            return false;
+
+        for(const auto& [orderId, handle] : expected)
+        {
+            if(index.Find(orderId) != handle)
+                return false;
+        }
+
+        std::size_t visited{ };
+        bool known = true;
+        index.ForEach([&](OrderID orderId, OrderHandle handle)
+        {
+            const auto entry = expected.find(orderId);
+            known = known && entry != expected.end() && entry->second == handle;
+            ++visited;
+        });
+        return known && visited == expected.size();
+    }
+
+    // IDs whose home is 'home' in a table of 16 buckets, found with the index's own Fibonacci hash.
+    std::vector<OrderID> Colliding(std::size_t home, std::size_t count)
+    {
+        std::vector<OrderID> orderIds;
+        for(OrderID orderId = 1; orderIds.size() < count; ++orderId)
+        {
+            if(((orderId * 0x9E3779B97F4A7C15ull) >> 60) == home)
+                orderIds.push_back(orderId);
+        }
+        return orderIds;
+    }
+
+    void CollisionsAndBackwardShift()
+    {
+        // Eleven entries keep a 16 bucket table under its load factor, so the probe chains stay as built. Homes 14
+        // and 15 make the chains wrap around the end of the table.
+        for(const std::size_t home : { std::size_t{ 3 }, std::size_t{ 14 }, std::size_t{ 15 } })
+        {
+            OrderIndex index;
+            std::map<OrderID, OrderHandle> expected;
+            const auto chain = Colliding(home, 6);
+            const auto neighbours = Colliding((home + 2) % 16, 5);
+
+            OrderHandle handle{ };
+            for(const auto orderId : chain)
+                expected[orderId] = handle, index.Insert(orderId, handle++);
+            for(const auto orderId : neighbours)
+                expected[orderId] = handle, index.Insert(orderId, handle++);
+            Check(Matches(index, expected), "colliding keys are all found");
+            Check(!index.Insert(chain[4], 99) && index.Find(chain[4]) == expected[chain[4]], "a duplicate deep in a chain is refused");
+
+            // Erase from the middle, the head and the end of the chain, every entry behind must still be reachable.
+            for(const auto position : { 2, 0, 5 })
+            {
+                Check(index.Erase(chain[position]) == expected[chain[position]], "erase returns the handle");
+                expected.erase(chain[position]);
+                Check(index.Find(chain[position]) == InvalidOrderHandle, "an erased key is gone");
+                Check(Matches(index, expected), "backward shift keeps the rest of the chain reachable");
+            }
+            Check(index.Erase(chain[2]) == InvalidOrderHandle, "erasing a missing key returns InvalidOrderHandle");
+
+            // Put them back, the shifted entries must not hide the holes they left.
+            for(const auto position : { 0, 2, 5 })
+                expected[chain[position]] = handle, index.Insert(chain[position], handle++);
+            Check(Matches(index, expected), "reinserted keys are found next to the shifted ones");
+        }
+    }
+
+    void TableGrows()
+    {
+        OrderIndex index;
+        const auto initialMemory = index.MemoryUsage();
+        std::map<OrderID, OrderHandle> expected;
+
+        // Scattered IDs far apart, so all of them live in the table.
+        std::mt19937_64 random{ 7 };
+        while(expected.size() < 50'000)
+        {
+            const auto orderId = random();
+            const auto handle = static_cast<OrderHandle>(expected.size());
+            if(expected.emplace(orderId, handle).second)
+                Check(index.Insert(orderId, handle), "a new key is inserted");
+        }
+
+        Check(index.MemoryUsage() > initialMemory, "the table grows past its load factor");
+        Check(Matches(index, expected), "every key survives the rehashes");
+    }
+
+    void DenseWindow()
+    {
+        OrderIndex index{ 0, true, 1'000 };
+        std::map<OrderID, OrderHandle> expected;
+        const auto insert = [&](OrderID orderId, OrderHandle handle)
+        {
+            expected[orderId] = handle;
+            Check(index.Insert(orderId, handle), "a new key is inserted");
+        };
+
+        for(OrderID orderId = 1'000; orderId < 3'000; ++orderId)
+            insert(orderId, static_cast<OrderHandle>(orderId));
+
+        // IDs below the window and a stray huge one go to the table, without growing the window.
+        const auto windowMemory = index.MemoryUsage();
+        insert(10, 10);
+        insert(999, 999);
+        insert(std::uint64_t{ 1 } << 60, 7);
+        Check(index.MemoryUsage() < windowMemory + 1024 * sizeof(OrderHandle), "a stray ID does not blow up the window");
+        Check(!index.Insert(1'500, 1) && !index.Insert(999, 1), "duplicates are refused in the window and in the table");
+        Check(Matches(index, expected), "the window and the table hold everything");
+
+        // A long session where orders are cancelled a little behind the newest one: the window slides along, the few
+        // old orders left behind move to the table, and memory follows the live span rather than every ID ever seen.
+        for(OrderID orderId = 3'000; orderId < 1'000'000; ++orderId)
+        {
+            insert(orderId, static_cast<OrderHandle>(orderId));
+            const auto cancelled = orderId - 2'000;
+            if(cancelled % 5'000 != 0 && expected.contains(cancelled))
+            {
+                Check(index.Erase(cancelled) == static_cast<OrderHandle>(cancelled), "erase returns the handle");
+                expected.erase(cancelled);
+            }
+        }
+        Check(Matches(index, expected), "sliding keeps every live order reachable");
+        Check(index.MemoryUsage() < 64 * 1024 * sizeof(OrderHandle), "the window follows the live IDs");
+
+        // Clear keeps nothing, and the index is usable again straight away.
+        index.Clear();
+        expected.clear();
+        Check(Matches(index, expected) && index.Find(999'999) == InvalidOrderHandle, "Clear removes every entry");
+        for(OrderID orderId = 5'000'000; orderId < 5'010'000; ++orderId)
+            insert(orderId, static_cast<OrderHandle>(orderId & 0xFFFF));
+        insert(42, 42);
+        Check(Matches(index, expected), "a cleared index starts over at the next IDs");
+    }
+
+    void RandomSessions(bool denseIds)
+    {
+        std::mt19937_64 random{ denseIds ? 11u : 13u };
+        OrderIndex index{ 0, denseIds, 1 };
+        std::map<OrderID, OrderHandle> expected;
+        OrderID nextId = 1;
+
+        for(int step = 0; step < 400'000; ++step)
+        {
+            const auto action = random() % 10;
+            if(action < 5)
+            {
+                // Mostly sequential IDs, with the odd out of order or far away one.
+                OrderID orderId = nextId++;
+                if(random() % 50 == 0)
+                    orderId = random() % (nextId + 1);
+                else if(random() % 200 == 0)
+                    orderId = random();
+
+                const auto handle = static_cast<OrderHandle>(random() % InvalidOrderHandle);
+                const bool inserted = expected.emplace(orderId, handle).second;
+                if(index.Insert(orderId, handle) != inserted)
+                    Check(false, "Insert reports whether the key was new");
+            }
+            else if(action < 9 && !expected.empty())
+            {
+                // Cancel one of the live orders, mostly among the older ones.
+                auto entry = expected.lower_bound(random() % nextId);
+                if(entry == expected.end())
+                    entry = expected.begin();
+                if(index.Erase(entry->first) != entry->second)
+                    Check(false, "Erase returns the handle of a live key");
+                expected.erase(entry);
+            }
+            else
+            {
+                const auto orderId = random() % (nextId + 10);
+                const auto entry = expected.find(orderId);
+                if(index.Find(orderId) != (entry != expected.end() ? entry->second : InvalidOrderHandle))
+                    Check(false, "Find agrees with a std::map");
+            }
+
+            if(step % 50'000 == 0)
+                Check(Matches(index, expected), "the index agrees with a std::map");
+        }
+        Check(Matches(index, expected), "the index agrees with a std::map at the end");
+    }
+}
+
+
+int main()
+{
+    CollisionsAndBackwardShift();
+    TableGrows();
+    DenseWindow();
+    RandomSessions(false);
+    RandomSessions(true);
+
+    return CheckResult("order index");
+}
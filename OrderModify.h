@@ -21,7 +21,13 @@ public:
 
     OrderPointer ToOrderPointer(OrderType type) const
     {
-        return std::make_shared<Order>(type, GetOrderId(), GetSide(), GetPrice(), GetQuantity());
+        return std::make_shared<Order>(ToOrder(type));
+    }
+
+    // The modified order keeps the account of the order it replaces, which the book passes in.
+    Order ToOrder(OrderType type, AccountID accountId = NoAccount) const
+    {
+        return Order{ type, GetOrderId(), GetSide(), GetPrice(), GetQuantity(), accountId };
     }
 
 private:
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "Order.h"
+#include "OrderRecord.h"
+
+// A list of orders linked through their slots, such as the GoodForDay orders of a book waiting for the close.
+struct OrderList
+{
+    OrderHandle head_{ InvalidOrderHandle };
+    OrderHandle tail_{ InvalidOrderHandle };
+
+    bool Empty() const { return head_ == InvalidOrderHandle; }
+};
+
+/*
+** OrderPool is a slab of order slots with a free list, so adding an order is popping a free slot and cancelling
+   or filling an order is pushing the slot back. No heap allocation and no reference counting on the hot path.
+** Every slot is a 32-byte OrderRecord, the whole slab is one contiguous array.
+** Reserve() preallocates the slots up front so that a trading session never has to touch the global allocator.
+*/
+class OrderPool
+{
+public:
+    void Reserve(std::size_t capacity)
+    {
+        if(capacity <= slots_.size())
+            return;
+
+        // The new slots are pushed on the free list back to front so that they get handed out in index order.
+        const auto first = slots_.size();
+        slots_.resize(capacity);
+        for(auto handle = capacity; handle-- > first; )
+            Release(static_cast<OrderHandle>(handle));
+    }
+
+    OrderHandle Allocate(const Order& order)
+    {
+        if(freeHead_ == InvalidOrderHandle)
+        {
+            // Running past the reserved capacity is allowed, it just costs a (rare) reallocation of the slab.
+            slots_.emplace_back();
+            Release(static_cast<OrderHandle>(slots_.size() - 1));
+        }
+
+        const auto handle = freeHead_;
+        auto& slot = slots_[handle];
+        freeHead_ = slot.next_;
+
+        slot = OrderRecord{ order };
+        ++size_;
+        return handle;
+    }
+
+    void Free(OrderHandle handle)
+    {
+        Release(handle);
+        --size_;
+    }
+
+    OrderRecord& Get(OrderHandle handle) { return slots_[handle]; }
+    const OrderRecord& Get(OrderHandle handle) const { return slots_[handle]; }
+
+    OrderHandle Next(OrderHandle handle) const { return slots_[handle].next_; }
+
+    std::size_t Size() const { return size_; }
+    std::size_t Capacity() const { return slots_.size(); }
+
+    // Every slot counts, whether it holds an order or is waiting on the free list.
+    std::size_t MemoryUsage() const { return slots_.capacity() * sizeof(OrderRecord); }
+
+    // Appends the order to the back of the list.
+    void PushBack(OrderList& list, OrderHandle handle)
+    {
+        auto& slot = slots_[handle];
+        slot.prev_ = list.tail_;
+        slot.next_ = InvalidOrderHandle;
+
+        if(list.tail_ == InvalidOrderHandle)
+            list.head_ = handle;
+        else
+            slots_[list.tail_].next_ = handle;
+
+        list.tail_ = handle;
+    }
+
+    // Unlinks the order from anywhere in the list in O(1), its neighbours are found through its own slot.
+    void Erase(OrderList& list, OrderHandle handle)
+    {
+        const auto prev = slots_[handle].prev_;
+        const auto next = slots_[handle].next_;
+
+        if(prev == InvalidOrderHandle)
+            list.head_ = next;
+        else
+            slots_[prev].next_ = next;
+
+        if(next == InvalidOrderHandle)
+            list.tail_ = prev;
+        else
+            slots_[next].prev_ = prev;
+    }
+
+private:
+    std::vector<OrderRecord> slots_;
+    OrderHandle freeHead_{ InvalidOrderHandle };
+    std::size_t size_{ };
+
+    void Release(OrderHandle handle)
+    {
+        slots_[handle].next_ = freeHead_;
+        freeHead_ = handle;
+    }
+};
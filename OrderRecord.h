@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <exception>
+#include <format>
+
+#include "Order.h"
+
+/*
+** An OrderHandle is the index of an order's slot inside the OrderPool.
+** Unlike a pointer it stays the same when the pool grows, and it is only 4 bytes wide.
+*/
+using OrderHandle = std::uint32_t;
+constexpr OrderHandle InvalidOrderHandle = std::numeric_limits<OrderHandle>::max();
+
+/*
+** OrderRecord is how a resting order is stored in the OrderPool: 32 bytes, so two orders share a cache line.
+** The order type and side are packed into the top bits of the word holding the order's position in the queue of its
+   price level (see LevelQueue), and the links of the GoodForDay list it may be in are handles rather than pointers.
+** It answers the same questions as the Order it was made from, ToOrder() gives that Order back.
+*/
+class OrderRecord
+{
+public:
+    // A queue position has 28 bits, a level can queue more than 100 million orders before running out.
+    static constexpr std::uint32_t MaxQueuePosition = (std::uint32_t{ 1 } << 28) - 1;
+
+    OrderRecord() = default;
+    explicit OrderRecord(const Order& order)
+        : orderId_{ order.GetOrderId() }
+        , price_{ order.GetPrice() }
+        , initialQuantity_{ order.GetInitialQuantity() }
+        , remainingQuantity_{ order.GetRemainingQuantity() }
+        , packed_{ static_cast<std::uint32_t>(order.GetOrderType()) << TypeShift | static_cast<std::uint32_t>(order.GetSide()) << SideShift }
+    { }
+
+    OrderType GetOrderType() const { return static_cast<OrderType>(packed_ >> TypeShift & TypeMask); }
+    OrderID GetOrderId() const { return orderId_; }
+    Side GetSide() const { return static_cast<Side>(packed_ >> SideShift); }
+    Price GetPrice() const { return price_; }
+    Quantity GetInitialQuantity() const { return initialQuantity_; }
+    Quantity GetRemainingQuantity() const { return remainingQuantity_; }
+    Quantity GetFilledQuantity() const { return GetInitialQuantity() - GetRemainingQuantity(); }
+    bool isFilled() const { return GetRemainingQuantity() == 0; }
+
+    void Fill(Quantity quantity)
+    {
+        if(quantity > GetRemainingQuantity())
+            throw std::logic_error(std::format("Order ({}) cannot be filled for more than its remaining quantity.", GetOrderId()));
+
+        remainingQuantity_ -= quantity;
+    }
+
+    // Amend-down, see Order::ReduceQuantity().
+    void ReduceQuantity(Quantity quantity)
+    {
+        if(quantity == 0 || quantity > GetRemainingQuantity())
+            throw std::logic_error(std::format("Order ({}) can only be reduced to a quantity between 1 and its remaining quantity.", GetOrderId()));
+
+        initialQuantity_ = quantity;
+        remainingQuantity_ = quantity;
+    }
+
+    std::uint32_t GetQueuePosition() const { return packed_ & MaxQueuePosition; }
+    void SetQueuePosition(std::uint32_t position) { packed_ = (packed_ & ~MaxQueuePosition) | position; }
+
+    // The account isn't kept in the record, the book passes it in (see RiskGate).
+    Order ToOrder(AccountID accountId = NoAccount) const
+    {
+        Order order{ GetOrderType(), orderId_, GetSide(), price_, initialQuantity_, accountId };
+        order.Fill(GetFilledQuantity());
+        return order;
+    }
+
+private:
+    friend class OrderPool;
+
+    static constexpr std::uint32_t TypeShift = 28;
+    static constexpr std::uint32_t TypeMask = 0x7;
+    static constexpr std::uint32_t SideShift = 31;
+
+    OrderID orderId_{ };
+    Price price_{ };
+    Quantity initialQuantity_{ };
+    Quantity remainingQuantity_{ };
+    std::uint32_t packed_{ };                           // Bits 0-27 queue position, 28-30 OrderType, 31 Side.
+    OrderHandle prev_{ InvalidOrderHandle };
+    OrderHandle next_{ InvalidOrderHandle };            // Also links the pool's free list while the slot is unused.
+};
+
+static_assert(sizeof(OrderRecord) == 32, "An OrderRecord must stay 32 bytes, two to a cache line.");
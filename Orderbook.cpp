@@ -1,122 +1,249 @@
 #include "Orderbook.h"
+#include "CommandJournal.h"
+#include "TradeLog.h"
 
-#include <numeric>
-#include <chrono>
-#include <ctime>
+#include <algorithm>
+#include <exception>
+#include <format>
 
-void Orderbook::PruneGoodForDayOrders()
+template<typename MatchingPolicy>
+std::size_t BasicOrderbook<MatchingPolicy>::ExpireGoodForDayOrdersInternal(OrderIDs* orderIds)
 {
-    using namespace std::chrono;
-    const auto end = hours(16);
+    // Only the GoodForDay orders are visited, the rest of the book isn't touched however big it is.
+    std::size_t expired{ };
+    for(auto handle = goodForDayOrders_.head_; handle != InvalidOrderHandle; ++expired)
+    {
+        const auto next = pool_.Next(handle);
+        const auto orderId = pool_.Get(handle).GetOrderId();
+        CancelOrderInternal(orderId);
+        if(orderIds)
+            orderIds->push_back(orderId);
+        handle = next;
+    }
 
-        while(true)
-        {
-            const auto now = system_clock::now(); // returns the time as a 'time_point' object, which is not human-readable.
-            const auto now_c = system_clock::to_time_t(now);  // converts 'now' into a 'std::time_t' which is more of a traditional way.(Number of seconds since Unix epoch: January 1, 1970) 
-            std::tm now_parts;
-            localtime_s(&now_parts, &now_c);  // Converts the 'now_c' from std::time_t to 'now_parts' which is std::tm (basically splits into components like year, month, day, hours, min, sec). 
-        
-            if(now_parts.tm_hour >= end.count())
-                now_parts.tm_mday += 1;
-            
-            now_parts.tm_hour = end.count();
-            now_parts.tm_min = 0;
-            now_parts.tm_sec = 0;
+    return expired;
+}
 
-            auto next = system_clock::from_time_t(mktime(&now_parts));
-            auto till = next - now + milliseconds(100);
 
-            {
-                std::unique_lock ordersLock { ordersMutex_ };  // unique_lock acquires the lock right away
+template<typename MatchingPolicy>
+bool BasicOrderbook<MatchingPolicy>::MakeQueueRoom(PriceLevel& level)
+{
+    return level.orders_.MakeRoom(OrderRecord::MaxQueuePosition,
+        [this](OrderHandle moved, LevelQueue::Position newPosition) { pool_.Get(moved).SetQueuePosition(newPosition); });
+}
 
-                if(shutdown_.load(std::memory_order_acquire) || 
-                        shutdownConditionVariable_.wait_for(ordersLock, till) == std::cv_status::no_timeout)
-                        return;
-            }
 
-            OrderIDs orderIds;
-            
-            {
-                std::scoped_lock ordersLock{ ordersMutex_};
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::Enqueue(PriceLevel& level, OrderHandle handle)
+{
+    // Making room in the queue may move the orders already in it, their slots are told their new positions.
+    const auto position = level.orders_.PushBack(handle, pool_.Get(handle).GetRemainingQuantity(),
+        [this](OrderHandle moved, LevelQueue::Position newPosition) { pool_.Get(moved).SetQueuePosition(newPosition); });
+    pool_.Get(handle).SetQueuePosition(position);
+}
 
-                for(const auto& [_, entry] : orders_)
-                {
-                    const auto& [order, _] = entry;
-                    if(order->GetOrderType() != OrderType::GoodForDay)
-                        continue;
-                    
-                    orderIds.push_back(order->GetOrderId());
-                }
-            }
 
-            CancelOrders(orderIds);                
-        }
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::ReleaseOrder(OrderHandle handle)
+{
+    if(pool_.Get(handle).GetOrderType() == OrderType::GoodForDay)
+        pool_.Erase(goodForDayOrders_, handle);
+
+    risk_.OnReleased(handle);
+    pool_.Free(handle);
+}
+
+        
+template<typename MatchingPolicy>
+bool BasicOrderbook<MatchingPolicy>::CancelOrderInternal(OrderID orderId)
+{
+    // A single probe of the index both finds and removes the order.
+    const auto handle = orders_.Erase(orderId);
+    if(handle == InvalidOrderHandle)
+        return false;
+
+    if(pool_.Get(handle).GetSide() == Side::Buy)
+        RemoveOrder<Side::Buy>(handle);
+    else
+        RemoveOrder<Side::Sell>(handle);
+
+    return true;
 }
 
 
-void Orderbook::CancelOrders(OrderIDs orderIds)
+template<typename MatchingPolicy>
+template<Side S>
+void BasicOrderbook<MatchingPolicy>::RemoveOrder(OrderHandle handle)
 {
-    std::scoped_lock ordersLock{ ordersMutex_ };
-    for(const auto& orderId : orderIds)
-        CancelOrderInternal(orderId);
+    // The order's price takes us straight to its level in the ladder of its side.
+    const auto& order = pool_.Get(handle);
+    auto& ladder = GetLadder<S>();
+    const auto index = ladder.Find(order.GetPrice());
+    auto& level = ladder.LevelAt(index);
+
+    if(!sinks_.empty())
+        Publish(OrderbookEvent{ .type_ = EventType::OrderCancelled, .side_ = S, .orderType_ = order.GetOrderType(),
+            .orderId_ = order.GetOrderId(), .price_ = order.GetPrice(), .quantity_ = order.GetRemainingQuantity() });
+
+    level.orders_.Erase(pool_.Get(handle).GetQueuePosition());
+    OnOrderCancelled(level, order);
+    risk_.OnRemoved(handle, order.GetPrice(), order.GetRemainingQuantity());
+    ReleaseOrder(handle);
+
+    if(level.orders_.Empty())
+        ladder.Erase(index);
 }
 
-        
-void Orderbook::CancelOrderInternal(OrderID orderId)
+
+template<typename MatchingPolicy>
+CommandStatus BasicOrderbook<MatchingPolicy>::MassCancelInternal(const MassCancelFilter& filter, std::size_t& cancelled, OrderIDs* orderIds)
 {
-    if(!orders_.contains(orderId))
-        return;
-    
-    const auto& [order, iterator] = orders_.at(orderId);
-    orders_.erase(orderId);
+    constexpr auto Lowest = std::numeric_limits<Price>::min();
+    constexpr auto Highest = std::numeric_limits<Price>::max();
 
-    if(order->GetSide() == Side::Buy)
+    switch(filter.scope_)
     {
-        auto price = order->GetPrice();
-        auto& orders = bids_.at(price);
-        orders.erase(iterator);
-        if(orders.empty())
-            bids_.erase(price);
+    case MassCancelScope::All:
+        // With nothing left on the book, the GoodForDay list is dropped whole instead of being unlinked order by order.
+        cancelled = CancelLevels<Side::Buy>(Highest, Lowest, orderIds, true) + CancelLevels<Side::Sell>(Lowest, Highest, orderIds, true);
+        goodForDayOrders_ = OrderList{ };
+        return CommandStatus::Accepted;
+    case MassCancelScope::OneSide:
+        cancelled = filter.side_ == Side::Buy ? CancelLevels<Side::Buy>(Highest, Lowest, orderIds) : CancelLevels<Side::Sell>(Lowest, Highest, orderIds);
+        return CommandStatus::Accepted;
+    case MassCancelScope::PriceRange:
+        if(filter.lowPrice_ > filter.highPrice_)
+            return CommandStatus::Rejected;
+
+        cancelled = filter.side_ == Side::Buy ? CancelLevels<Side::Buy>(filter.highPrice_, filter.lowPrice_, orderIds)
+            : CancelLevels<Side::Sell>(filter.lowPrice_, filter.highPrice_, orderIds);
+        return CommandStatus::Accepted;
+    case MassCancelScope::Account:
+        if(!risk_.Enabled() || filter.accountId_ == NoAccount)
+            return CommandStatus::Rejected;
+
+        // The account's orders are spread over many levels, they are cancelled one by one but none other is visited.
+        for(auto handle = risk_.FirstOrder(filter.accountId_); handle != InvalidOrderHandle; ++cancelled)
+        {
+            const auto next = risk_.NextOrder(handle);
+            const auto orderId = pool_.Get(handle).GetOrderId();
+            if(orderIds)
+                orderIds->push_back(orderId);
+
+            orders_.Erase(orderId);
+            if(pool_.Get(handle).GetSide() == Side::Buy)
+                RemoveOrder<Side::Buy>(handle);
+            else
+                RemoveOrder<Side::Sell>(handle);
+            handle = next;
+        }
+        return CommandStatus::Accepted;
     }
-    else
+
+    return CommandStatus::Rejected;
+}
+
+
+template<typename MatchingPolicy>
+template<Side S>
+std::size_t BasicOrderbook<MatchingPolicy>::CancelLevels(Price from, Price to, OrderIDs* orderIds, bool wholeBook)
+{
+    auto& ladder = GetLadder<S>();
+    std::size_t cancelled{ };
+    for(auto index = ladder.FindAtOrWorse(from); index != ladder.npos && !SideTraits<S>::IsBetter(to, ladder.PriceAt(index)); )
     {
-        auto price = order->GetPrice();
-        auto& orders = asks_.at(price);
-        orders.erase(iterator);
-        if(orders.empty())
-            asks_.erase(price);
+        const auto next = ladder.NextWorse(index);
+        cancelled += CancelLevel<S>(index, orderIds, wholeBook);
+        index = next;
     }
 
-    OnOrderCancelled(order);
+    return cancelled;
 }
 
 
-void Orderbook::OnOrderCancelled(OrderPointer order)
+template<typename MatchingPolicy>
+template<Side S>
+std::size_t BasicOrderbook<MatchingPolicy>::CancelLevel(std::size_t index, OrderIDs* orderIds, bool wholeBook)
 {
-    UpdateLevelData(order->GetPrice(), order->GetRemainingQuantity(), LevelData::Action::Remove);
+    auto& ladder = GetLadder<S>();
+    auto& level = ladder.LevelAt(index);
+    const auto price = ladder.PriceAt(index);
+
+    // Every order goes back to the pool and out of the index, but the level's queue is dropped in one go. When the
+    // whole book goes the GoodForDay list and the account lists go with it, so the orders aren't unlinked from them.
+    const auto cancelled = level.orders_.Size();
+    for(const auto handle : level.orders_.Handles())
+    {
+        if(handle == InvalidOrderHandle)
+            continue;
+
+        const auto& order = pool_.Get(handle);
+        if(!sinks_.empty())
+            Publish(OrderbookEvent{ .type_ = EventType::OrderCancelled, .side_ = S, .orderType_ = order.GetOrderType(),
+                .orderId_ = order.GetOrderId(), .price_ = price, .quantity_ = order.GetRemainingQuantity() });
+
+        if(orderIds)
+            orderIds->push_back(order.GetOrderId());
+
+        orders_.Erase(order.GetOrderId());
+        if(wholeBook)
+        {
+            risk_.OnCleared(handle);
+            pool_.Free(handle);
+        }
+        else
+        {
+            risk_.OnRemoved(handle, price, order.GetRemainingQuantity());
+            ReleaseOrder(handle);
+        }
+    }
+
+    UpdateLevelData(S, price, level, level.data_.quantity_, LevelData::Action::Remove, level.data_.count_);
+    ladder.Erase(index);
+    return cancelled;
+}
+
+
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::OnOrderCancelled(PriceLevel& level, const OrderRecord& order)
+{
+    UpdateLevelData(order.GetSide(), order.GetPrice(), level, order.GetRemainingQuantity(), LevelData::Action::Remove);
 }
 
-void Orderbook::OnOrderAdded(OrderPointer order)
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::OnOrderAdded(PriceLevel& level, const OrderRecord& order)
 {
-    UpdateLevelData(order->GetPrice(), order->GetInitialQuantity(), LevelData::Action::Add);
+    UpdateLevelData(order.GetSide(), order.GetPrice(), level, order.GetInitialQuantity(), LevelData::Action::Add);
 }
 
-void Orderbook::OnOrderMatched(Price price, Quantity quantity, bool isFullyFilled)
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::OnOrderMatched(PriceLevel& level, const OrderRecord& order, Quantity quantity)
 {   
     // Updates according to FullyFilled or Not.
-    UpdateLevelData(price, quantity, isFullyFilled ? LevelData::Action::Remove : LevelData::Action::Match);
+    UpdateLevelData(order.GetSide(), order.GetPrice(), level, quantity, order.isFilled() ? LevelData::Action::Remove : LevelData::Action::Match);
 }
 
-void Orderbook::UpdateLevelData(Price price, Quantity quantity, LevelData::Action action)
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::OnOrderReduced(PriceLevel& level, const OrderRecord& order, Quantity quantity)
 {
-    // We get the LevelData for the specific price 
-    auto& data = data_[price];
+    // The order is still resting, so for the level this is the same as a partial match.
+    UpdateLevelData(order.GetSide(), order.GetPrice(), level, quantity, LevelData::Action::Match);
+}
+
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::UpdateLevelData(Side side, Price price, PriceLevel& level, Quantity quantity, LevelData::Action action, Quantity orders)
+{
+    // The LevelData lives inline in the PriceLevel slot, so there is no separate lookup for it anymore.
+    auto& data = level.data_;
 
     // We change the total count of orders on that specific price level according to the 'Action'
     // Match --> We do not change anything in this case as it might be possible that the order wasnt fully matched.
-    // Add --> We add 1 to the count of orders. (In the case of AddOrder() ).
-    // Remove --> We reduce the count of orders by 1. (In the case of CancelOrder() ). 
-    data.count_ += action == LevelData::Action::Remove ? -1 : action == LevelData::Action::Add ? 1 : 0 ;
+    // Add --> We add 'orders' (1 in the case of AddOrder() ) to the count of orders.
+    // Remove --> We reduce the count by 'orders', 1 for a CancelOrder() and every order a sweep filled for MatchOrders().
+    if(action == LevelData::Action::Remove)
+        data.count_ -= orders;
+    else if(action == LevelData::Action::Add)
+        data.count_ += orders;
     
     // Similar implementation for the quantity of the price level
     if(action == LevelData::Action::Remove || action == LevelData::Action::Match)
@@ -128,286 +255,995 @@ void Orderbook::UpdateLevelData(Price price, Quantity quantity, LevelData::Actio
         data.quantity_ += quantity;
     }
 
-    // In case there are no orders left for that particular price level we delete the price level.
-    if(data.count_ == 0)
-        data_.erase(price);
+    // The price level itself is released by the caller once its order list becomes empty.
+
+    // The running aggregate is all the market data needs, the orders of the level are never walked for it.
+    const auto l2Action = data.count_ == 0 ? L2Action::Removed : action == LevelData::Action::Add && data.count_ == 1 ? L2Action::Added : L2Action::Changed;
+    marketData_.OnLevelChanged(side, price, data.quantity_, data.count_, l2Action, level.pendingUpdate_);
+
+    if(l2Action == L2Action::Added)
+        metrics_.Count(MetricCounter::LevelsCreated);
+    else if(l2Action == L2Action::Removed)
+        metrics_.Count(MetricCounter::LevelsDestroyed);
+
+    if(!sinks_.empty())
+        Publish(OrderbookEvent{ .type_ = EventType::LevelChanged, .side_ = side, .price_ = price, .quantity_ = data.quantity_, .count_ = data.count_ });
 }
-   
 
-// This function is to check if we can Fully Fill an order on the buy or sell side on a given pricelevel.
-// The main goal is to asses whether there is enough liquidity  in the order book at the relevant price levels 
-// satisfy the quantity requested by the order.
-bool Orderbook::CanFullyFill(Side side, Price price, Quantity quantity) const
+
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::OnBookChanged()
 {
-    if(!CanMatch(side, price))
-        return false;
-    
-    std::optional<Price> threshold;
+    marketData_.RefreshDepth(bids_, asks_);
+    metrics_.SetDepth(orders_.Size(), bids_.LevelCount(), asks_.LevelCount());
 
-    if(side == Side::Buy)
+    // Most operations leave the best levels alone, the readers' cache line is only written when they changed.
+    TopOfBook top;
+    ReadTop<Side::Buy>(top.bidPrice_, top.bidQuantity_, top.bidCount_);
+    ReadTop<Side::Sell>(top.askPrice_, top.askQuantity_, top.askCount_);
+    if(!top.SameLevels(publishedTop_))
     {
-        const auto [bestAskPrice, _] = *asks_.begin();
-        threshold = bestAskPrice;
+        top.sequence_ = marketData_.GetSequence();
+        topOfBook_.Publish(top);
+        publishedTop_ = top;
     }
-    else
+}
+
+
+template<typename MatchingPolicy>
+template<Side S>
+void BasicOrderbook<MatchingPolicy>::ReadTop(Price& price, Quantity& quantity, Quantity& count) const
+{
+    const auto& ladder = GetLadder<S>();
+    if(ladder.Empty())
     {
-        const auto [bestbidPrice, _] = *bids_.begin();
-        threshold = bestbidPrice;
+        price = 0;
+        quantity = count = 0;
+        return;
     }
 
-    for(const auto& [levelPrice, levelData] : data_)
+    const auto index = ladder.Best();
+    const auto& data = ladder.LevelAt(index).data_;
+    price = ladder.PriceAt(index);
+    quantity = data.quantity_;
+    count = data.count_;
+}
+
+
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::Publish(const OrderbookEvent& event) const
+{
+    for(const auto& sink : sinks_)
+        sink(event);
+}
+   
+
+// This function is to check if we can Fully Fill an order on the buy or sell side on a given pricelevel.
+// The main goal is to asses whether there is enough liquidity  in the order book at the relevant price levels 
+// satisfy the quantity requested by the order.
+template<typename MatchingPolicy>
+template<Side S>
+bool BasicOrderbook<MatchingPolicy>::CanFullyFill(Price price, Quantity quantity) const
+{
+    return AvailableLiquidityInternal<S>(price, quantity) >= quantity;
+}
+
+
+template<typename MatchingPolicy>
+template<Side S>
+Quantity BasicOrderbook<MatchingPolicy>::AvailableLiquidityInternal(Price limitPrice, Quantity maxQuantity) const
+{
+    // We walk the opposite side of the book from its best price towards the limit price, the occupancy bitmap
+    // skips the empty ticks, and each level is counted through its LevelData without touching its orders.
+    const auto& ladder = GetLadder<SideTraits<S>::Opposite>();
+
+    Quantity available{ };
+    for(auto index = ladder.Best(); index != ladder.npos && available < maxQuantity; index = ladder.NextWorse(index))
     {
-        if(threshold.has_value() && 
-            (side == Side::Buy && threshold.value() > levelPrice) ||
-            (side == Side::Sell && threshold.value() < levelPrice))
-            continue;
-        
-        if((side == Side::Buy && levelPrice > price) ||
-            (side == Side::Sell &&  levelPrice < price))
-            continue;
-        
-        if(quantity <= levelData.quantity_)
-            return true;
-        
-        quantity -= levelData.quantity_;
+        if(!SideTraits<S>::Crosses(limitPrice, ladder.PriceAt(index)))
+            break;
+
+        // Clamped so that adding up a deep book can never overflow the Quantity.
+        available += std::min(ladder.LevelAt(index).data_.quantity_, maxQuantity - available);
     }
 
-    return false;
+    return available;
 }
 
 
 
    
-bool Orderbook::CanMatch(Side side, Price price) const
+template<typename MatchingPolicy>
+template<Side S>
+bool BasicOrderbook<MatchingPolicy>::CanMatch(Price price) const
 {
-    if(side == Side::Buy)
-    {
-        if(asks_.empty())
-            return false;
-        
-        /*
-        ** The following line returns the pair {Price, OrderPointers}, 'bestAsk' represents the Price in the pair and '_' underscore represents the OrderPointers. 
-        ** Using _ is a common convention for "unused variables" like the OrderPointers list here.
-        */
-        const auto& [bestAsk, _] = *asks_.begin();
-        return price >= bestAsk;   // Return 'True' if the Buy price is greater or equal to the Ask Price
-    }
-    else
-    {
-        if(bids_.empty())
-            return false;
-        
-        const auto& [bestBid, _] = *bids_.begin();
-        return price <= bestBid;  // Return 'True' if the Ask price is greater or equal to the Buy Price
-    }
+    const auto& opposite = GetLadder<SideTraits<S>::Opposite>();
+    if(opposite.Empty())
+        return false;
+
+    // The ladder gives us the index of the best level, which we turn back into its price.
+    return SideTraits<S>::Crosses(price, opposite.PriceAt(opposite.Best()));
 }
 
 
 
-Trades Orderbook::MatchOrders()
+// The trades are appended to the caller's buffer, so a batch of commands can share a single Trades vector.
+template<typename MatchingPolicy>
+template<Side S>
+void BasicOrderbook<MatchingPolicy>::MatchOrders(Trades& trades)
 {
-    Trades trades;
-    trades.reserve(orders_.size());
+    const auto timer = metrics_.TimeStep(MetricOperation::Match);
+    const auto firstTrade = trades.size();
+    std::uint64_t swept{ };
+
+    // The book was not crossed before the aggressor came in, so the aggressor is alone at the best level of its side
+    // and trades level by level through the opposite side, the MatchingPolicy sharing it out within each level.
+    auto& aggressors = GetLadder<S>();
+    auto& resting = GetLadder<SideTraits<S>::Opposite>();
 
-    while(true)
+    while(!aggressors.Empty() && !resting.Empty())
     {
-        if(bids_.empty() || asks_.empty())
-            break;
-        
-        auto& [bidPrice, bids] = *bids_.begin();
-        auto& [askPrice, asks] = *asks_.begin();
+        const auto aggressorIndex = aggressors.Best();
+        const auto restingIndex = resting.Best();
 
-        if(bidPrice < askPrice)
+        if(!SideTraits<S>::Crosses(aggressors.PriceAt(aggressorIndex), resting.PriceAt(restingIndex)))
             break;
-        
-        while(bids.size() && asks.size())
-        {
-            auto& bid = bids.front(); // 'bid' here is the topmost pointer to one of the orders in the OrderPointers list at a particular price.
-            auto& ask = asks.front(); // 'ask' here is the topmost pointer to one of the orders in the OrderPointers list at a particular price.
 
-            Quantity quantity = std::min(bid->GetRemainingQuantity(), ask->GetRemainingQuantity());
+        auto& aggressorLevel = aggressors.LevelAt(aggressorIndex);
+        auto& restingLevel = resting.LevelAt(restingIndex);
 
-            bid->Fill(quantity);
-            ask->Fill(quantity);
+        while(!aggressorLevel.orders_.Empty() && !restingLevel.orders_.Empty())
+        {
+            const auto aggressorHandle = aggressorLevel.orders_.Front();
+            auto& aggressor = pool_.Get(aggressorHandle);
+            Quantity restingFilled{ };
 
-            //Removing the 'bid' order incase it is completely filled 
-            if(bid->isFilled())
-            {
-                bids.pop_front();
-                orders_.erase(bid->GetOrderId());
-            }
-            //Removing the 'ask' order incase it is completely filled
-            if(ask->isFilled())
+            const auto allocated = MatchingPolicy::Allocate(restingLevel.orders_, restingLevel.data_.quantity_, aggressor.GetRemainingQuantity(),
+                [&](OrderHandle restingHandle, Quantity quantity)
             {
-                asks.pop_front();
-                orders_.erase(ask->GetOrderId());
-            }
+                auto& order = pool_.Get(restingHandle);
+                auto& bid = S == Side::Buy ? aggressor : order;
+                auto& ask = S == Side::Buy ? order : aggressor;
 
-            //Now finally when the trade is matched we create a 'Trade Object' and add it in the 'trades' vector
-            trades.push_back(Trade{
-                TradeInfo{ bid->GetOrderId(), bid->GetPrice(), quantity},
-                TradeInfo{ ask->GetOrderId(), ask->GetPrice(), quantity}
-                });
+                bid.Fill(quantity);
+                ask.Fill(quantity);
+                risk_.OnRemoved(aggressorHandle, aggressor.GetPrice(), quantity);
+                risk_.OnRemoved(restingHandle, order.GetPrice(), quantity);
 
-            OnOrderMatched(bid->GetPrice(), quantity, bid->isFilled());
-            OnOrderMatched(ask->GetPrice(), quantity, ask->isFilled());
-        }
+                //Now finally when the trade is matched we create a 'Trade Object' and add it in the 'trades' vector
+                const TradeInfo bidTrade{ bid.GetOrderId(), bid.GetPrice(), quantity };
+                const TradeInfo askTrade{ ask.GetOrderId(), ask.GetPrice(), quantity };
+                trades.push_back(Trade{ bidTrade, askTrade });
 
-        //Here we remove the whole 'Price Level' if we have no more orders on that price level
-            if(bids.empty())
+                if(!sinks_.empty())
+                    Publish(OrderbookEvent{ .type_ = EventType::Trade, .bidTrade_ = bidTrade, .askTrade_ = askTrade });
+
+                //Removing the resting order incase it is completely filled, its slot goes straight back to the pool
+                const auto position = pool_.Get(restingHandle).GetQueuePosition();
+                if(order.isFilled())
+                {
+                    ++restingFilled;
+                    restingLevel.orders_.Erase(position);
+                    orders_.Erase(order.GetOrderId());
+                    ReleaseOrder(restingHandle);
+                }
+                else
+                    restingLevel.orders_.SetQuantity(position, order.GetRemainingQuantity());
+            });
+
+            // The aggregates of both levels change once for everything this aggressor took, however many orders it filled.
+            UpdateLevelData(SideTraits<S>::Opposite, resting.PriceAt(restingIndex), restingLevel, allocated,
+                restingFilled != 0 ? LevelData::Action::Remove : LevelData::Action::Match, restingFilled);
+            swept += restingFilled;
+
+            // Unless the aggressor took the whole resting level it is filled by now.
+            const auto aggressorPosition = pool_.Get(aggressorHandle).GetQueuePosition();
+            if(aggressor.isFilled())
             {
-                bids_.erase(bidPrice);
-                data_.erase(bidPrice);
+                ++swept;
+                aggressorLevel.orders_.Erase(aggressorPosition);
+                UpdateLevelData(S, aggressors.PriceAt(aggressorIndex), aggressorLevel, allocated, LevelData::Action::Remove);
+                orders_.Erase(aggressor.GetOrderId());
+                ReleaseOrder(aggressorHandle);
             }
-                
-            
-            if(asks.empty())
+            else
             {
-                asks_.erase(askPrice);
-                data_.erase(askPrice);
+                aggressorLevel.orders_.SetQuantity(aggressorPosition, aggressor.GetRemainingQuantity());
+                UpdateLevelData(S, aggressors.PriceAt(aggressorIndex), aggressorLevel, allocated, LevelData::Action::Match);
             }
+        }
+
+        //Here we remove the whole 'Price Level' if we have no more orders on that price level
+        if(aggressorLevel.orders_.Empty())
+            aggressors.Erase(aggressorIndex);
+
+        if(restingLevel.orders_.Empty())
+            resting.Erase(restingIndex);
     }
 
     /*
-    * Now after the order matching loop we check if there are any orders remaining in bids and asks lists and if that particular 
-        order is of the type 'Fill&Kill' then we just cancel that order.
+    * Now after the order matching loop we check if the aggressor is still resting, and if it is of the type 'Fill&Kill'
+      then we just cancel that order. Only the aggressor can be a Fill&Kill, no such order is ever left on the book.
     */
-    if(!bids_.empty())
+    if(!aggressors.Empty())
     {
-        auto& [_, bids] = *bids_.begin();
-        auto& order = bids.front();
-        if(order->GetOrderType() == OrderType::FillAndKill)
-            CancelOrder(order->GetOrderId());
+        const auto handle = aggressors.LevelAt(aggressors.Best()).orders_.Front();
+        const auto& order = pool_.Get(handle);
+        if(order.GetOrderType() == OrderType::FillAndKill)
+        {
+            orders_.Erase(order.GetOrderId());
+            RemoveOrder<S>(handle);
+        }
     }
 
-    if((!asks_.empty()))
+    RecordTrades(std::span<const Trade>{ trades }.subspan(firstTrade), S);
+    metrics_.Count(MetricCounter::Trades, trades.size() - firstTrade);
+    metrics_.RecordSwept(swept);
+}
+
+
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::RecordTrades(std::span<const Trade> trades, Side aggressor)
+{
+    if(trades.empty())
+        return;
+
+    // One clock read and one write section for everything a command traded.
+    const auto time = tradeStatistics_.KeepsBars() || tradeLog_ ? tradeClock_() : std::chrono::system_clock::time_point{ };
+    tradeStatistics_.Begin();
+    for(const auto& trade : trades)
     {
-        auto& [_,asks] = *asks_.begin();
-        auto& order = asks.front();
-        if(order->GetOrderType() == OrderType::FillAndKill)
-            CancelOrder(order->GetOrderId());
+        const auto& restingTrade = aggressor == Side::Buy ? trade.GetAskTrade() : trade.GetBidTrade();
+        tradeStatistics_.Record(restingTrade.price_, restingTrade.quantity_, time);
     }
+    tradeStatistics_.End();
 
-    return trades;
+    // The log's writer thread does the encoding and the I/O, all the book pays is the copy into its ring.
+    if(tradeLog_)
+        tradeLog_->Append(trades, std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+}
+
+
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::ResetTradeStatistics()
+{
+    auto ordersLock = LockOrders();
+    tradeStatistics_.Begin();
+    tradeStatistics_.Reset();
+    tradeStatistics_.End();
+}
+
+template<typename MatchingPolicy>
+BasicOrderbook<MatchingPolicy>::BasicOrderbook(const OrderbookOptions& options)
+    : bids_{ options.tickSize_, options.initialLevels_, options.maxLevels_ }
+    , asks_{ options.tickSize_, options.initialLevels_, options.maxLevels_ }
+    , orders_{ options.orderCapacity_, options.denseOrderIds_, options.firstOrderId_ }
+    , risk_{ options.riskLimits_ }
+    , singleWriter_{ options.singleWriter_ }
+    , bookBuilding_{ options.bookBuilding_ }
+    , marketData_{ options.depthLevels_, options.publishL2Updates_, options.conflateL2Updates_ }
+    , tradeStatistics_{ options.tradeBarInterval_, options.tradeBarCount_ }
+    , tradeClock_{ options.tradeClock_ }
+{
+    pool_.Reserve(options.orderCapacity_);
+    risk_.Reserve(options.orderCapacity_);
 }
 
-Orderbook::Orderbook() : ordersPruneThread_{ [this] { PruneGoodForDayOrders(); } } { }
 
-Orderbook::~Orderbook()
+template<typename MatchingPolicy>
+std::unique_lock<std::mutex> BasicOrderbook<MatchingPolicy>::LockOrders() const
 {
-    shutdown_.store(true,std::memory_order_release);
-        shutdownConditionVariable_.notify_one();
-        ordersPruneThread_.join();
+    if(singleWriter_)
+    {
+        metrics_.WithoutLock();
+        return std::unique_lock<std::mutex>{ };
+    }
+
+    const auto lockStart = metrics_.BeforeLock();
+    std::unique_lock ordersLock{ ordersMutex_ };
+    metrics_.AfterLock(lockStart);
+    return ordersLock;
 }
 
     
-Trades Orderbook::AddOrder(OrderPointer order)
+template<typename MatchingPolicy>
+Trades BasicOrderbook<MatchingPolicy>::AddOrder(OrderPointer order)
+{
+    // The pointer based API is kept for existing callers, the book itself stores its own copy of the order in the pool.
+    return AddOrder(*order);
+}
+
+
+template<typename MatchingPolicy>
+Trades BasicOrderbook<MatchingPolicy>::AddOrder(Order order)
+{
+    auto ordersLock = LockOrders();
+    const auto timer = metrics_.Time(MetricOperation::AddOrder);
+    Trades trades;
+    ApplyCommandInternal(OrderCommand::Add(order), trades);
+    OnBookChanged();
+    return trades;
+}
+
+
+template<typename MatchingPolicy>
+CommandStatus BasicOrderbook<MatchingPolicy>::AddOrderInternal(Order order, Trades& trades)
+{
+    return order.GetSide() == Side::Buy ? AddOrder<Side::Buy>(order, trades) : AddOrder<Side::Sell>(order, trades);
+}
+
+
+template<typename MatchingPolicy>
+template<Side S>
+CommandStatus BasicOrderbook<MatchingPolicy>::AddOrder(Order order, Trades& trades)
 {
     //Making sure we dont have duplicate orders
-    if( orders_.contains(order->GetOrderId()))
-        return { };
+    if(orders_.Find(order.GetOrderId()) != InvalidOrderHandle)
+        return CommandStatus::Rejected;
 
     // Till now the market orders are being executed at the worst price available
-    if(order->GetOrderType() == OrderType::Market)
+    if(order.GetOrderType() == OrderType::Market)
     {
-        if(order->GetSide() == Side::Buy && !asks_.empty())
-        {
-            const auto& [worstAsk, _] = *asks_.rbegin();
-            order->ToGoodTillCancel(worstAsk);
-        }
-        else if(order->GetSide() == Side::Sell && !bids_.empty())
-        {
-            const auto& [worstBid, _] = *bids_.rbegin();
-            order->ToGoodTillCancel(worstBid);
-        }
-        else
-            return { };
+        const auto& opposite = GetLadder<SideTraits<S>::Opposite>();
+        if(opposite.Empty())
+            return CommandStatus::Rejected;
+
+        order.ToGoodTillCancel(opposite.PriceAt(opposite.Worst()));
     }
     
+    // Whether the order crosses the spread is worked out once here, an order that doesn't cross can't produce
+    // any trade, so there is no need to go through MatchOrders() for it. A book building book never matches,
+    // the venue it mirrors reports its executions separately.
+    const bool canMatch = !bookBuilding_ && CanMatch<S>(order.GetPrice());
+
     //Not adding the order to the order book in case the order is Fill&Kill and we are not able to match it at the given moment
-    if(order->GetOrderType() == OrderType::FillAndKill && !CanMatch(order->GetSide(), order->GetPrice()))
-        return { };
+    if(order.GetOrderType() == OrderType::FillAndKill && !canMatch)
+    {
+        metrics_.Count(MetricCounter::FillAndKillRejected);
+        return CommandStatus::Rejected;
+    }
     
-    if(order->GetOrderType() == OrderType::FillOrKill && !CanFullyFill(order->GetSide(), order->GetPrice(), order->GetInitialQuantity()))
-        return { };
+    if(order.GetOrderType() == OrderType::FillOrKill && !CanFullyFill<S>(order.GetPrice(), order.GetInitialQuantity()))
+    {
+        metrics_.Count(MetricCounter::FillOrKillRejected);
+        return CommandStatus::Rejected;
+    }
+
+
+    // Prices off the tick grid, or too far away for the ladder to hold, are rejected like any other unfillable order.
+    auto& ladder = GetLadder<S>();
+    if(!ladder.CanHold(order.GetPrice()))
+        return CommandStatus::Rejected;
+
+    // So is an order for a level that already queues as many orders as it has positions for.
+    if(const auto index = ladder.Find(order.GetPrice()); index != ladder.npos && !MakeQueueRoom(ladder.LevelAt(index)))
+        return CommandStatus::Rejected;
+
+    // The risk checks come last, an order that passes them goes on the book.
+    if(risk_.Enabled() && !PassesRisk(order.GetAccountId(), order.GetPrice(), order.GetInitialQuantity()))
+        return CommandStatus::RiskRejected;
+
+    if(!sinks_.empty())
+        Publish(OrderbookEvent{ .type_ = EventType::OrderAccepted, .side_ = S, .orderType_ = order.GetOrderType(),
+            .orderId_ = order.GetOrderId(), .price_ = order.GetPrice(), .quantity_ = order.GetInitialQuantity() });
 
+    // The order is copied into a pooled slot and linked at the back of its price level's queue.
+    const auto handle = pool_.Allocate(order);
+    auto& level = ladder.LevelAt(ladder.Insert(order.GetPrice()));
+    Enqueue(level, handle);
+    risk_.OnAdded(handle, order.GetAccountId(), order.GetPrice(), order.GetInitialQuantity());
+
+    if(order.GetOrderType() == OrderType::GoodForDay)
+        pool_.PushBack(goodForDayOrders_, handle);
+    OnOrderAdded(level, pool_.Get(handle));
+
+    orders_.Insert(order.GetOrderId(), handle);
+
+    if(canMatch)
+        MatchOrders<S>(trades);
+
+    return CommandStatus::Accepted;
+}
+
+
+
+
+       
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::CancelOrder(OrderID orderId)
+{
+    auto ordersLock = LockOrders();
+    const auto timer = metrics_.Time(MetricOperation::CancelOrder);
+    scratchTrades_.clear();
+    ApplyCommandInternal(OrderCommand::Cancel(orderId), scratchTrades_);
+    OnBookChanged();
+}
 
-    OrderPointers::iterator iterator;
 
-    if(order->GetSide() == Side::Buy)
+template<typename MatchingPolicy>
+Trades BasicOrderbook<MatchingPolicy>::ModifyOrder(OrderModify order)
+{
+    // The whole cancel and re-add happens under one lock, so nobody can see the order missing in between.
+    auto ordersLock = LockOrders();
+    const auto timer = metrics_.Time(MetricOperation::ModifyOrder);
+    Trades trades;
+    ApplyCommandInternal(OrderCommand::Modify(order), trades);
+    OnBookChanged();
+    return trades;
+}
+
+
+template<typename MatchingPolicy>
+CommandStatus BasicOrderbook<MatchingPolicy>::ModifyOrderInternal(OrderModify order, Trades& trades)
+{
+    const auto handle = orders_.Find(order.GetOrderId());
+    if(handle == InvalidOrderHandle)
+        return CommandStatus::NotFound;
+
+    return order.GetSide() == Side::Buy ? ModifyOrder<Side::Buy>(handle, order, trades) : ModifyOrder<Side::Sell>(handle, order, trades);
+}
+
+
+template<typename MatchingPolicy>
+template<Side S>
+CommandStatus BasicOrderbook<MatchingPolicy>::ModifyOrder(OrderHandle handle, OrderModify order, Trades& trades)
+{
+    auto& existing = pool_.Get(handle);
+
+    // Amend-down: same side, same price and less quantity. The order keeps its place in the queue and
+    // only the order itself and its level's aggregate change, there is no lookup or allocation beyond the Find above.
+    if(existing.GetSide() == S && existing.GetPrice() == order.GetPrice() &&
+        order.GetQuantity() != 0 && order.GetQuantity() <= existing.GetRemainingQuantity())
     {
-        auto& orders = bids_[order->GetPrice()];
-        orders.push_back(order);
-        iterator = std::next(orders.begin(), orders.size()-1);
+        ReduceOrder<S>(handle, order.GetQuantity());
+        return CommandStatus::Accepted;
     }
-    else
+
+    // Anything else loses its priority and is re-queued. A new price the ladder can't hold is rejected
+    // before the order is cancelled, so a bad modify never takes the original order off the book.
+    auto& ladder = GetLadder<S>();
+    if(!ladder.CanHold(order.GetPrice()))
+        return CommandStatus::Rejected;
+
+    // So is a new level with no room left in its queue. Re-queued at its own level, the order frees its own position first.
+    const bool sameLevel = existing.GetSide() == S && existing.GetPrice() == order.GetPrice();
+    if(const auto index = ladder.Find(order.GetPrice()); !sameLevel && index != ladder.npos && !MakeQueueRoom(ladder.LevelAt(index)))
+        return CommandStatus::Rejected;
+
+    // Same for the risk checks, with what the original order holds already counted as released.
+    const auto accountId = risk_.AccountOf(handle);
+    if(risk_.Enabled() && !PassesRisk(accountId, order.GetPrice(), order.GetQuantity(), existing.GetRemainingQuantity(),
+        RiskGate::Notional(existing.GetPrice(), existing.GetRemainingQuantity())))
+        return CommandStatus::RiskRejected;
+
+    const auto orderType = existing.GetOrderType();
+    
+    CancelOrderInternal(order.GetOrderId()); 
+    // Here we deleted this order from the 'orders_'(OrderIndex) and therefore we need 'ToOrder' 
+    // to create a new order with all the details from the order that previously existed and make changes to it.
+    return AddOrder<S>(order.ToOrder(orderType, accountId), trades);
+}
+
+
+template<typename MatchingPolicy>
+template<Side S>
+void BasicOrderbook<MatchingPolicy>::ReduceOrder(OrderHandle handle, Quantity quantity)
+{
+    auto& order = pool_.Get(handle);
+    auto& ladder = GetLadder<S>();
+    auto& level = ladder.LevelAt(ladder.Find(order.GetPrice()));
+    const auto reducedBy = order.GetRemainingQuantity() - quantity;
+
+    order.ReduceQuantity(quantity);
+    level.orders_.SetQuantity(pool_.Get(handle).GetQueuePosition(), quantity);
+    OnOrderReduced(level, order, reducedBy);
+    risk_.OnRemoved(handle, order.GetPrice(), reducedBy);
+}
+
+
+template<typename MatchingPolicy>
+CommandStatus BasicOrderbook<MatchingPolicy>::ExecuteOrderInternal(OrderID orderId, Quantity quantity, Price price, Trades& trades)
+{
+    const auto handle = orders_.Find(orderId);
+    if(handle == InvalidOrderHandle)
+        return CommandStatus::NotFound;
+
+    const auto& order = pool_.Get(handle);
+    if(quantity == 0 || quantity > order.GetRemainingQuantity())
+        return CommandStatus::Rejected;
+
+    return order.GetSide() == Side::Buy ? ExecuteOrder<Side::Buy>(handle, quantity, price, trades) : ExecuteOrder<Side::Sell>(handle, quantity, price, trades);
+}
+
+
+template<typename MatchingPolicy>
+template<Side S>
+CommandStatus BasicOrderbook<MatchingPolicy>::ExecuteOrder(OrderHandle handle, Quantity quantity, Price price, Trades& trades)
+{
+    auto& order = pool_.Get(handle);
+    auto& ladder = GetLadder<S>();
+    const auto index = ladder.Find(order.GetPrice());
+    auto& level = ladder.LevelAt(index);
+
+    order.Fill(quantity);
+
+    // The counterparty isn't on this book, its side of the trade is reported with OrderID 0.
+    const auto tradePrice = price != 0 ? price : order.GetPrice();
+    const TradeInfo restingTrade{ order.GetOrderId(), tradePrice, quantity };
+    const TradeInfo otherTrade{ 0, tradePrice, quantity };
+    const auto& bidTrade = S == Side::Buy ? restingTrade : otherTrade;
+    const auto& askTrade = S == Side::Buy ? otherTrade : restingTrade;
+    trades.push_back(Trade{ bidTrade, askTrade });
+    RecordTrades(std::span<const Trade>{ trades }.last(1), S);
+
+    if(!sinks_.empty())
+        Publish(OrderbookEvent{ .type_ = EventType::Trade, .bidTrade_ = bidTrade, .askTrade_ = askTrade });
+
+    OnOrderMatched(level, order, quantity);
+    risk_.OnRemoved(handle, order.GetPrice(), quantity);
+    metrics_.Count(MetricCounter::Trades);
+
+    if(order.isFilled())
     {
-        auto& orders = asks_[order->GetPrice()];
-        orders.push_back(order);
-        iterator = std::next(orders.begin(), orders.size()-1);
+        level.orders_.Erase(pool_.Get(handle).GetQueuePosition());
+        orders_.Erase(order.GetOrderId());
+        ReleaseOrder(handle);
+
+        if(level.orders_.Empty())
+            ladder.Erase(index);
     }
+    else
+        level.orders_.SetQuantity(pool_.Get(handle).GetQueuePosition(), order.GetRemainingQuantity());
 
-    orders_.insert({order->GetOrderId(), OrderEntry{ order, iterator }});
-    return MatchOrders();
+    return CommandStatus::Accepted;
 }
 
 
+template<typename MatchingPolicy>
+CommandStatus BasicOrderbook<MatchingPolicy>::ReduceOrderInternal(OrderID orderId, Quantity quantity)
+{
+    const auto handle = orders_.Find(orderId);
+    if(handle == InvalidOrderHandle)
+        return CommandStatus::NotFound;
+
+    const auto& order = pool_.Get(handle);
+    if(quantity == 0)
+        return CommandStatus::Rejected;
 
+    if(quantity >= order.GetRemainingQuantity())
+        return CancelOrderInternal(orderId) ? CommandStatus::Accepted : CommandStatus::NotFound;
 
-       
-void Orderbook::CancelOrder(OrderID orderId)
+    // A partial cancel keeps the order's place in the queue, exactly like an amend-down.
+    if(order.GetSide() == Side::Buy)
+        ReduceOrder<Side::Buy>(handle, order.GetRemainingQuantity() - quantity);
+    else
+        ReduceOrder<Side::Sell>(handle, order.GetRemainingQuantity() - quantity);
+
+    return CommandStatus::Accepted;
+}
+
+
+template<typename MatchingPolicy>
+CommandStatus BasicOrderbook<MatchingPolicy>::Apply(const OrderCommand& command)
+{
+    // The trades still go through the scratch buffer, it keeps its capacity so this doesn't allocate once warmed up.
+    auto ordersLock = LockOrders();
+    const auto timer = metrics_.Time(MetricOperation::Apply);
+    scratchTrades_.clear();
+    const auto status = ApplyCommandInternal(command, scratchTrades_);
+    OnBookChanged();
+    return status;
+}
+
+
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::AddEventSink(EventSink sink)
+{
+    auto ordersLock = LockOrders();
+    sinks_.push_back(sink);
+}
+
+
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::RemoveEventSink(EventSink sink)
+{
+    auto ordersLock = LockOrders();
+    std::erase(sinks_, sink);
+}
+
+
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::AttachJournal(CommandJournal& journal)
+{
+    auto ordersLock = LockOrders();
+    journal_ = &journal;
+}
+
+
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::DetachJournal()
+{
+    auto ordersLock = LockOrders();
+    journal_ = nullptr;
+}
+
+
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::AttachTradeLog(TradeLog& tradeLog)
+{
+    auto ordersLock = LockOrders();
+    tradeLog_ = &tradeLog;
+}
+
+
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::DetachTradeLog()
 {
-    std::scoped_lock ordersLock { ordersMutex_ };
-    CancelOrderInternal(orderId);
+    auto ordersLock = LockOrders();
+    tradeLog_ = nullptr;
 }
 
 
-Trades Orderbook::ModifyOrder(OrderModify order)
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::ProcessBatch(std::span<const OrderCommand> commands, BatchResult& result)
 {
-    OrderType orderType;
+    // The whole batch is applied under one lock, in order, and every command appends to the same buffers.
+    auto ordersLock = LockOrders();
+    const auto timer = metrics_.Time(MetricOperation::ProcessBatch);
+    result.results_.reserve(result.results_.size() + commands.size());
+
+    for(const auto& command : commands)
     {
-        std::scoped_lock ordersLock{ ordersMutex_ };
-        if(!orders_.contains(order.GetOrderId()))
-            return { };
-    
-        const auto& [existingOrder, _] = orders_.at(order.GetOrderId());
-        orderType = existingOrder->GetOrderType();
+        const auto firstTrade = result.trades_.size();
+        const auto status = ApplyCommandInternal(command, result.trades_);
+
+        result.results_.push_back(CommandResult{ command.orderId_, status,
+            static_cast<std::uint32_t>(firstTrade), static_cast<std::uint32_t>(result.trades_.size() - firstTrade) });
     }
-    
-    CancelOrder(order.GetOrderId()); 
-    // Here we deleted this order from the 'orders_'(unordered_map) and therefore we need 'ToOrderPointer' 
-    // to create a new order with all the details from the order that previously existed and make changes to it.
-    return AddOrder(order.ToOrderPointer(orderType));
+
+    OnBookChanged();
+}
+
+
+template<typename MatchingPolicy>
+CommandStatus BasicOrderbook<MatchingPolicy>::ApplyCommandInternal(const OrderCommand& command, Trades& trades)
+{
+    auto status = CommandStatus::Rejected;
+    switch(command.type_)
+    {
+    case CommandType::Add:
+        status = AddOrderInternal(command.ToOrder(), trades);
+        break;
+    case CommandType::Cancel:
+        status = CancelOrderInternal(command.orderId_) ? CommandStatus::Accepted : CommandStatus::NotFound;
+        break;
+    case CommandType::Modify:
+        status = ModifyOrderInternal(command.ToOrderModify(), trades);
+        break;
+    case CommandType::ExpireGoodForDay:
+        ExpireGoodForDayOrdersInternal();
+        status = CommandStatus::Accepted;
+        break;
+    case CommandType::Execute:
+        status = ExecuteOrderInternal(command.orderId_, command.quantity_, command.price_, trades);
+        break;
+    case CommandType::Reduce:
+        status = ReduceOrderInternal(command.orderId_, command.quantity_);
+        break;
+    case CommandType::MassCancel:
+    {
+        std::size_t cancelled{ };
+        status = MassCancelInternal(command.ToMassCancelFilter(), cancelled, nullptr);
+        break;
+    }
+    }
+
+    // Commands that were turned down left the book as it was, so replaying the accepted ones is enough to rebuild it.
+    if(journal_ && status == CommandStatus::Accepted)
+        journal_->Append(command);
+
+    return status;
 }
 
         
-std::size_t Orderbook::Size() const 
+template<typename MatchingPolicy>
+std::size_t BasicOrderbook<MatchingPolicy>::Size() const 
 { 
-    std::scoped_lock ordersLock{ ordersMutex_ };
-    return orders_.size(); 
+    auto ordersLock = LockOrders();
+    return orders_.Size(); 
 }
 
 
-OrderbookLevelInfos  Orderbook::GetOrderInfos() const 
+template<typename MatchingPolicy>
+BookMemoryUsage BasicOrderbook<MatchingPolicy>::MemoryUsage() const
 {
-    LevelInfos bidInfos, askInfos;
-    bidInfos.reserve(orders_.size());
-    askInfos.reserve(orders_.size());
+    auto ordersLock = LockOrders();
+    return BookMemoryUsage{ .orders_ = pool_.MemoryUsage(), .levels_ = bids_.MemoryUsage() + asks_.MemoryUsage(),
+        .index_ = orders_.MemoryUsage() + risk_.MemoryUsage(), .restingOrders_ = orders_.Size() };
+}
+
+
+template<typename MatchingPolicy>
+AccountExposure BasicOrderbook<MatchingPolicy>::GetAccountExposure(AccountID account) const
+{
+    auto ordersLock = LockOrders();
+    return risk_.GetExposure(account);
+}
+
+
+template<typename MatchingPolicy>
+bool BasicOrderbook<MatchingPolicy>::PassesRisk(AccountID account, Price price, Quantity quantity, Quantity releasedQuantity, std::int64_t releasedNotional)
+{
+    if(risk_.Allows(account, price, quantity, BestPrice<Side::Buy>(), BestPrice<Side::Sell>(), releasedQuantity, releasedNotional))
+        return true;
+
+    metrics_.Count(MetricCounter::RiskRejected);
+    return false;
+}
 
-    // Lambda Function
-    auto CreateLevelInfos = [](Price price, const OrderPointers& orders)
+
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::Reserve(std::size_t orderCapacity)
+{
+    auto ordersLock = LockOrders();
+    pool_.Reserve(orderCapacity);
+    orders_.Reserve(orderCapacity);
+    risk_.Reserve(orderCapacity);
+}
+
+
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::TakeSnapshot(BookSnapshot& snapshot) const
+{
+    auto ordersLock = LockOrders();
+
+    snapshot.tickSize_ = bids_.GetTickSize();
+    snapshot.journalSequence_ = journal_ ? journal_->GetNextSequence() : 0;
+    snapshot.orders_.clear();
+    snapshot.orders_.reserve(orders_.Size());
+
+    // One walk down the occupied levels of each side and along the queue of each level, nothing is encoded here.
+    const auto copySide = [this, &snapshot](const auto& ladder)
     {
-        return LevelInfo{ price, std::accumulate(orders.begin(), orders.end(), (Quantity)0,
-            [](Quantity runningSum, const OrderPointer& order)
-            { return runningSum + order->GetRemainingQuantity(); }) };
+        for(auto index = ladder.Best(); index != ladder.npos; index = ladder.NextWorse(index))
+        {
+            for(const auto handle : ladder.LevelAt(index).orders_.Handles())
+            {
+                if(handle == InvalidOrderHandle)
+                    continue;
+
+                const auto& order = pool_.Get(handle);
+                snapshot.orders_.push_back(SnapshotOrder{ order.GetOrderId(), order.GetPrice(), order.GetInitialQuantity(), order.GetRemainingQuantity(),
+                    static_cast<std::uint8_t>(order.GetSide()), static_cast<std::uint8_t>(order.GetOrderType()), { }, risk_.AccountOf(handle) });
+            }
+        }
     };
 
-    for(const auto& [price, orders] : bids_)
-        bidInfos.push_back(CreateLevelInfos(price, orders));
+    copySide(bids_);
+    snapshot.bidCount_ = snapshot.orders_.size();
+    copySide(asks_);
+}
+
+
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::RestoreSnapshot(const BookSnapshot& snapshot)
+{
+    auto ordersLock = LockOrders();
+
+    if(orders_.Size() != 0)
+        throw std::logic_error("A snapshot can only be restored into an empty book.");
+
+    if(snapshot.tickSize_ != bids_.GetTickSize())
+        throw std::logic_error(std::format("Snapshot tick size ({}) does not match the book's tick size ({}).", snapshot.tickSize_, bids_.GetTickSize()));
+
+    if(snapshot.bidCount_ > snapshot.orders_.size())
+        throw std::logic_error(std::format("Snapshot bid count ({}) is larger than its order count ({}).", snapshot.bidCount_, snapshot.orders_.size()));
+
+    const std::span<const SnapshotOrder> orders{ snapshot.orders_ };
+    const auto bids = orders.first(snapshot.bidCount_);
+    const auto asks = orders.subspan(snapshot.bidCount_);
+
+    // Everything is checked before the book is touched, so a snapshot that is refused leaves the book empty.
+    ValidateSnapshotSide<Side::Buy>(bids);
+    ValidateSnapshotSide<Side::Sell>(asks);
+    if(!bids.empty() && !asks.empty() && bids.front().price_ >= asks.front().price_)
+        throw std::logic_error(std::format("Snapshot is crossed, best bid ({}) and best ask ({}).", bids.front().price_, asks.front().price_));
+
+    // An order ID may only appear once, on either side.
+    std::vector<OrderID> orderIds;
+    orderIds.reserve(orders.size());
+    for(const auto& order : orders)
+        orderIds.push_back(order.orderId_);
+    std::sort(orderIds.begin(), orderIds.end());
+    if(const auto duplicate = std::adjacent_find(orderIds.begin(), orderIds.end()); duplicate != orderIds.end())
+        throw std::logic_error(std::format("Snapshot order ({}) appears more than once.", *duplicate));
+
+    pool_.Reserve(pool_.Size() + orders.size());
+    orders_.Reserve(orders.size());
+
+    RestoreSnapshotSide<Side::Buy>(bids);
+    RestoreSnapshotSide<Side::Sell>(asks);
+    OnBookChanged();
+}
+
+
+template<typename MatchingPolicy>
+template<Side S>
+void BasicOrderbook<MatchingPolicy>::ValidateSnapshotSide(std::span<const SnapshotOrder> orders) const
+{
+    if(orders.empty())
+        return;
+
+    std::size_t levelCount{ };
+    for(std::size_t index = 0; index < orders.size(); ++index)
+    {
+        const auto& order = orders[index];
+        const bool outOfOrder = index != 0 && SideTraits<S>::IsBetter(order.price_, orders[index - 1].price_);
+
+        if(static_cast<Side>(order.side_) != S || outOfOrder || order.remainingQuantity_ == 0 || order.remainingQuantity_ > order.initialQuantity_)
+            throw std::logic_error(std::format("Snapshot order ({}) is out of place or has an invalid quantity.", order.orderId_));
+
+        if(risk_.Enabled() && !risk_.HasRoomFor(order.accountId_))
+            throw std::logic_error(std::format("Snapshot order ({}) has an account ({}) past the book's account capacity.", order.orderId_, order.accountId_));
+
+        // The queue of a level that starts out empty takes positions 0 to MaxQueuePosition.
+        levelCount = index != 0 && order.price_ == orders[index - 1].price_ ? levelCount + 1 : 1;
+        if(levelCount > std::size_t{ OrderRecord::MaxQueuePosition } + 1)
+            throw std::logic_error(std::format("Snapshot level ({}) holds more orders than a level can queue.", order.price_));
+    }
+
+    const auto low = S == Side::Buy ? orders.back().price_ : orders.front().price_;
+    const auto high = S == Side::Buy ? orders.front().price_ : orders.back().price_;
+    if(!GetLadder<S>().CanHold(low, high))
+        throw std::logic_error(std::format("Snapshot prices ({} to {}) do not fit the book's ladder.", low, high));
+}
+
+
+template<typename MatchingPolicy>
+template<Side S>
+void BasicOrderbook<MatchingPolicy>::RestoreSnapshotSide(std::span<const SnapshotOrder> orders)
+{
+    if(orders.empty())
+        return;
+
+    auto& ladder = GetLadder<S>();
+
+    // Claiming both ends of the side first sizes the ladder once, so no level is moved while the rest is filled in.
+    ladder.Insert(orders.front().price_);
+    ladder.Insert(orders.back().price_);
+
+    for(std::size_t first = 0; first < orders.size(); )
+    {
+        const auto price = orders[first].price_;
+        auto& level = ladder.LevelAt(ladder.Insert(price));
+
+        // The orders of a level are linked in the snapshot's order, which is their queue order. Every ID is new and
+        // every level's queue has room for all of its orders, ValidateSnapshotSide() and RestoreSnapshot() made sure.
+        for(; first < orders.size() && orders[first].price_ == price; ++first)
+        {
+            const auto& record = orders[first];
+            Order order{ static_cast<OrderType>(record.orderType_), record.orderId_, S, price, record.initialQuantity_ };
+            order.Fill(record.initialQuantity_ - record.remainingQuantity_);
+
+            const auto handle = pool_.Allocate(order);
+            orders_.Insert(order.GetOrderId(), handle);
+            Enqueue(level, handle);
+            risk_.OnAdded(handle, record.accountId_, price, record.remainingQuantity_);
+            if(order.GetOrderType() == OrderType::GoodForDay)
+                pool_.PushBack(goodForDayOrders_, handle);
+        }
+
+        // The level's totals are taken from its queue in one pass once all of its orders are in.
+        const auto quantities = level.orders_.Quantities();
+        level.data_.quantity_ = static_cast<Quantity>(SumQuantities(quantities.data(), quantities.size()));
+        level.data_.count_ = static_cast<Quantity>(level.orders_.Size());
+
+        // The level is announced once with its final totals rather than once per order.
+        marketData_.OnLevelChanged(S, price, level.data_.quantity_, level.data_.count_, L2Action::Added, level.pendingUpdate_);
+        if(!sinks_.empty())
+            Publish(OrderbookEvent{ .type_ = EventType::LevelChanged, .side_ = S, .price_ = price, .quantity_ = level.data_.quantity_, .count_ = level.data_.count_ });
+    }
+}
+
+
+template<typename MatchingPolicy>
+std::size_t BasicOrderbook<MatchingPolicy>::ExpireGoodForDayOrders(OrderIDs* orderIds)
+{
+    auto ordersLock = LockOrders();
+    const auto timer = metrics_.Time(MetricOperation::ExpireGoodForDay);
+    const auto expired = ExpireGoodForDayOrdersInternal(orderIds);
+    if(journal_)
+        journal_->Append(OrderCommand::ExpireGoodForDay());
+    OnBookChanged();
+    return expired;
+}
+
+
+template<typename MatchingPolicy>
+std::size_t BasicOrderbook<MatchingPolicy>::MassCancel(const MassCancelFilter& filter, OrderIDs* orderIds)
+{
+    auto ordersLock = LockOrders();
+    const auto timer = metrics_.Time(MetricOperation::MassCancel);
+    std::size_t cancelled{ };
+    if(MassCancelInternal(filter, cancelled, orderIds) != CommandStatus::Accepted)
+        throw std::logic_error(filter.scope_ == MassCancelScope::Account ? std::format("Orders can't be cancelled by account ({}), the book doesn't track accounts.", filter.accountId_)
+            : std::format("Price range ({} to {}) is empty.", filter.lowPrice_, filter.highPrice_));
+
+    if(journal_)
+        journal_->Append(OrderCommand::MassCancel(filter));
+    OnBookChanged();
+    return cancelled;
+}
+
+
+template<typename MatchingPolicy>
+void BasicOrderbook<MatchingPolicy>::OnSessionClose()
+{
+    ExpireGoodForDayOrders();
+}
+
+
+template<typename MatchingPolicy>
+Quantity BasicOrderbook<MatchingPolicy>::AvailableLiquidity(Side side, Price limitPrice, Quantity maxQuantity) const
+{
+    auto ordersLock = LockOrders();
+    return side == Side::Buy ? AvailableLiquidityInternal<Side::Buy>(limitPrice, maxQuantity) : AvailableLiquidityInternal<Side::Sell>(limitPrice, maxQuantity);
+}
+
+
+template<typename MatchingPolicy>
+OrderHandle BasicOrderbook<MatchingPolicy>::FindOrder(OrderID orderId) const
+{
+    auto ordersLock = LockOrders();
+    return orders_.Find(orderId);
+}
+
+
+template<typename MatchingPolicy>
+Order BasicOrderbook<MatchingPolicy>::GetOrder(OrderHandle handle) const
+{
+    auto ordersLock = LockOrders();
+    return pool_.Get(handle).ToOrder(risk_.AccountOf(handle));
+}
+
+
+template<typename MatchingPolicy>
+OrderbookLevelInfos  BasicOrderbook<MatchingPolicy>::GetOrderInfos() const 
+{
+    auto ordersLock = LockOrders();
+
+    LevelInfos bidInfos, askInfos;
+    bidInfos.reserve(bids_.LevelCount());
+    askInfos.reserve(asks_.LevelCount());
+
+    // Every level already keeps its total quantity in its LevelData, so this is O(levels) and not O(orders).
+    for(auto index = bids_.Best(); index != bids_.npos; index = bids_.NextWorse(index))
+        bidInfos.push_back(LevelInfo{ bids_.PriceAt(index), bids_.LevelAt(index).data_.quantity_ });
     
-    for(const auto& [price, orders] : asks_)
-        askInfos.push_back(CreateLevelInfos(price, orders));
+    for(auto index = asks_.Best(); index != asks_.npos; index = asks_.NextWorse(index))
+        askInfos.push_back(LevelInfo{ asks_.PriceAt(index), asks_.LevelAt(index).data_.quantity_ });
     
     return OrderbookLevelInfos{ bidInfos, askInfos}; 
 }
 
+
+template<typename MatchingPolicy>
+DepthSnapshot BasicOrderbook<MatchingPolicy>::GetDepth() const
+{
+    auto ordersLock = LockOrders();
+    return marketData_.GetDepth();
+}
+
+
+template<typename MatchingPolicy>
+std::size_t BasicOrderbook<MatchingPolicy>::DrainL2Updates(std::vector<L2Update>& updates)
+{
+    auto ordersLock = LockOrders();
+    return marketData_.DrainUpdates(updates);
+}
+
+
+// The matching policies a book can be built with, see MatchingPolicy.h.
+template class BasicOrderbook<FifoMatching>;
+template class BasicOrderbook<ProRataMatching>;
+template class BasicOrderbook<TopOrderProRataMatching>;
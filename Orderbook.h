@@ -1,27 +1,46 @@
 #pragma once
 
-#include <map>
-#include <unordered_map>
-#include <thread>
-#include <condition_variable>
 #include <mutex>
+#include <span>
+#include <limits>
+#include <optional>
 
 #include "Usings.h"
 #include "Order.h"
 #include "OrderModify.h"
+#include "OrderCommand.h"
+#include "BatchResult.h"
+#include "OrderbookEvent.h"
+#include "MarketDataPublisher.h"
 #include "OrderbookLevelInfos.h"
 #include "Trade.h"
+#include "OrderbookOptions.h"
+#include "PriceLadder.h"
+#include "SideTraits.h"
+#include "MatchingPolicy.h"
+#include "OrderPool.h"
+#include "LevelQueue.h"
+#include "OrderIndex.h"
+#include "BookSnapshot.h"
+#include "BookMetrics.h"
+#include "TopOfBook.h"
+#include "TradeStatistics.h"
+#include "BookMemoryUsage.h"
+#include "RiskGate.h"
 
-class Orderbook
+class CommandJournal;
+class TradeLog;
+
+/*
+** BasicOrderbook is the order book of one instrument, built with the MatchingPolicy that decides how an incoming
+   order is shared out over the resting orders of a level (see MatchingPolicy.h). Orderbook is the price-time
+   (FIFO) book, the other policies are instantiated in Orderbook.cpp and used through their own names.
+*/
+template<typename MatchingPolicy = FifoMatching>
+class BasicOrderbook
 {
 private:
 
-    struct OrderEntry
-    {
-        OrderPointer order_{ nullptr };
-        OrderPointers::iterator location_;
-    };
-
     struct LevelData
     {
         Quantity quantity_{ };
@@ -36,57 +55,250 @@ private:
     };
 
 
-    std::unordered_map<Price,LevelData> data_;
-    /*
-    / Basically the structure of the map looks like --> map[int] = {list}
-    * The bids_ map is ordered in the 'Descending Price' fashion, meaning the highest price comes first,
-    * as this is the maximum amount the buyer is willing to pay for that certain stock or security.
-    */
-    std::map<Price, OrderPointers, std::greater<Price>> bids_;
-    
+    // Every price level keeps its FIFO queue of orders together with its aggregated LevelData in the same slot.
+    struct PriceLevel
+    {
+        LevelQueue orders_;
+        LevelData data_;
+        L2PendingSlot pendingUpdate_;
+
+        std::size_t MemoryUsage() const { return orders_.MemoryUsage(); }
+
+        // The queue keeps its arrays, a price that empties out and fills up again doesn't allocate.
+        void Clear()
+        {
+            orders_.Clear();
+            data_ = LevelData{ };
+            pendingUpdate_ = L2PendingSlot{ };
+        }
+    };
+
     /*
-    * The asks_ map is ordered in the 'Ascending Price' fashion, meaning the lowest price comes first,
-    * as this is the minimum amount the seller is looking for selling that stock.
+    * Each side of the book is a PriceLadder, a flat array of PriceLevels indexed by the price tick.
+    * For the bids_ the best price is the highest occupied level, as this is the maximum amount the buyer
+      is willing to pay for that certain stock or security.
+    * For the asks_ the best price is the lowest occupied level, as this is the minimum amount the seller
+      is looking for selling that stock.
     */
-    std::map<Price, OrderPointers, std::less<Price>> asks_;
+    PriceLadder<PriceLevel, Side::Buy> bids_;
+    PriceLadder<PriceLevel, Side::Sell> asks_;
 
     /*
-    * Here we have used an unordered_map for a quick O(1) lookup to any order provided its OrderID is given
+    * All resting orders live in the pool_, and the queue of each price level holds their handles and remaining quantities.
+    * The OrderIndex gives us a quick O(1) lookup to any order's handle provided its OrderID is given
+    * The GoodForDay orders are also linked in goodForDayOrders_, so that expiring them never means scanning the whole book.
     */
-    std::unordered_map<OrderID, OrderEntry> orders_;
+    OrderPool pool_;
+    OrderIndex orders_;
+    OrderList goodForDayOrders_;
+    RiskGate risk_;
+    bool singleWriter_;
+    bool bookBuilding_;
     mutable std::mutex ordersMutex_;
-    std::thread ordersPruneThread_;
-    std::condition_variable shutdownConditionVariable_;
-    std::atomic<bool> shutdown_{false};
+    MarketDataPublisher marketData_;
+    std::vector<EventSink> sinks_;
+    CommandJournal* journal_{ nullptr };
+    TradeLog* tradeLog_{ nullptr };
+    [[no_unique_address]] MetricsRecorder metrics_;     // Empty unless built with ORDERBOOK_INSTRUMENTATION, see BookMetrics.h.
+    Trades scratchTrades_;
+    TopOfBook publishedTop_;                // What topOfBook_ holds, only read by the writer to skip publishing an unchanged top.
+    TopOfBookPublisher topOfBook_;          // On its own cache line, polled by other threads without taking ordersMutex_.
+    TradeStatisticsRecorder tradeStatistics_;   // Same, for the trade statistics and bars.
+    TradeClock tradeClock_;
+
+    template<Side S>
+    void ReadTop(Price& price, Quantity& quantity, Quantity& count) const;
+
+    std::size_t ExpireGoodForDayOrdersInternal(OrderIDs* orderIds = nullptr);
+    bool CancelOrderInternal(OrderID orderId);
+    CommandStatus AddOrderInternal(Order order, Trades& trades);
+    CommandStatus ModifyOrderInternal(OrderModify order, Trades& trades);
+    CommandStatus ExecuteOrderInternal(OrderID orderId, Quantity quantity, Price price, Trades& trades);
+    CommandStatus ReduceOrderInternal(OrderID orderId, Quantity quantity);
+    CommandStatus MassCancelInternal(const MassCancelFilter& filter, std::size_t& cancelled, OrderIDs* orderIds);
+    CommandStatus ApplyCommandInternal(const OrderCommand& command, Trades& trades);
+
+    // The members above take the order's Side at runtime and hand over to these, which are compiled once per side.
+    template<Side S> CommandStatus AddOrder(Order order, Trades& trades);
+    template<Side S> CommandStatus ModifyOrder(OrderHandle handle, OrderModify order, Trades& trades);
+    template<Side S> CommandStatus ExecuteOrder(OrderHandle handle, Quantity quantity, Price price, Trades& trades);
+    template<Side S> void ReduceOrder(OrderHandle handle, Quantity quantity);
+    template<Side S> void RemoveOrder(OrderHandle handle);
+
+    // Cancels the levels of side S from the best one priced at 'from' or worse, until the first one priced worse than 'to'.
+    // With 'wholeBook' the orders aren't unlinked from the GoodForDay and account lists, the caller drops those whole.
+    template<Side S> std::size_t CancelLevels(Price from, Price to, OrderIDs* orderIds, bool wholeBook = false);
+    // Cancels every order of a level and releases the level, with a single update of its market data.
+    template<Side S> std::size_t CancelLevel(std::size_t index, OrderIDs* orderIds, bool wholeBook);
+
+    // Whether the level can queue one more order, the position has to fit the bits an OrderRecord keeps for it.
+    // Checked before anything is changed, so an order the level has no room for is rejected with the book intact.
+    bool MakeQueueRoom(PriceLevel& level);
+    // Appends the order to the back of the level's queue and records its position. MakeQueueRoom() must have passed.
+    void Enqueue(PriceLevel& level, OrderHandle handle);
+
+    // Unlinks the order from the expiry list it may be in and gives its slot back to the pool.
+    void ReleaseOrder(OrderHandle handle);
+
+    // Every public member takes the lock through here, in single writer mode it hands back a lock that owns nothing.
+    std::unique_lock<std::mutex> LockOrders() const;
+
+    template<Side S>
+    auto& GetLadder()
+    {
+        if constexpr(S == Side::Buy)
+            return bids_;
+        else
+            return asks_;
+    }
+
+    template<Side S>
+    const auto& GetLadder() const
+    {
+        if constexpr(S == Side::Buy)
+            return bids_;
+        else
+            return asks_;
+    }
+
+    template<Side S>
+    std::optional<Price> BestPrice() const
+    {
+        const auto& ladder = GetLadder<S>();
+        return ladder.Empty() ? std::nullopt : std::optional<Price>{ ladder.PriceAt(ladder.Best()) };
+    }
+
+    // Holds an order against the RiskGate, see RiskGate::Allows().
+    bool PassesRisk(AccountID account, Price price, Quantity quantity, Quantity releasedQuantity = 0, std::int64_t releasedNotional = 0);
 
-    void PruneGoodForDayOrders();
+    void OnOrderCancelled(PriceLevel& level, const OrderRecord& order);
+    void OnOrderAdded(PriceLevel& level, const OrderRecord& order);
+    void OnOrderMatched(PriceLevel& level, const OrderRecord& order, Quantity quantity);
+    void OnOrderReduced(PriceLevel& level, const OrderRecord& order, Quantity quantity);
+    void UpdateLevelData(Side side, Price price, PriceLevel& level, Quantity quantity, LevelData::Action action, Quantity orders = 1);
 
-    void CancelOrders(OrderIDs orderIds);
-    void CancelOrderInternal(OrderID orderId);
+    // Adds the trades to the trade statistics, each at the price of its resting side.
+    void RecordTrades(std::span<const Trade> trades, Side aggressor);
 
-    void OnOrderCancelled(OrderPointer order);
-    void OnOrderAdded(OrderPointer order);
-    void OnOrderMatched(Price price, Quantity quantity, bool isFullyFilled);
-    void UpdateLevelData(Price price, Quantity quantity, LevelData::Action action);
+    // Called once at the end of every public operation that may have changed the book.
+    void OnBookChanged();
+    void Publish(const OrderbookEvent& event) const;
 
-    bool CanFullyFill(Side side, Price price, Quantity quantity) const;
-    bool CanMatch(Side side, Price price) const;
-    Trades MatchOrders();
+    template<Side S> void ValidateSnapshotSide(std::span<const SnapshotOrder> orders) const;
+    template<Side S> void RestoreSnapshotSide(std::span<const SnapshotOrder> orders);
+
+    template<Side S> bool CanFullyFill(Price price, Quantity quantity) const;
+    template<Side S> Quantity AvailableLiquidityInternal(Price limitPrice, Quantity maxQuantity) const;
+    template<Side S> bool CanMatch(Price price) const;
+
+    // Matches an incoming order of side S (the aggressor) against the opposite side until the book no longer crosses.
+    template<Side S> void MatchOrders(Trades& trades);
 
 
 public:
-    Orderbook();
-    Orderbook(const Orderbook&) = delete;
-    void operator=(const Orderbook&) = delete;
-    Orderbook(Orderbook&&) = delete;
-    void operator=(Orderbook&&) = delete;
-    ~Orderbook();
+    explicit BasicOrderbook(const OrderbookOptions& options = { });
+    BasicOrderbook(const BasicOrderbook&) = delete;
+    void operator=(const BasicOrderbook&) = delete;
+    BasicOrderbook(BasicOrderbook&&) = delete;
+    void operator=(BasicOrderbook&&) = delete;
 
     Trades AddOrder(OrderPointer order);
+    Trades AddOrder(Order order);
     void CancelOrder(OrderID orderId);
     Trades ModifyOrder(OrderModify order);
 
+    // Applies the commands in order under a single lock, appending every trade and one CommandResult per command to 'result'.
+    void ProcessBatch(std::span<const OrderCommand> commands, BatchResult& result);
+
+    // Applies one command, its trades and other effects are only reported to the event sinks.
+    CommandStatus Apply(const OrderCommand& command);
+
+    // Cancels every GoodForDay order and returns how many there were, appending their OrderIDs to 'orderIds' if given.
+    // The cost only depends on the number of GoodForDay orders.
+    std::size_t ExpireGoodForDayOrders(OrderIDs* orderIds = nullptr);
+
+    // Cancels every resting order 'filter' selects and returns how many there were, appending their OrderIDs to
+    // 'orderIds' if given. The cost depends on the orders cancelled and not on the size of the book: levels are
+    // released whole, and an account's orders are found through its own list. Cancelling by account throws
+    // std::logic_error unless the book tracks accounts, through a MassCancel command it is Rejected instead.
+    std::size_t MassCancel(const MassCancelFilter& filter, OrderIDs* orderIds = nullptr);
+
+    // Called by an ExpiryScheduler at the close of the session. A single writer book must not be registered
+    // with a scheduler itself, its owner is (see OrderbookSequencer::OnSessionClose and OrderGateway::OnSessionClose).
+    void OnSessionClose();
+
+    // Every sink receives every event, see EventSink. Sinks are not owned by the book and must outlive their registration.
+    void AddEventSink(EventSink sink);
+    void RemoveEventSink(EventSink sink);
+
+    // Every accepted command (including GoodForDay expiry) is appended to the journal from then on, see CommandJournal.
+    // The journal is not owned by the book and must outlive its attachment.
+    void AttachJournal(CommandJournal& journal);
+    void DetachJournal();
+
+    // Every trade is handed to the log from then on, stamped with the book's TradeClock, see TradeLog.
+    // The log is not owned by the book and must outlive its attachment.
+    void AttachTradeLog(TradeLog& tradeLog);
+    void DetachTradeLog();
+
     std::size_t Size() const;
+
+    // How much an order of 'side' limited at 'limitPrice' could fill right now, capped at 'maxQuantity'.
+    // Only the opposite side's levels up to the limit price are visited, and the walk stops once 'maxQuantity' is reached.
+    Quantity AvailableLiquidity(Side side, Price limitPrice, Quantity maxQuantity = std::numeric_limits<Quantity>::max()) const;
+
+    // Copies the resting orders into 'snapshot', reusing its storage. The book is only held for this copy, encoding
+    // and writing the snapshot (BookSnapshot::Save) is left to the caller, outside of the book's lock.
+    void TakeSnapshot(BookSnapshot& snapshot) const;
+
+    // Loads a snapshot into this book, which must be empty and use the snapshot's tick size. The orders are placed
+    // straight into their levels in the snapshot's order, with no matching. Throws std::logic_error if the snapshot
+    // doesn't fit the book, if that happens after some orders were placed the book should be thrown away.
+    void RestoreSnapshot(const BookSnapshot& snapshot);
+
+    // The book's latency histograms, counters and depth gauges, readable from any thread without locking.
+    // Null unless the book was built with ORDERBOOK_INSTRUMENTATION.
+    const BookMetrics* GetMetrics() const { return metrics_.Get(); }
+
+    // What the book's storage takes, by component. Slots and arrays kept for reuse count as well.
+    BookMemoryUsage MemoryUsage() const;
+
+    // The resting quantity and notional of an account's orders on this book, see OrderbookOptions::riskLimits_.
+    // Accounts are only tracked by a book with risk limits.
+    AccountExposure GetAccountExposure(AccountID account) const;
+
+    // Preallocates room for this many resting orders so that the trading session never has to allocate.
+    void Reserve(std::size_t orderCapacity);
+
+    // A handle stays valid for as long as its order is resting on the book, InvalidOrderHandle if there is no such order.
+    OrderHandle FindOrder(OrderID orderId) const;
+    Order GetOrder(OrderHandle handle) const;
     OrderbookLevelInfos GetOrderInfos() const;
 
-};
\ No newline at end of file
+    // The cached top of the book, see MarketDataPublisher. Its cost doesn't depend on how deep the book is.
+    DepthSnapshot GetDepth() const;
+
+    // The best bid and ask as of the end of the last operation, from any thread, without locking (see TopOfBookPublisher).
+    TopOfBook GetTopOfBook() const { return topOfBook_.Read(); }
+
+    // Last trade, volume and VWAP of every trade since construction or the last ResetTradeStatistics(), and the last
+    // OHLCV bars (see OrderbookOptions::tradeBarCount_), from any thread, without locking (see TradeStatisticsRecorder).
+    TradeStatistics GetTradeStatistics() const { return tradeStatistics_.Read(); }
+    std::size_t GetTradeBars(std::vector<TradeBar>& bars) const { return tradeStatistics_.ReadBars(bars); }
+
+    // Starts a new session of statistics, bars included.
+    void ResetTradeStatistics();
+
+    // Moves the L2Updates published since the last call into 'updates' (needs OrderbookOptions::publishL2Updates_).
+    std::size_t DrainL2Updates(std::vector<L2Update>& updates);
+
+};
+
+// Every member is defined in Orderbook.cpp, which instantiates the book for each of these policies.
+extern template class BasicOrderbook<FifoMatching>;
+extern template class BasicOrderbook<ProRataMatching>;
+extern template class BasicOrderbook<TopOrderProRataMatching>;
+
+using Orderbook = BasicOrderbook<FifoMatching>;
+using ProRataOrderbook = BasicOrderbook<ProRataMatching>;
+using TopOrderProRataOrderbook = BasicOrderbook<TopOrderProRataMatching>;
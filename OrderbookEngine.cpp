@@ -0,0 +1,220 @@
+#include "OrderbookEngine.h"
+
+#include <algorithm>
+#include <exception>
+#include <format>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace
+{
+    // Pins the thread to a single CPU so that its books stay warm in that core's caches.
+    void PinThread(std::thread& thread, int cpu)
+    {
+#if defined(__linux__)
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+#elif defined(_WIN32)
+        SetThreadAffinityMask(thread.native_handle(), DWORD_PTR{ 1 } << cpu);
+#else
+        (void)thread;
+        (void)cpu;
+#endif
+    }
+}
+
+
+OrderbookEngine::OrderbookEngine(const EngineOptions& options)
+    : options_{ options }
+{
+    options_.bookOptions_.singleWriter_ = true;     // Only the worker of its shard ever touches a book, it needs no lock.
+
+    const auto workerCount = std::max(options_.workerCount_, std::size_t{ 1 });
+    for(std::size_t shard = 0; shard < workerCount; ++shard)
+        shards_.push_back(std::make_unique<Shard>(options_));
+}
+
+OrderbookEngine::~OrderbookEngine()
+{
+    Stop();
+}
+
+
+void OrderbookEngine::AssignSymbol(SymbolID symbol, std::size_t shard)
+{
+    // The routing table is read by every submitting thread without a lock, so it can only change while the engine is stopped.
+    if(running_.load(std::memory_order_acquire))
+        throw std::logic_error(std::format("Symbol ({}) cannot be reassigned while the engine is running.", symbol));
+
+    if(shard >= shards_.size())
+        throw std::logic_error(std::format("Shard ({}) does not exist.", shard));
+
+    assignments_[symbol] = shard;
+}
+
+std::size_t OrderbookEngine::ShardOf(SymbolID symbol) const
+{
+    const auto it = assignments_.find(symbol);
+    return it != assignments_.end() ? it->second : symbol % shards_.size();
+}
+
+
+void OrderbookEngine::Start()
+{
+    if(running_.exchange(true, std::memory_order_acq_rel))
+        return;
+
+    shutdown_.store(false, std::memory_order_release);
+    for(std::size_t index = 0; index < shards_.size(); ++index)
+    {
+        auto& shard = *shards_[index];
+        shard.worker_ = std::thread{ [this, index] { RunShard(index); } };
+
+        if(index < options_.workerCpus_.size() && options_.workerCpus_[index] >= 0)
+            PinThread(shard.worker_, options_.workerCpus_[index]);
+    }
+}
+
+void OrderbookEngine::Stop()
+{
+    if(!running_.load(std::memory_order_acquire))
+        return;
+
+    shutdown_.store(true, std::memory_order_release);
+    for(auto& shard : shards_)
+        shard->commands_.Wake();
+
+    for(auto& shard : shards_)
+        shard->worker_.join();
+
+    running_.store(false, std::memory_order_release);
+}
+
+
+bool OrderbookEngine::Submit(SymbolID symbol, const OrderCommand& command)
+{
+    return shards_[ShardOf(symbol)]->commands_.TryPush(EngineCommand{ symbol, command });
+}
+
+
+void OrderbookEngine::OnSessionClose()
+{
+    // The symbol of this command doesn't matter, the worker applies it to every book of its shard.
+    for(auto& shard : shards_)
+        shard->commands_.Push(EngineCommand{ 0, OrderCommand::ExpireGoodForDay() });
+}
+
+
+void OrderbookEngine::DrainTrades(std::size_t shard, SymbolTrades& trades)
+{
+    shards_[shard]->trades_.ConsumeBatch(static_cast<std::size_t>(-1), [&trades](const SymbolTrade& trade) { trades.push_back(trade); });
+}
+
+void OrderbookEngine::DrainTrades(SymbolTrades& trades)
+{
+    for(std::size_t shard = 0; shard < shards_.size(); ++shard)
+        DrainTrades(shard, trades);
+}
+
+
+void OrderbookEngine::DrainResults(std::size_t shard, SymbolResults& results)
+{
+    shards_[shard]->results_.ConsumeBatch(static_cast<std::size_t>(-1), [&results](const SymbolResult& result) { results.push_back(result); });
+}
+
+void OrderbookEngine::DrainResults(SymbolResults& results)
+{
+    for(std::size_t shard = 0; shard < shards_.size(); ++shard)
+        DrainResults(shard, results);
+}
+
+
+std::vector<std::size_t> OrderbookEngine::GetQueueDepths() const
+{
+    std::vector<std::size_t> depths;
+    depths.reserve(shards_.size());
+    for(const auto& shard : shards_)
+        depths.push_back(shard->commands_.Size());
+
+    return depths;
+}
+
+
+Orderbook& OrderbookEngine::GetBook(Shard& shard, SymbolID symbol)
+{
+    auto& book = shard.books_[symbol];
+    if(!book)
+        book = std::make_unique<Orderbook>(options_.bookOptions_);
+
+    return *book;
+}
+
+
+void OrderbookEngine::RunShard(std::size_t shardIndex)
+{
+    auto& shard = *shards_[shardIndex];
+    std::vector<EngineCommand> batch;
+    std::vector<OrderCommand> commands;
+    BatchResult result;
+    batch.reserve(options_.batchSize_);
+
+    while(true)
+    {
+        // Take up to a batch of what is queued in one go, copied out of the ring so that its slots are released at once.
+        shard.commands_.ConsumeBatch(options_.batchSize_, [&batch](const EngineCommand& command) { batch.push_back(command); });
+
+        if(batch.empty())
+        {
+            // Commands submitted before Stop() are still applied, the ring is empty by the time we leave.
+            if(shutdown_.load(std::memory_order_acquire))
+                return;
+
+            shard.commands_.WaitForData();
+            continue;
+        }
+
+        // Runs of commands for the same symbol are handed to their book as one batch, reusing the same result buffers.
+        for(auto first = batch.begin(); first != batch.end(); )
+        {
+            if(first->command_.type_ == CommandType::ExpireGoodForDay)
+            {
+                for(auto& [symbol, book] : shard.books_)
+                    book->ExpireGoodForDayOrders();
+
+                ++first;
+                continue;
+            }
+
+            const auto symbol = first->symbol_;
+            auto last = first;
+            commands.clear();
+            for(; last != batch.end() && last->symbol_ == symbol && last->command_.type_ != CommandType::ExpireGoodForDay; ++last)
+                commands.push_back(last->command_);
+
+            result.Clear();
+            GetBook(shard, symbol).ProcessBatch(commands, result);
+
+            // A command's trades go out before its result, so whoever drains a result can already drain its trades.
+            // If the consumers fall behind we wait for them rather than drop results or trades.
+            for(const auto& commandResult : result.results_)
+            {
+                for(auto trade = commandResult.firstTrade_; trade < commandResult.firstTrade_ + commandResult.tradeCount_; ++trade)
+                    shard.trades_.Push(SymbolTrade{ symbol, result.trades_[trade] });
+
+                shard.results_.Push(SymbolResult{ symbol, commandResult.orderId_, commandResult.status_, commandResult.tradeCount_ });
+            }
+
+            first = last;
+        }
+
+        batch.clear();
+    }
+}
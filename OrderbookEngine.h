@@ -0,0 +1,128 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+
+#include "Usings.h"
+#include "Orderbook.h"
+#include "OrderCommand.h"
+#include "RingBuffer.h"
+
+// A command for one instrument, this is what gateway threads hand to the engine.
+struct EngineCommand
+{
+    SymbolID symbol_{ };
+    OrderCommand command_;
+};
+
+// A trade together with the instrument it happened on, this is what the engine hands back.
+struct SymbolTrade
+{
+    SymbolID symbol_{ };
+    Trade trade_{ TradeInfo{ }, TradeInfo{ } };
+};
+
+using SymbolTrades = std::vector<SymbolTrade>;
+
+// The outcome of a command for one instrument. Its trades are the next 'tradeCount_' of its shard's trade stream.
+struct SymbolResult
+{
+    SymbolID symbol_{ };
+    OrderID orderId_{ };
+    CommandStatus status_{ CommandStatus::Accepted };
+    std::uint32_t tradeCount_{ };
+};
+
+using SymbolResults = std::vector<SymbolResult>;
+
+struct EngineOptions
+{
+    std::size_t workerCount_{ 1 };
+    std::vector<int> workerCpus_;           // CPU to pin each worker to (by worker index), workers without an entry are not pinned.
+    OrderbookOptions bookOptions_;          // Used for every book the engine creates.
+    std::size_t commandCapacity_{ 1 << 16 }; // Size of each shard's inbound command ring.
+    std::size_t outputCapacity_{ 1 << 16 };  // Size of each shard's outbound rings, of results and of trades.
+    std::size_t batchSize_{ 256 };          // Maximum number of commands a worker takes from its ring at once.
+    WaitStrategy waitStrategy_{ WaitStrategy::Blocking };   // How an idle worker waits for commands.
+};
+
+/*
+** OrderbookEngine runs many Orderbooks (one per SymbolID) on a fixed set of worker threads.
+** Every symbol belongs to exactly one worker ('shard'), so a book is only ever touched by the thread of its shard.
+** Each shard has its own lock-free MPSC ring of inbound commands and its own SPSC rings of command results and trades,
+   shards never share any state, so throughput grows with the number of workers.
+** Every submitted command gets one SymbolResult, so a client learns whether its command was Rejected, RiskRejected
+   or NotFound. A shard's results and trades come out in the order its commands were applied, an ExpireGoodForDay
+   (see OnSessionClose()) has no result of its own.
+** The rings are bounded: Submit() fails while a shard's command ring is full, and a worker waits for room when its
+   results or trades aren't drained, rather than drop them. Both streams of every shard must be drained.
+** Books are created by their worker the first time a command for their symbol arrives.
+*/
+class OrderbookEngine
+{
+public:
+    explicit OrderbookEngine(const EngineOptions& options = { });
+    OrderbookEngine(const OrderbookEngine&) = delete;
+    void operator=(const OrderbookEngine&) = delete;
+    OrderbookEngine(OrderbookEngine&&) = delete;
+    void operator=(OrderbookEngine&&) = delete;
+    ~OrderbookEngine();
+
+    // Symbols go to shard (symbol % workerCount) unless they were assigned elsewhere before Start(), which is how hot symbols get rebalanced.
+    void AssignSymbol(SymbolID symbol, std::size_t shard);
+    std::size_t ShardOf(SymbolID symbol) const;
+    std::size_t ShardCount() const { return shards_.size(); }
+
+    void Start();
+    void Stop();    // Processes every command already submitted, then joins the workers.
+
+    // Safe to call from any number of threads. Returns false if the symbol's shard has no room left for the command.
+    bool Submit(SymbolID symbol, const OrderCommand& command);
+
+    // Queues an ExpireGoodForDay command on every shard, each worker then expires the GoodForDay orders of all its books.
+    // This is what an ExpiryScheduler calls at the close of the session, it waits for room if a ring is full.
+    void OnSessionClose();
+
+    // Moves the trades produced so far into 'trades', either for one shard or for all of them.
+    // Only one thread may drain the trades of a shard.
+    void DrainTrades(std::size_t shard, SymbolTrades& trades);
+    void DrainTrades(SymbolTrades& trades);
+
+    // Same for the results of the commands applied so far, and only one thread may drain the results of a shard.
+    // A command's trades are published before its result, so draining the results first, then the trades, gets every
+    // trade of every result drained.
+    void DrainResults(std::size_t shard, SymbolResults& results);
+    void DrainResults(SymbolResults& results);
+
+    // Number of commands submitted to each shard that its worker hasn't taken yet, from the ring positions.
+    std::vector<std::size_t> GetQueueDepths() const;
+
+private:
+    struct Shard
+    {
+        explicit Shard(const EngineOptions& options)
+            : commands_{ options.commandCapacity_, options.waitStrategy_ }
+            , results_{ options.outputCapacity_, WaitStrategy::BusySpin }  // Drained, their consumers never wait on them.
+            , trades_{ options.outputCapacity_, WaitStrategy::BusySpin }
+        { }
+
+        RingBuffer<EngineCommand, ProducerMode::Multi> commands_;
+        RingBuffer<SymbolResult, ProducerMode::Single> results_;
+        RingBuffer<SymbolTrade, ProducerMode::Single> trades_;
+
+        std::unordered_map<SymbolID, std::unique_ptr<Orderbook>> books_;   // Only ever touched by the shard's worker.
+        std::thread worker_;
+    };
+
+    EngineOptions options_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::unordered_map<SymbolID, std::size_t> assignments_;
+    std::atomic<bool> running_{ false };
+    std::atomic<bool> shutdown_{ false };
+
+    void RunShard(std::size_t shardIndex);
+    Orderbook& GetBook(Shard& shard, SymbolID symbol);
+};
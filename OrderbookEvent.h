@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Usings.h"
+#include "Side.h"
+#include "OrderType.h"
+#include "TradeInfo.h"
+
+enum class EventType
+{
+    Trade,              // bidTrade_/askTrade_ describe the two legs of the trade.
+    OrderAccepted,      // An order passed validation and is being added (it may trade straight away).
+    OrderCancelled,     // An order left the book without being filled, quantity_ is what was left of it.
+    LevelChanged,       // The aggregate of a price level changed, quantity_/count_ are the new totals (count_ == 0 --> level removed).
+};
+
+/*
+** OrderbookEvent is the single, fixed-size record every event of the book is described with.
+** Only the fields that make sense for the event type are filled in, the rest are left zeroed.
+*/
+struct OrderbookEvent
+{
+    EventType type_{ EventType::Trade };
+    Side side_{ Side::Buy };
+    OrderType orderType_{ OrderType::GoodTillCancel };
+    OrderID orderId_{ };
+    Price price_{ };
+    Quantity quantity_{ };
+    Quantity count_{ };
+    TradeInfo bidTrade_{ };
+    TradeInfo askTrade_{ };
+};
+
+/*
+** EventSink is a non-owning reference to any object with a 'void OnEvent(const OrderbookEvent&)' member.
+** The Orderbook is compiled on its own, so instead of a template parameter the sink is bound through a function
+   pointer generated per sink type: one direct call per event, no virtual table and no allocation.
+** Sinks are called on the thread that mutates the book, while it holds the book's lock. They must be quick and
+   must never call back into the book.
+*/
+class EventSink
+{
+public:
+    template<typename Sink>
+    EventSink(Sink& sink)
+        : context_{ &sink }
+        , onEvent_{ [](void* context, const OrderbookEvent& event) { static_cast<Sink*>(context)->OnEvent(event); } }
+    { }
+
+    void operator()(const OrderbookEvent& event) const { onEvent_(context_, event); }
+
+    bool operator==(const EventSink& other) const { return context_ == other.context_; }
+
+private:
+    void* context_;
+    void (*onEvent_)(void*, const OrderbookEvent&);
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <functional>
+
+#include "Usings.h"
+
+// Where the book gets the time its trade bars are bucketed by, replaced to replay a session with its original times.
+using TradeClock = std::function<std::chrono::system_clock::time_point()>;
+
+// Pre-trade limits checked by the book on every new order, see RiskGate. A limit of 0 is no limit, and with none set
+// (and trackAccounts_ off) there is no gate.
+struct RiskLimits
+{
+    Quantity maxOrderQuantity_{ };          // Largest quantity of a single order.
+    std::uint64_t maxOpenQuantity_{ };      // Per account: resting quantity of both sides, the new order's quantity included.
+    std::int64_t maxOpenNotional_{ };       // Per account: price times resting quantity of both sides, the new order's included.
+    Price priceCollar_{ };                  // Orders priced more than this below the best bid or above the best ask are rejected (a market
+                                            // order at the worst opposite price it is given, so it never sweeps past the collar).
+    std::size_t accountCapacity_{ 1024 };   // Accounts are counted in a flat table, orders of an AccountID past it are rejected.
+    bool trackAccounts_{ false };           // Keep the accounts of the resting orders without any limit, for mass cancels by account.
+
+    bool Any() const { return maxOrderQuantity_ != 0 || maxOpenQuantity_ != 0 || maxOpenNotional_ != 0 || priceCollar_ != 0 || trackAccounts_; }
+};
+
+// Settings used when constructing an Orderbook. The defaults suit an instrument quoted in whole price units.
+struct OrderbookOptions
+{
+    Price tickSize_{ 1 };                   // Every order price must be a multiple of the tick size.
+    std::size_t initialLevels_{ 4096 };     // Number of price levels each side of the book starts with.
+    std::size_t maxLevels_{ 1 << 20 };      // Orders that would stretch one side of the book over more levels than this are rejected.
+    std::size_t orderCapacity_{ };          // Number of resting orders to preallocate storage for at construction.
+    bool denseOrderIds_{ false };           // Set when the venue hands out (mostly) sequential OrderIDs, see OrderIndex.
+    OrderID firstOrderId_{ };               // The first OrderID expected when denseOrderIds_ is set.
+    std::size_t depthLevels_{ 10 };         // Number of levels per side kept in the cached DepthSnapshot.
+    bool publishL2Updates_{ false };        // Keep a stream of L2Updates for DrainL2Updates(), it grows until it is drained.
+    bool conflateL2Updates_{ false };       // Merge the updates of a level between two drains into one.
+    bool singleWriter_{ false };            // Set when one thread owns the book (see OrderbookSequencer), the book then takes no locks.
+    bool bookBuilding_{ false };            // Mirror another venue's book (see FeedBookBuilder): orders never match, trades only come from Execute commands.
+    std::size_t tradeBarCount_{ };          // Number of OHLCV bars kept (see TradeStatisticsRecorder), 0 keeps none and never reads the clock.
+    std::chrono::nanoseconds tradeBarInterval_{ std::chrono::minutes{ 1 } };
+    TradeClock tradeClock_{ [] { return std::chrono::system_clock::now(); } };
+    RiskLimits riskLimits_{ };
+};
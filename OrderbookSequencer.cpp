@@ -0,0 +1,91 @@
+#include "OrderbookSequencer.h"
+
+OrderbookSequencer::OrderbookSequencer(const OrderbookOptions& bookOptions, const SequencerOptions& options)
+    : options_{ options }
+    , orderbook_{ SingleWriter(bookOptions) }
+    , commands_{ options.commandCapacity_, options.waitStrategy_ }
+    , output_{ options.outputCapacity_, WaitStrategy::BusySpin }    // Polled, its consumer never waits on it.
+{
+    batch_.reserve(options_.batchSize_);
+
+    // The journal is attached before the book thread starts, from then on only that thread touches the book.
+    if(options_.journal_)
+        orderbook_.AttachJournal(*options_.journal_);
+    if(options_.tradeLog_)
+        orderbook_.AttachTradeLog(*options_.tradeLog_);
+
+    bookThread_ = std::thread{ [this] { Run(); } };
+}
+
+OrderbookSequencer::~OrderbookSequencer()
+{
+    shutdown_.store(true, std::memory_order_release);
+    commands_.Wake();
+    bookThread_.join();
+}
+
+
+bool OrderbookSequencer::Submit(const OrderCommand& command, std::uint64_t* sequence)
+{
+    return commands_.TryPush(command, sequence);
+}
+
+
+void OrderbookSequencer::OnSessionClose()
+{
+    commands_.Push(OrderCommand::ExpireGoodForDay());
+}
+
+
+std::size_t OrderbookSequencer::PollOutput(std::vector<SequencerOutput>& output, std::size_t maxCount)
+{
+    return output_.ConsumeBatch(maxCount, [&output](const SequencerOutput& record) { output.push_back(record); });
+}
+
+
+void OrderbookSequencer::Run()
+{
+    while(true)
+    {
+        commands_.ConsumeBatch(options_.batchSize_, [this](const OrderCommand& command) { batch_.push_back(command); });
+
+        if(!batch_.empty())
+        {
+            Apply();
+            continue;
+        }
+
+        // Commands submitted before the shutdown request are still applied, the ring is empty by the time we leave.
+        if(shutdown_.load(std::memory_order_acquire))
+            return;
+
+        commands_.WaitForData();
+    }
+}
+
+
+void OrderbookSequencer::Apply()
+{
+    const auto firstSequence = processedSequence_.load(std::memory_order_relaxed);
+
+    // The whole batch goes through the book at once: one pass of ProcessBatch and one top of book update.
+    // The commands are copied out of the ring as ProcessBatch takes them in one contiguous span.
+    result_.Clear();
+    orderbook_.ProcessBatch(batch_, result_);
+
+    // If the consumer falls behind we wait for it rather than drop results or trades.
+    for(std::size_t index = 0; index < result_.results_.size(); ++index)
+    {
+        const auto& commandResult = result_.results_[index];
+        const auto sequence = firstSequence + index;
+        output_.Push(SequencerOutput{ .sequence_ = sequence, .type_ = SequencerOutputType::Result, .status_ = commandResult.status_,
+            .tradeCount_ = commandResult.tradeCount_, .orderId_ = commandResult.orderId_ });
+
+        for(auto trade = commandResult.firstTrade_; trade < commandResult.firstTrade_ + commandResult.tradeCount_; ++trade)
+            output_.Push(SequencerOutput{ .sequence_ = sequence, .type_ = SequencerOutputType::Trade,
+                .bidTrade_ = result_.trades_[trade].GetBidTrade(), .askTrade_ = result_.trades_[trade].GetAskTrade() });
+    }
+
+    processedSequence_.store(firstSequence + batch_.size(), std::memory_order_release);
+    batch_.clear();
+}
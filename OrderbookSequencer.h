@@ -0,0 +1,105 @@
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "Orderbook.h"
+#include "OrderCommand.h"
+#include "RingBuffer.h"
+
+enum class SequencerOutputType : std::uint8_t
+{
+    Result,     // The outcome of a command, followed by its 'tradeCount_' trades.
+    Trade,
+};
+
+/*
+** What the sequencer publishes on its outbound ring. 'sequence_' is the sequence number of the command the record
+   belongs to: every command gets one Result record, immediately followed by a Trade record per trade it produced.
+*/
+struct SequencerOutput
+{
+    std::uint64_t sequence_{ };
+    SequencerOutputType type_{ SequencerOutputType::Result };
+    CommandStatus status_{ CommandStatus::Accepted };       // Result only.
+    std::uint32_t tradeCount_{ };                           // Result only.
+    OrderID orderId_{ };                                    // Result only.
+    TradeInfo bidTrade_{ };                                 // Trade only.
+    TradeInfo askTrade_{ };                                 // Trade only.
+};
+
+struct SequencerOptions
+{
+    std::size_t commandCapacity_{ 1 << 16 };    // Size of the inbound command ring.
+    std::size_t outputCapacity_{ 1 << 16 };     // Size of the outbound ring of results and trades.
+    std::size_t batchSize_{ 256 };              // Maximum number of commands applied per drain of the inbound ring.
+    WaitStrategy waitStrategy_{ WaitStrategy::Blocking };
+    CommandJournal* journal_{ nullptr };        // Attached to the book when set, see Orderbook::AttachJournal().
+    TradeLog* tradeLog_{ nullptr };             // Same, see Orderbook::AttachTradeLog().
+};
+
+/*
+** OrderbookSequencer gives an Orderbook a single writer: any number of gateway threads Submit() commands into a
+   lock-free MPSC ring, and one book thread drains that ring in batches and applies the commands in ring order.
+** The position a command got in the ring is its sequence number, so the order commands are applied in is decided
+   once, up front, and is the same order they are acknowledged in.
+** The book thread hands each drained batch of commands to the book at once, through ProcessBatch().
+** The book runs in single writer mode (no mutex at all). The result of every command, then its trades, are published
+   on an SPSC ring that one consumer thread reads with PollOutput(), so a gateway learns the outcome of its command.
+*/
+class OrderbookSequencer
+{
+public:
+    explicit OrderbookSequencer(const OrderbookOptions& bookOptions = { }, const SequencerOptions& options = { });
+    OrderbookSequencer(const OrderbookSequencer&) = delete;
+    void operator=(const OrderbookSequencer&) = delete;
+    OrderbookSequencer(OrderbookSequencer&&) = delete;
+    void operator=(OrderbookSequencer&&) = delete;
+    ~OrderbookSequencer();
+
+    // Safe to call from any number of threads. Returns false if the inbound ring is full,
+    // otherwise 'sequence' (if given) receives the sequence number of the command.
+    bool Submit(const OrderCommand& command, std::uint64_t* sequence = nullptr);
+
+    // Queues an ExpireGoodForDay command, so the book expires its GoodForDay orders on the book thread, in sequence
+    // with everything else. Called by an ExpiryScheduler, it waits for room if the inbound ring is full.
+    void OnSessionClose();
+
+    // Appends up to 'maxCount' published results and trades to 'output'. Only one thread may poll.
+    std::size_t PollOutput(std::vector<SequencerOutput>& output, std::size_t maxCount = static_cast<std::size_t>(-1));
+
+    // The book's instrumentation, readable from any thread (null unless built with ORDERBOOK_INSTRUMENTATION).
+    const BookMetrics* GetMetrics() const { return orderbook_.GetMetrics(); }
+
+    // The book's best bid and ask, readable from any thread without locking or slowing the book thread down.
+    TopOfBook GetTopOfBook() const { return orderbook_.GetTopOfBook(); }
+
+    // The book's trade statistics and bars, readable from any thread the same way.
+    TradeStatistics GetTradeStatistics() const { return orderbook_.GetTradeStatistics(); }
+    std::size_t GetTradeBars(std::vector<TradeBar>& bars) const { return orderbook_.GetTradeBars(bars); }
+
+    // Every command with a sequence number below this one has been applied to the book.
+    std::uint64_t GetProcessedSequence() const { return processedSequence_.load(std::memory_order_acquire); }
+
+private:
+    SequencerOptions options_;
+    Orderbook orderbook_;
+    RingBuffer<OrderCommand, ProducerMode::Multi> commands_;
+    RingBuffer<SequencerOutput, ProducerMode::Single> output_;
+    alignas(CacheLineSize) std::atomic<std::uint64_t> processedSequence_{ };
+    std::atomic<bool> shutdown_{ false };
+    std::vector<OrderCommand> batch_;
+    BatchResult result_;
+    std::thread bookThread_;
+
+    void Run();
+    void Apply();
+
+    static OrderbookOptions SingleWriter(OrderbookOptions options)
+    {
+        options.singleWriter_ = true;
+        return options;
+    }
+};
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <exception>
+#include <format>
+
+#include "Usings.h"
+#include "Side.h"
+#include "SideTraits.h"
+#include "LevelBitmap.h"
+
+/*
+** PriceLadder stores one side of the Orderbook as a flat array of price levels instead of a std::map.
+** A price is turned into a 'tick' (price / tickSize) and the level for that tick lives at levels_[tick - firstTick_],
+   so finding the level for a price is a subtraction instead of a tree walk.
+** The LevelBitmap remembers which levels are occupied, so the best (and next best) price is a find-first-set away.
+** When a price falls outside of the array we re-center the array around the occupied prices, growing it if needed.
+** The side is a template parameter, so which end of the array is the best price is decided at compile time.
+*/
+template<typename Level, Side S>
+class PriceLadder
+{
+public:
+    static constexpr std::size_t npos = LevelBitmap::npos;
+    static constexpr Side LadderSide = S;
+
+    PriceLadder(Price tickSize, std::size_t initialLevels, std::size_t maxLevels)
+        : tickSize_{ tickSize }
+        , maxLevels_{ std::max(maxLevels, std::size_t{ 1 }) }
+        , levels_(std::clamp(initialLevels, std::min<std::size_t>(64, maxLevels_), maxLevels_))
+    {
+        if(tickSize_ <= 0)
+            throw std::logic_error(std::format("Tick size ({}) must be positive.", tickSize_));
+
+        occupied_.Resize(levels_.size());
+    }
+
+    bool Empty() const { return levelCount_ == 0; }
+    std::size_t LevelCount() const { return levelCount_; }
+    Price GetTickSize() const { return tickSize_; }
+
+    // Bids are best at the highest price while asks are best at the lowest price.
+    std::size_t Best() const
+    {
+        if constexpr(S == Side::Buy)
+            return occupied_.FindLast();
+        else
+            return occupied_.FindFirst();
+    }
+
+    std::size_t Worst() const
+    {
+        if constexpr(S == Side::Buy)
+            return occupied_.FindFirst();
+        else
+            return occupied_.FindLast();
+    }
+
+    std::size_t NextWorse(std::size_t index) const
+    {
+        if constexpr(S == Side::Buy)
+            return index == 0 ? npos : occupied_.FindPrev(index - 1);
+        else
+            return occupied_.FindNext(index + 1);
+    }
+
+    // The best occupied level priced at 'price' or worse, npos if there is none. Used to walk the levels of a price range.
+    std::size_t FindAtOrWorse(Price price) const
+    {
+        // Rounded to the tick on the worse side, for a bid the one below and for an ask the one above.
+        auto tick = TickOf(price);
+        if(tick * tickSize_ != price)
+            tick += S == Side::Buy ? -(price < 0) : (price > 0);
+
+        const auto offset = tick - firstTick_;
+        if constexpr(S == Side::Buy)
+            return offset < 0 ? npos : occupied_.FindPrev(static_cast<std::size_t>(std::min<std::int64_t>(offset, static_cast<std::int64_t>(levels_.size()) - 1)));
+        else
+            return offset >= static_cast<std::int64_t>(levels_.size()) ? npos : occupied_.FindNext(static_cast<std::size_t>(std::max<std::int64_t>(offset, 0)));
+    }
+
+    Price PriceAt(std::size_t index) const { return static_cast<Price>((firstTick_ + static_cast<std::int64_t>(index)) * tickSize_); }
+    Level& LevelAt(std::size_t index) { return levels_[index]; }
+    const Level& LevelAt(std::size_t index) const { return levels_[index]; }
+
+    bool IsOnTick(Price price) const { return price % tickSize_ == 0; }
+
+    // Returns true if a level at this price can be stored without breaking the maxLevels_ limit.
+    bool CanHold(Price price) const
+    {
+        if(!IsOnTick(price))
+            return false;
+
+        if(Empty())
+            return true;
+
+        const auto tick = TickOf(price);
+        const auto low = std::min(tick, firstTick_ + static_cast<std::int64_t>(occupied_.FindFirst()));
+        const auto high = std::max(tick, firstTick_ + static_cast<std::int64_t>(occupied_.FindLast()));
+        return static_cast<std::size_t>(high - low + 1) <= maxLevels_;
+    }
+
+    // Returns true if every level from 'low' to 'high' fits in the ladder at once, used when a whole side is loaded in one go.
+    bool CanHold(Price low, Price high) const
+    {
+        return IsOnTick(low) && IsOnTick(high) && low <= high && static_cast<std::size_t>(TickOf(high) - TickOf(low) + 1) <= maxLevels_;
+    }
+
+    // Returns the index of an occupied price level (npos when there are no orders at that price).
+    std::size_t Find(Price price) const
+    {
+        if(!IsOnTick(price))
+            return npos;
+
+        const auto offset = TickOf(price) - firstTick_;
+        if(offset < 0 || offset >= static_cast<std::int64_t>(levels_.size()) || !occupied_.Test(offset))
+            return npos;
+
+        return static_cast<std::size_t>(offset);
+    }
+
+    // Returns the index of the level for 'price', marking it occupied and re-centering the ladder if required.
+    // Note that re-centering moves levels around, so any index obtained before this call is invalidated.
+    std::size_t Insert(Price price)
+    {
+        if(!IsOnTick(price))
+            throw std::logic_error(std::format("Price ({}) is not a multiple of the tick size ({}).", price, tickSize_));
+
+        auto offset = TickOf(price) - firstTick_;
+        if(offset < 0 || offset >= static_cast<std::int64_t>(levels_.size()))
+        {
+            Recenter(TickOf(price));
+            offset = TickOf(price) - firstTick_;
+        }
+
+        if(!occupied_.Test(offset))
+        {
+            occupied_.Set(offset);
+            ++levelCount_;
+        }
+
+        return static_cast<std::size_t>(offset);
+    }
+
+    // The bytes of the level array and the bitmap, plus whatever the levels hold themselves when Level has a MemoryUsage().
+    std::size_t MemoryUsage() const
+    {
+        auto bytes = levels_.capacity() * sizeof(Level) + occupied_.MemoryUsage();
+        if constexpr(requires(const Level& level) { level.MemoryUsage(); })
+        {
+            for(const auto& level : levels_)
+                bytes += level.MemoryUsage();
+        }
+
+        return bytes;
+    }
+
+    // Releases a level, the slot is reset so that it is ready to be used again. A Level with a Clear() member
+    // is cleared instead of replaced, which lets it keep the storage it allocated for the next orders at that price.
+    void Erase(std::size_t index)
+    {
+        if constexpr(requires(Level& level) { level.Clear(); })
+            levels_[index].Clear();
+        else
+            levels_[index] = Level{ };
+
+        occupied_.Clear(index);
+        --levelCount_;
+    }
+
+private:
+    Price tickSize_;
+    std::size_t maxLevels_;
+    std::int64_t firstTick_{ };
+    std::vector<Level> levels_;
+    LevelBitmap occupied_;
+    std::size_t levelCount_{ };
+
+    std::int64_t TickOf(Price price) const { return price / tickSize_; }
+
+    void Recenter(std::int64_t tick)
+    {
+        const auto size = levels_.size();
+
+        // An empty ladder can simply be moved so that the new price sits in the middle.
+        if(Empty())
+        {
+            firstTick_ = tick - static_cast<std::int64_t>(size / 2);
+            return;
+        }
+
+        const auto low = std::min(tick, firstTick_ + static_cast<std::int64_t>(occupied_.FindFirst()));
+        const auto high = std::max(tick, firstTick_ + static_cast<std::int64_t>(occupied_.FindLast()));
+        const auto span = static_cast<std::size_t>(high - low + 1);
+
+        // Leave as much room on both sides of the occupied prices as we had before, doubling until that is the case.
+        auto newSize = size;
+        while(newSize < span * 2 && newSize < maxLevels_)
+            newSize *= 2;
+        newSize = std::max(span, std::min(newSize, maxLevels_));
+
+        const auto newFirstTick = low - static_cast<std::int64_t>((newSize - span) / 2);
+
+        std::vector<Level> levels(newSize);
+        LevelBitmap occupied;
+        occupied.Resize(newSize);
+
+        for(auto index = occupied_.FindFirst(); index != npos; index = occupied_.FindNext(index + 1))
+        {
+            const auto newIndex = static_cast<std::size_t>(firstTick_ + static_cast<std::int64_t>(index) - newFirstTick);
+            levels[newIndex] = std::move(levels_[index]);
+            occupied.Set(newIndex);
+        }
+
+        levels_ = std::move(levels);
+        occupied_ = std::move(occupied);
+        firstTick_ = newFirstTick;
+    }
+};
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <bit>
+#include <thread>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+constexpr std::size_t CacheLineSize = 64;
+
+enum class WaitStrategy
+{
+    BusySpin,   // The consumer never sleeps, lowest latency at the cost of a core spinning at 100%.
+    Blocking,   // The consumer spins for a little while, then sleeps on a futex (std::atomic::wait) until a producer wakes it.
+};
+
+enum class ProducerMode
+{
+    Single,     // Exactly one thread pushes (SPSC).
+    Multi,      // Any number of threads push (MPSC).
+};
+
+inline void CpuRelax()
+{
+#if defined(_MSC_VER)
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+/*
+** RingBuffer is a bounded, lock-free queue with a single consumer and either one or many producers.
+** Every slot carries a sequence number that tells whose turn it is: a producer may write slot (position % capacity)
+   once its sequence equals 'position', the consumer may read it once its sequence equals 'position + 1'.
+   This is the well known bounded queue design by Dmitry Vyukov.
+** The producer and consumer counters sit on their own cache lines, so the two sides never false-share.
+** The consumer drains in batches through ConsumeBatch(), reading the values in place without copying them out.
+*/
+template<typename T, ProducerMode Mode = ProducerMode::Multi>
+class RingBuffer
+{
+public:
+    // 'consumerWait' is how the consumer waits in WaitForData(). A consumer that never sleeps (BusySpin, or one that
+    // only ever polls) spares the producers the fence they otherwise need on every push to find out whether to wake it.
+    explicit RingBuffer(std::size_t capacity, WaitStrategy consumerWait = WaitStrategy::Blocking)
+        : slots_(std::bit_ceil(std::max<std::size_t>(capacity, 2)))
+        , mask_{ slots_.size() - 1 }
+        , consumerWait_{ consumerWait }
+    {
+        for(std::size_t index = 0; index < slots_.size(); ++index)
+            slots_[index].sequence_.store(index, std::memory_order_relaxed);
+    }
+
+    std::size_t Capacity() const { return slots_.size(); }
+
+    // Approximate number of queued values, exact when called from the consumer with no producer active.
+    std::size_t Size() const
+    {
+        const auto tail = tail_.value_.load(std::memory_order_acquire);
+        const auto head = head_.value_.load(std::memory_order_acquire);
+        return tail > head ? static_cast<std::size_t>(tail - head) : 0;
+    }
+
+    // Number of values pushed so far, exact when called with no push in progress. The next push gets this position.
+    std::uint64_t PushedCount() const { return tail_.value_.load(std::memory_order_acquire); }
+
+    bool Empty() const
+    {
+        const auto head = head_.value_.load(std::memory_order_relaxed);
+        return slots_[head & mask_].sequence_.load(std::memory_order_acquire) != head + 1;
+    }
+
+    // Returns false if the ring is full. On success 'position' (if given) receives the value's position in the ring,
+    // positions start at zero and increase by one with every push, so they double as sequence numbers.
+    bool TryPush(const T& value, std::uint64_t* position = nullptr)
+    {
+        auto tail = tail_.value_.load(std::memory_order_relaxed);
+        Slot* slot;
+
+        while(true)
+        {
+            slot = &slots_[tail & mask_];
+            const auto sequence = slot->sequence_.load(std::memory_order_acquire);
+
+            if(sequence < tail)
+                return false;   // The consumer hasn't released this slot yet, the ring is full.
+
+            if(sequence == tail)
+            {
+                if constexpr(Mode == ProducerMode::Single)
+                {
+                    tail_.value_.store(tail + 1, std::memory_order_relaxed);
+                    break;
+                }
+                else if(tail_.value_.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else
+                tail = tail_.value_.load(std::memory_order_relaxed);   // Another producer claimed this position first.
+        }
+
+        slot->value_ = value;
+        slot->sequence_.store(tail + 1, std::memory_order_release);
+
+        if(position)
+            *position = tail;
+
+        WakeConsumer();
+        return true;
+    }
+
+    // Spins until there is room in the ring.
+    std::uint64_t Push(const T& value)
+    {
+        std::uint64_t position;
+        while(!TryPush(value, &position))
+            CpuRelax();
+
+        return position;
+    }
+
+    // Calls function(value) for up to 'maxCount' queued values, in order, and releases their slots. Consumer thread only.
+    template<typename Function>
+    std::size_t ConsumeBatch(std::size_t maxCount, Function function)
+    {
+        auto head = head_.value_.load(std::memory_order_relaxed);
+        std::size_t count = 0;
+
+        for(; count < maxCount; ++count, ++head)
+        {
+            auto& slot = slots_[head & mask_];
+            if(slot.sequence_.load(std::memory_order_acquire) != head + 1)
+                break;
+
+            function(slot.value_);
+            slot.sequence_.store(head + slots_.size(), std::memory_order_release);
+        }
+
+        head_.value_.store(head, std::memory_order_release);
+        return count;
+    }
+
+    // Waits until the ring has data or Wake() is called, the way the ring was built for. Consumer thread only.
+    void WaitForData()
+    {
+        for(int spin = 0; consumerWait_ == WaitStrategy::BusySpin || spin < SpinsBeforeSleeping; ++spin)
+        {
+            if(!Empty() || TakeWakeRequest())
+                return;
+
+            CpuRelax();
+        }
+
+        // Announce that we are about to sleep, the fence pairs with the one in WakeConsumer() so that either
+        // we see the new value or the producer sees 'sleeping_' and bumps the signal.
+        sleeping_.value_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        const auto signal = signal_.value_.load(std::memory_order_acquire);
+        if(Empty() && !TakeWakeRequest())
+            signal_.value_.wait(signal, std::memory_order_acquire);
+
+        sleeping_.value_.store(false, std::memory_order_relaxed);
+        TakeWakeRequest();
+    }
+
+    // Wakes up the consumer even though there is no data, used to ask it to shut down.
+    void Wake()
+    {
+        wakeRequested_.value_.store(true, std::memory_order_release);
+        signal_.value_.fetch_add(1, std::memory_order_acq_rel);
+        signal_.value_.notify_one();
+    }
+
+private:
+    static constexpr int SpinsBeforeSleeping = 1024;
+
+    struct Slot
+    {
+        std::atomic<std::uint64_t> sequence_{ };
+        T value_{ };
+    };
+
+    template<typename Value>
+    struct alignas(CacheLineSize) Padded
+    {
+        Value value_{ };
+    };
+
+    std::vector<Slot> slots_;
+    std::size_t mask_;
+    WaitStrategy consumerWait_;
+
+    Padded<std::atomic<std::uint64_t>> tail_;       // Next position a producer will claim.
+    Padded<std::atomic<std::uint64_t>> head_;       // Next position the consumer will read.
+    Padded<std::atomic<bool>> sleeping_;
+    Padded<std::atomic<std::uint32_t>> signal_;
+    Padded<std::atomic<bool>> wakeRequested_;
+
+    void WakeConsumer()
+    {
+        if(consumerWait_ == WaitStrategy::BusySpin)
+            return;
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(sleeping_.value_.load(std::memory_order_relaxed))
+        {
+            signal_.value_.fetch_add(1, std::memory_order_acq_rel);
+            signal_.value_.notify_one();
+        }
+    }
+
+    bool TakeWakeRequest()
+    {
+        return wakeRequested_.value_.load(std::memory_order_relaxed) && wakeRequested_.value_.exchange(false, std::memory_order_acq_rel);
+    }
+};
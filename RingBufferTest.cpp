@@ -0,0 +1,211 @@
+// RingBuffer with one producer: claims wrap around a ring of 8 and come out in order, a full ring refuses a push.
+// With many producers, each producer's values must arrive in its own order and none may be lost, with the consumer
+// spinning or asleep on the futex. A sleeping consumer must wake for a push and for Wake(), and a SharedRing over plain
+// memory must wrap around the same way.
+//
+//     RingBufferTest
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "RingBuffer.h"
+#include "SharedMemory.h"
+#include "TestCheck.h"
+
+namespace
+{
+    // Values carry their producer in the top bits and that producer's count in the others.
+    constexpr std::uint64_t ProducerShift = 48;
+
+    void SingleProducerWrapsAround()
+    {
+        RingBuffer<std::uint64_t, ProducerMode::Single> ring{ 8 };
+        Check(ring.Capacity() == 8, "capacity is rounded to a power of two");
+
+        std::uint64_t next{ };
+        std::uint64_t expected{ };
+        for(int round = 0; round < 100; ++round)
+        {
+            // Fill the ring to the brim, so every round starts at a different slot.
+            while(ring.TryPush(next))
+                ++next;
+            Check(ring.Size() == ring.Capacity(), "a full ring holds exactly its capacity");
+            Check(!ring.TryPush(next), "a full ring refuses a push");
+
+            const auto consumed = ring.ConsumeBatch(3 + round % 5, [&](std::uint64_t value)
+            {
+                Check(value == expected, "values come out in push order across the wrap");
+                ++expected;
+            });
+            Check(consumed == static_cast<std::size_t>(3 + round % 5), "ConsumeBatch stops at maxCount");
+        }
+
+        ring.ConsumeBatch(ring.Capacity(), [&](std::uint64_t value) { Check(value == expected++, "the rest drains in order"); });
+        Check(ring.Empty() && ring.PushedCount() == next, "positions count every push");
+    }
+
+    void ManyProducersKeepTheirOrder(WaitStrategy strategy, std::uint64_t perProducer)
+    {
+        constexpr std::size_t Producers = 4;
+        RingBuffer<std::uint64_t, ProducerMode::Multi> ring{ 64, strategy };
+
+        std::vector<std::uint64_t> positions(Producers * perProducer);
+        std::vector<std::thread> producers;
+        for(std::uint64_t producer = 0; producer < Producers; ++producer)
+        {
+            producers.emplace_back([&, producer]
+            {
+                // Yields rather than spins on a full ring, the test has to pass on machines with fewer cores than threads.
+                for(std::uint64_t count = 0; count < perProducer; )
+                {
+                    if(ring.TryPush(producer << ProducerShift | count, &positions[producer * perProducer + count]))
+                        ++count;
+                    else
+                        std::this_thread::yield();
+                }
+            });
+        }
+
+        // Every value arrives once, each producer's values in the order it pushed them.
+        std::vector<std::uint64_t> nextCount(Producers);
+        std::vector<std::uint64_t> readAt(Producers * perProducer);
+        std::uint64_t position{ };
+        bool ordered = true;
+        while(position < Producers * perProducer)
+        {
+            const auto consumed = ring.ConsumeBatch(32, [&](std::uint64_t value)
+            {
+                const auto producer = value >> ProducerShift;
+                const auto count = value & ((std::uint64_t{ 1 } << ProducerShift) - 1);
+                ordered = ordered && producer < Producers && count == nextCount[producer]++;
+                if(ordered)
+                    readAt[producer * perProducer + count] = position;
+                ++position;
+            });
+
+            if(consumed == 0)
+                ring.WaitForData();
+        }
+
+        for(auto& producer : producers)
+            producer.join();
+
+        // Push() returns once the value is published, so the positions are only compared after the producers are done.
+        Check(ordered, "each producer's values arrive once and in its order");
+        Check(positions == readAt, "a value is read at the position its Push() returned");
+        Check(ring.Empty(), "nothing is left once every value is consumed");
+    }
+
+    void BlockingConsumerIsWoken()
+    {
+        RingBuffer<int, ProducerMode::Multi> ring{ 16, WaitStrategy::Blocking };
+        std::atomic<int> received{ };
+        std::atomic<bool> stop{ false };
+
+        std::thread consumer{ [&]
+        {
+            while(true)
+            {
+                if(ring.ConsumeBatch(16, [&](int value) { received.fetch_add(value); }) != 0)
+                    continue;
+                if(stop.load())
+                    return;
+                ring.WaitForData();
+            }
+        } };
+
+        // Pauses long enough for the consumer to go to sleep between pushes, each push has to wake it.
+        for(int push = 0; push < 20; ++push)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 2 });
+            ring.Push(1);
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{ 5 };
+        while(received.load() != 20 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::yield();
+        Check(received.load() == 20, "a sleeping consumer is woken by every push");
+
+        // Wake() gets it out of WaitForData() with nothing in the ring, which is how owners shut it down.
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 5 });
+        stop.store(true);
+        ring.Wake();
+        consumer.join();
+        Check(true, "Wake() ends a wait on an empty ring");
+    }
+
+    void SharedRingWrapsAround()
+    {
+        struct Record
+        {
+            std::uint64_t value_;
+            std::uint32_t check_;
+        };
+
+        constexpr std::size_t Capacity = 16;
+        constexpr std::uint64_t Count = 200'000;
+        auto memory = std::make_unique<std::byte[]>(SharedRing<Record>::BytesFor(Capacity) + CacheLineSize);
+        auto* aligned = reinterpret_cast<std::byte*>((reinterpret_cast<std::uintptr_t>(memory.get()) + CacheLineSize - 1) / CacheLineSize * CacheLineSize);
+        SharedRing<Record>::Initialize(aligned);
+
+        // Each side builds its own ring over the same bytes, as two processes do.
+        SharedRing<Record> producerRing{ aligned, Capacity };
+        SharedRing<Record> consumerRing{ aligned, Capacity };
+        Check(producerRing.FreeSlots() == Capacity, "a new ring is empty");
+
+        std::thread producer{ [&]
+        {
+            for(std::uint64_t value = 0; value < Count; )
+            {
+                if(producerRing.TryPush(Record{ value, static_cast<std::uint32_t>(value * 2654435761u) }))
+                    ++value;
+                else
+                    std::this_thread::yield();
+            }
+        } };
+
+        std::uint64_t expected{ };
+        bool intact = true;
+        while(expected < Count)
+        {
+            const auto consumed = consumerRing.ConsumeBatch(7, [&](const Record& record)
+            {
+                intact = intact && record.value_ == expected && record.check_ == static_cast<std::uint32_t>(expected * 2654435761u);
+                ++expected;
+            });
+
+            if(consumed == 0)
+                std::this_thread::yield();
+        }
+        producer.join();
+
+        Check(intact, "records cross the shared ring whole and in order");
+        Check(producerRing.FreeSlots() == Capacity, "a drained ring is empty for the producer");
+        Check(consumerRing.ConsumeBatch(1, [](const Record&) { }) == 0, "a drained ring is empty for the consumer");
+
+        for(std::size_t index = 0; index < Capacity; ++index)
+            producerRing.TryPush(Record{ index, 0 });
+        Check(!producerRing.TryPush(Record{ }), "a full shared ring refuses a push");
+        producerRing.Reset();
+        consumerRing.Reset();
+        Check(producerRing.FreeSlots() == Capacity, "Reset() empties the ring");
+    }
+}
+
+
+int main()
+{
+    SingleProducerWrapsAround();
+    ManyProducersKeepTheirOrder(WaitStrategy::Blocking, 50'000);
+    // A spinning consumer holds its core for a whole time slice while the ring is empty, fewer values keep the test
+    // short where it shares a core with the producers.
+    ManyProducersKeepTheirOrder(WaitStrategy::BusySpin, 5'000);
+    BlockingConsumerIsWoken();
+    SharedRingWrapsAround();
+
+    return CheckResult("ring buffer");
+}
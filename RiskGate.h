@@ -0,0 +1,183 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <algorithm>
+#include <utility>
+
+#include "Usings.h"
+#include "OrderbookOptions.h"
+#include "OrderRecord.h"
+
+// What the resting orders of one account add up to on a book.
+struct AccountExposure
+{
+    std::uint64_t openQuantity_{ };
+    std::int64_t openNotional_{ };      // Price times resting quantity, at the prices of the orders themselves.
+};
+
+/*
+** RiskGate is the book's pre-trade check: every new order (and every modify that re-queues one) is held against the
+   book's RiskLimits before it goes on the book, and one that fails them is answered CommandStatus::RiskRejected.
+** The exposure of every account is a pair of running counters kept up to date as its orders are added, filled,
+   reduced and cancelled, so a check is a handful of comparisons and never walks the account's orders.
+** Accounts index a flat table and the account of every resting order is kept by OrderHandle, next to the pool, as
+   OrderRecords have no room for it. Orders without an account only get the order size and price collar checks.
+** The orders of every account are also linked in a list (by handle as well), so that cancelling an account's orders
+   only visits those orders.
+** A book built without any limit or account tracking has a disabled gate: it allocates nothing and each hook is a single branch.
+*/
+class RiskGate
+{
+public:
+    explicit RiskGate(const RiskLimits& limits)
+        : limits_{ limits }
+        , enabled_{ limits.Any() }
+    {
+        if(enabled_)
+            accounts_.resize(limits_.accountCapacity_);
+    }
+
+    bool Enabled() const { return enabled_; }
+    bool HasRoomFor(AccountID account) const { return account < accounts_.size(); }
+
+    void Reserve(std::size_t orderCapacity)
+    {
+        if(enabled_ && orderAccounts_.size() < orderCapacity)
+        {
+            orderAccounts_.resize(orderCapacity, NoAccount);
+            links_.resize(orderCapacity);
+        }
+    }
+
+    /*
+    ** Whether an order of 'quantity' at 'price' may go on the book of which 'bestBid' and 'bestAsk' are the best prices.
+    ** A modify checks its new order while the old one is still resting, 'releasedQuantity' and 'releasedNotional'
+       are what the old one holds and are taken off the account's exposure first.
+    */
+    bool Allows(AccountID account, Price price, Quantity quantity, std::optional<Price> bestBid, std::optional<Price> bestAsk,
+        Quantity releasedQuantity = 0, std::int64_t releasedNotional = 0) const
+    {
+        if(limits_.maxOrderQuantity_ != 0 && quantity > limits_.maxOrderQuantity_)
+            return false;
+
+        if(limits_.priceCollar_ != 0 && ((bestBid && price < *bestBid - limits_.priceCollar_) || (bestAsk && price > *bestAsk + limits_.priceCollar_)))
+            return false;
+
+        if(account == NoAccount)
+            return true;
+
+        if(!HasRoomFor(account))
+            return false;
+
+        const auto& exposure = accounts_[account].exposure_;
+        const auto openQuantity = exposure.openQuantity_ - releasedQuantity + quantity;
+        const auto openNotional = exposure.openNotional_ - releasedNotional + Notional(price, quantity);
+        return (limits_.maxOpenQuantity_ == 0 || openQuantity <= limits_.maxOpenQuantity_) &&
+            (limits_.maxOpenNotional_ == 0 || openNotional <= limits_.maxOpenNotional_);
+    }
+
+    // An order went on the book, 'account' must have passed Allows() (or HasRoomFor() for a restored order).
+    void OnAdded(OrderHandle handle, AccountID account, Price price, Quantity quantity)
+    {
+        if(!enabled_)
+            return;
+
+        if(handle >= orderAccounts_.size())
+            Reserve(std::max<std::size_t>(handle + 1, orderAccounts_.size() * 2));
+
+        orderAccounts_[handle] = account;
+        if(account == NoAccount)
+            return;
+
+        auto& entry = accounts_[account];
+        entry.exposure_.openQuantity_ += quantity;
+        entry.exposure_.openNotional_ += Notional(price, quantity);
+
+        links_[handle] = Links{ InvalidOrderHandle, entry.head_ };
+        if(entry.head_ != InvalidOrderHandle)
+            links_[entry.head_].prev_ = handle;
+        entry.head_ = handle;
+    }
+
+    // 'quantity' of a resting order left the book: filled, reduced or cancelled. 'price' is the order's own price.
+    void OnRemoved(OrderHandle handle, Price price, Quantity quantity)
+    {
+        if(!enabled_)
+            return;
+
+        const auto account = orderAccounts_[handle];
+        if(account != NoAccount)
+        {
+            accounts_[account].exposure_.openQuantity_ -= quantity;
+            accounts_[account].exposure_.openNotional_ -= Notional(price, quantity);
+        }
+    }
+
+    // The order left the book for good and its handle is going back to the pool.
+    void OnReleased(OrderHandle handle)
+    {
+        if(!enabled_)
+            return;
+
+        const auto account = std::exchange(orderAccounts_[handle], NoAccount);
+        if(account == NoAccount)
+            return;
+
+        const auto links = links_[handle];
+        if(links.prev_ != InvalidOrderHandle)
+            links_[links.prev_].next_ = links.next_;
+        else
+            accounts_[account].head_ = links.next_;
+
+        if(links.next_ != InvalidOrderHandle)
+            links_[links.next_].prev_ = links.prev_;
+    }
+
+    // The order left the book together with every other one, see Orderbook::MassCancel(). Its account is reset
+    // whole rather than unlinked order by order, only the accounts of the cancelled orders are touched.
+    void OnCleared(OrderHandle handle)
+    {
+        if(!enabled_)
+            return;
+
+        const auto account = std::exchange(orderAccounts_[handle], NoAccount);
+        if(account != NoAccount)
+            accounts_[account] = Account{ };
+    }
+
+    AccountID AccountOf(OrderHandle handle) const { return handle < orderAccounts_.size() ? orderAccounts_[handle] : NoAccount; }
+    AccountExposure GetExposure(AccountID account) const { return HasRoomFor(account) ? accounts_[account].exposure_ : AccountExposure{ }; }
+
+    // Walks the resting orders of an account, newest first.
+    OrderHandle FirstOrder(AccountID account) const { return account != NoAccount && HasRoomFor(account) ? accounts_[account].head_ : InvalidOrderHandle; }
+    OrderHandle NextOrder(OrderHandle handle) const { return links_[handle].next_; }
+
+    std::size_t MemoryUsage() const
+    {
+        return accounts_.capacity() * sizeof(Account) + orderAccounts_.capacity() * sizeof(AccountID) + links_.capacity() * sizeof(Links);
+    }
+
+    static std::int64_t Notional(Price price, Quantity quantity) { return std::int64_t{ price } * quantity; }
+
+private:
+    struct Account
+    {
+        AccountExposure exposure_;
+        OrderHandle head_{ InvalidOrderHandle };
+    };
+
+    struct Links
+    {
+        OrderHandle prev_{ InvalidOrderHandle };
+        OrderHandle next_{ InvalidOrderHandle };
+    };
+
+    RiskLimits limits_;
+    bool enabled_;
+    std::vector<Account> accounts_;             // By AccountID.
+    std::vector<AccountID> orderAccounts_;      // By OrderHandle, NoAccount unless the handle holds a resting order of an account.
+    std::vector<Links> links_;                  // By OrderHandle, the list of the account's orders.
+};
@@ -0,0 +1,137 @@
+#include "SharedMemory.h"
+
+#include <cerrno>
+#include <format>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::uint32_t CurrentProcessId()
+{
+#if defined(_WIN32)
+    return static_cast<std::uint32_t>(GetCurrentProcessId());
+#else
+    return static_cast<std::uint32_t>(::getpid());
+#endif
+}
+
+bool IsProcessAlive(std::uint32_t processId)
+{
+#if defined(_WIN32)
+    const auto process = OpenProcess(SYNCHRONIZE, FALSE, processId);
+    if(!process)
+        return false;
+
+    const bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+    CloseHandle(process);
+    return alive;
+#else
+    // Signal 0 only checks the process exists, EPERM means it does but belongs to someone else.
+    return ::kill(static_cast<pid_t>(processId), 0) == 0 || errno == EPERM;
+#endif
+}
+
+
+SharedMemory::SharedMemory(const std::string& name, Mode mode, std::size_t size)
+    : name_{ name }
+    , mode_{ mode }
+{
+#if defined(_WIN32)
+    // Named mappings backed by the paging file go away with the last handle, there is nothing left behind to unlink.
+    HANDLE mappingHandle;
+    if(mode_ == Mode::Create)
+    {
+        mappingHandle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(std::uint64_t{ size } >> 32),
+            static_cast<DWORD>(size), name_.c_str());
+        if(mappingHandle && GetLastError() == ERROR_ALREADY_EXISTS)
+        {
+            CloseHandle(mappingHandle);
+            throw std::runtime_error(std::format("Shared memory ({}) is in use by another process.", name_));
+        }
+    }
+    else
+        mappingHandle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name_.c_str());
+
+    if(!mappingHandle)
+        throw std::runtime_error(std::format("Shared memory ({}) cannot be opened.", name_));
+
+    mapping_ = MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if(!mapping_)
+    {
+        CloseHandle(mappingHandle);
+        throw std::runtime_error(std::format("Shared memory ({}) cannot be mapped.", name_));
+    }
+
+    MEMORY_BASIC_INFORMATION information{ };
+    VirtualQuery(mapping_, &information, sizeof(information));
+    size_ = mode_ == Mode::Create ? size : static_cast<std::size_t>(information.RegionSize);
+    mappingHandle_ = reinterpret_cast<std::intptr_t>(mappingHandle);
+#else
+    const auto file = mode_ == Mode::Create ? ::shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600) : ::shm_open(name_.c_str(), O_RDWR, 0);
+    if(file < 0 && mode_ == Mode::Create && errno == EEXIST)
+        throw std::runtime_error(std::format("Shared memory ({}) is in use by another process.", name_));
+    if(file < 0)
+        throw std::runtime_error(std::format("Shared memory ({}) cannot be opened.", name_));
+
+    if(mode_ == Mode::Create)
+    {
+        if(::ftruncate(file, static_cast<off_t>(size)) != 0)
+        {
+            ::close(file);
+            ::shm_unlink(name_.c_str());
+            throw std::runtime_error(std::format("Shared memory ({}) cannot be sized.", name_));
+        }
+        size_ = size;
+    }
+    else
+    {
+        struct stat status{ };
+        ::fstat(file, &status);
+        size_ = static_cast<std::size_t>(status.st_size);
+    }
+
+    int flags = MAP_SHARED;
+#if defined(MAP_POPULATE)
+    flags |= MAP_POPULATE;      // Every page is faulted in now rather than on the data path.
+#endif
+    mapping_ = size_ != 0 ? ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, flags, file, 0) : MAP_FAILED;
+    ::close(file);
+
+    if(mapping_ == MAP_FAILED)
+    {
+        mapping_ = nullptr;
+        if(mode_ == Mode::Create)
+            ::shm_unlink(name_.c_str());
+        throw std::runtime_error(std::format("Shared memory ({}) cannot be mapped.", name_));
+    }
+#endif
+}
+
+void SharedMemory::Remove([[maybe_unused]] const std::string& name)
+{
+#if !defined(_WIN32)
+    ::shm_unlink(name.c_str());
+#endif
+}
+
+
+SharedMemory::~SharedMemory()
+{
+#if defined(_WIN32)
+    UnmapViewOfFile(mapping_);
+    CloseHandle(reinterpret_cast<HANDLE>(mappingHandle_));
+#else
+    ::munmap(mapping_, size_);
+    if(mode_ == Mode::Create)
+        ::shm_unlink(name_.c_str());
+#endif
+}
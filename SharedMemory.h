@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <type_traits>
+
+#include "RingBuffer.h"
+
+// The id of the calling process, and whether the process with that id is still running.
+std::uint32_t CurrentProcessId();
+bool IsProcessAlive(std::uint32_t processId);
+
+/*
+** SharedMemory is a named, read-write memory segment that several processes on the host map at the same time.
+** Created, the segment is new and zero filled, and creating a name that exists fails: only the creator's layout
+   tells whether a segment of that name was left behind by a process that died, so it is up to the creator to check
+   and Remove() it first. Opened, it is the segment of the process that created it, with the size it was created with.
+** The creator removes the name again when it goes away, processes that still have it mapped keep their mapping.
+*/
+class SharedMemory
+{
+public:
+    enum class Mode
+    {
+        Create,
+        Open,
+    };
+
+    SharedMemory(const std::string& name, Mode mode, std::size_t size = 0);
+    SharedMemory(const SharedMemory&) = delete;
+    void operator=(const SharedMemory&) = delete;
+    SharedMemory(SharedMemory&&) = delete;
+    void operator=(SharedMemory&&) = delete;
+    ~SharedMemory();
+
+    std::byte* Data() const { return static_cast<std::byte*>(mapping_); }
+    std::size_t Size() const { return size_; }
+
+    // Removes the name of a segment, processes that have it mapped keep their mapping. Named mappings on Windows go
+    // away with their last handle and have no name to remove, there this does nothing.
+    static void Remove(const std::string& name);
+
+private:
+    std::string name_;
+    Mode mode_;
+    void* mapping_{ nullptr };
+    std::size_t size_{ };
+    std::intptr_t mappingHandle_{ };
+};
+
+/*
+** SharedRing is a bounded SPSC queue laid out in memory it doesn't own, such as a SharedMemory segment, so that the
+   producer and the consumer can be different processes. Every process builds its own SharedRing over the same bytes.
+** The two counters sit on their own cache lines and each side caches the other side's counter, so an uncontended
+   push or pop touches the other side's line only when the cached value runs out. No call ever enters the kernel.
+** Only plain, trivially copyable records can be queued, they are copied in and read in place.
+*/
+template<typename T>
+class SharedRing
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Only plain records can be shared between processes.");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "The ring's counters must be lock-free to be shared between processes.");
+
+public:
+    // The bytes needed for a ring of 'capacity' records, which must be a power of two.
+    static constexpr std::size_t BytesFor(std::size_t capacity) { return sizeof(Counters) + capacity * sizeof(T); }
+
+    SharedRing() = default;
+    SharedRing(std::byte* memory, std::size_t capacity)
+        : counters_{ std::launder(reinterpret_cast<Counters*>(memory)) }
+        , values_{ reinterpret_cast<T*>(memory + sizeof(Counters)) }
+        , mask_{ capacity - 1 }
+    { }
+
+    // Constructs an empty ring in 'memory', done once by the process that sets the memory up.
+    static void Initialize(std::byte* memory) { new(memory) Counters{ }; }
+
+    // Empties the ring, only while neither side is using it.
+    void Reset()
+    {
+        counters_->tail_.store(0, std::memory_order_relaxed);
+        counters_->head_.store(0, std::memory_order_release);
+        cachedHead_ = cachedTail_ = 0;
+    }
+
+    std::size_t Capacity() const { return mask_ + 1; }
+
+    // Producer side. Returns false if the ring is full.
+    bool TryPush(const T& value)
+    {
+        const auto tail = counters_->tail_.load(std::memory_order_relaxed);
+        if(tail - cachedHead_ == Capacity())
+        {
+            cachedHead_ = counters_->head_.load(std::memory_order_acquire);
+            if(tail - cachedHead_ == Capacity())
+                return false;
+        }
+
+        values_[tail & mask_] = value;
+        counters_->tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer side, exact for the producer.
+    std::size_t FreeSlots()
+    {
+        cachedHead_ = counters_->head_.load(std::memory_order_acquire);
+        return Capacity() - static_cast<std::size_t>(counters_->tail_.load(std::memory_order_relaxed) - cachedHead_);
+    }
+
+    // Consumer side. Calls function(value) for up to 'maxCount' queued records, in order, and releases their slots.
+    template<typename Function>
+    std::size_t ConsumeBatch(std::size_t maxCount, Function function)
+    {
+        const auto head = counters_->head_.load(std::memory_order_relaxed);
+        if(cachedTail_ == head)
+            cachedTail_ = counters_->tail_.load(std::memory_order_acquire);
+
+        const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(cachedTail_ - head, maxCount));
+        for(std::size_t index = 0; index < count; ++index)
+            function(values_[(head + index) & mask_]);
+
+        if(count != 0)
+            counters_->head_.store(head + count, std::memory_order_release);
+
+        return count;
+    }
+
+private:
+    struct Counters
+    {
+        alignas(CacheLineSize) std::atomic<std::uint64_t> tail_{ };     // Next position the producer writes.
+        alignas(CacheLineSize) std::atomic<std::uint64_t> head_{ };     // Next position the consumer reads.
+    };
+
+    Counters* counters_{ nullptr };
+    T* values_{ nullptr };
+    std::size_t mask_{ };
+    std::uint64_t cachedHead_{ };       // Only used by the producer.
+    std::uint64_t cachedTail_{ };       // Only used by the consumer.
+};
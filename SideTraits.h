@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Usings.h"
+#include "Side.h"
+
+/*
+** SideTraits holds everything that differs between the two sides of the book, resolved at compile time.
+** The book's hot paths are templates on the Side they work on: the runtime Side of an order is turned into a
+   template argument once, where the order enters the book, and from there on no comparison branches on it.
+*/
+template<Side S>
+struct SideTraits;
+
+template<>
+struct SideTraits<Side::Buy>
+{
+    static constexpr Side Opposite = Side::Sell;
+
+    // Bids are better the higher they are.
+    static constexpr bool IsBetter(Price price, Price other) { return price > other; }
+
+    // A buy order at 'price' trades with a resting ask at 'restingPrice' if it pays at least as much.
+    static constexpr bool Crosses(Price price, Price restingPrice) { return price >= restingPrice; }
+};
+
+template<>
+struct SideTraits<Side::Sell>
+{
+    static constexpr Side Opposite = Side::Buy;
+
+    // Asks are better the lower they are.
+    static constexpr bool IsBetter(Price price, Price other) { return price < other; }
+
+    // A sell order at 'price' trades with a resting bid at 'restingPrice' if it asks for at most as much.
+    static constexpr bool Crosses(Price price, Price restingPrice) { return price <= restingPrice; }
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <iostream>
+
+// What the behaviour tests (the *Test.cpp programs) share. Check() reports a failed check on stderr and counts it, so a
+// test carries on and reports every failure of a run. main() ends with 'return CheckResult("...");', which exits with 1
+// if any check failed.
+inline int checkFailures = 0;
+
+inline void Check(bool condition, const char* what)
+{
+    if(!condition)
+    {
+        std::cerr << "FAILED: " << what << '\n';
+        ++checkFailures;
+    }
+}
+
+inline int CheckResult(const char* subject)
+{
+    if(checkFailures == 0)
+        std::cerr << "all " << subject << " checks passed\n";
+    else
+        std::cerr << checkFailures << ' ' << subject << " checks failed\n";
+
+    return checkFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include "Usings.h"
+#include "RingBuffer.h"
+
+// The best level of each side of a book. A side without orders has a price, quantity and count of 0.
+struct TopOfBook
+{
+    Price bidPrice_{ };
+    Quantity bidQuantity_{ };
+    Quantity bidCount_{ };
+    Price askPrice_{ };
+    Quantity askQuantity_{ };
+    Quantity askCount_{ };
+    std::uint64_t sequence_{ };     // The book's market data sequence when it was published, see MarketDataPublisher.
+
+    bool HasBid() const { return bidCount_ != 0; }
+    bool HasAsk() const { return askCount_ != 0; }
+
+    bool SameLevels(const TopOfBook& other) const
+    {
+        return bidPrice_ == other.bidPrice_ && bidQuantity_ == other.bidQuantity_ && bidCount_ == other.bidCount_ &&
+            askPrice_ == other.askPrice_ && askQuantity_ == other.askQuantity_ && askCount_ == other.askCount_;
+    }
+};
+
+/*
+** TopOfBookPublisher hands the TopOfBook from the thread changing the book to any number of reading threads through
+   a seqlock: the writer makes the version odd, stores the fields and makes it even again, a reader copies the fields
+   and keeps the copy only if the version was the same even number before and after.
+** The writer never waits for the readers and never takes a lock, and readers never write to the shared line, so
+   polling it from many threads costs the book nothing beyond the stores of Publish().
+** The fields are packed into atomic words, which keeps a reader racing with the writer well defined. The whole
+   publisher is a single cache line, no other data of the book shares it.
+*/
+class alignas(CacheLineSize) TopOfBookPublisher
+{
+public:
+    // Only ever called by the one thread that changes the book.
+    void Publish(const TopOfBook& top)
+    {
+        const auto version = version_.load(std::memory_order_relaxed);
+        version_.store(version + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        bid_.store(Pack(top.bidPrice_, top.bidQuantity_), std::memory_order_relaxed);
+        ask_.store(Pack(top.askPrice_, top.askQuantity_), std::memory_order_relaxed);
+        counts_.store(std::uint64_t{ top.bidCount_ } << 32 | top.askCount_, std::memory_order_relaxed);
+        sequence_.store(top.sequence_, std::memory_order_relaxed);
+
+        version_.store(version + 2, std::memory_order_release);
+    }
+
+    // Safe from any thread. Only retries while a Publish() is in progress, which is a handful of stores.
+    TopOfBook Read() const
+    {
+        while(true)
+        {
+            const auto version = version_.load(std::memory_order_acquire);
+            if(version & 1)
+                continue;
+
+            const auto bid = bid_.load(std::memory_order_relaxed);
+            const auto ask = ask_.load(std::memory_order_relaxed);
+            const auto counts = counts_.load(std::memory_order_relaxed);
+            const auto sequence = sequence_.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(version_.load(std::memory_order_relaxed) != version)
+                continue;
+
+            return TopOfBook{ UnpackPrice(bid), UnpackQuantity(bid), static_cast<Quantity>(counts >> 32),
+                UnpackPrice(ask), UnpackQuantity(ask), static_cast<Quantity>(counts), sequence };
+        }
+    }
+
+private:
+    std::atomic<std::uint64_t> version_{ };
+    std::atomic<std::uint64_t> bid_{ };
+    std::atomic<std::uint64_t> ask_{ };
+    std::atomic<std::uint64_t> counts_{ };
+    std::atomic<std::uint64_t> sequence_{ };
+
+    static std::uint64_t Pack(Price price, Quantity quantity) { return std::uint64_t{ static_cast<std::uint32_t>(price) } << 32 | quantity; }
+    static Price UnpackPrice(std::uint64_t word) { return static_cast<Price>(static_cast<std::uint32_t>(word >> 32)); }
+    static Quantity UnpackQuantity(std::uint64_t word) { return static_cast<Quantity>(word); }
+};
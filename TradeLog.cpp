@@ -0,0 +1,247 @@
+#include "TradeLog.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    void CheckHeader(const TradeLogHeader& header, const std::string& path)
+    {
+        if(header.magic_ != TradeLogHeader::Magic || header.version_ != TradeLogHeader{ }.version_ || header.columnCount_ != TradeColumnCount)
+            throw std::runtime_error(std::format("File ({}) is not a trade log this build can read.", path));
+    }
+
+    std::int64_t ColumnValue(const TradeLogRecord& record, TradeColumn column)
+    {
+        switch(column)
+        {
+        case TradeColumn::Sequence: return static_cast<std::int64_t>(record.sequence_);
+        case TradeColumn::Timestamp: return record.timestamp_;
+        case TradeColumn::BidOrderId: return static_cast<std::int64_t>(record.bidOrderId_);
+        case TradeColumn::AskOrderId: return static_cast<std::int64_t>(record.askOrderId_);
+        case TradeColumn::BidPrice: return record.bidPrice_;
+        case TradeColumn::AskPrice: return record.askPrice_;
+        case TradeColumn::Quantity: return record.quantity_;
+        }
+
+        return 0;
+    }
+
+    void SetColumnValue(TradeLogRecord& record, TradeColumn column, std::int64_t value)
+    {
+        switch(column)
+        {
+        case TradeColumn::Sequence: record.sequence_ = static_cast<std::uint64_t>(value); break;
+        case TradeColumn::Timestamp: record.timestamp_ = value; break;
+        case TradeColumn::BidOrderId: record.bidOrderId_ = static_cast<OrderID>(value); break;
+        case TradeColumn::AskOrderId: record.askOrderId_ = static_cast<OrderID>(value); break;
+        case TradeColumn::BidPrice: record.bidPrice_ = static_cast<Price>(value); break;
+        case TradeColumn::AskPrice: record.askPrice_ = static_cast<Price>(value); break;
+        case TradeColumn::Quantity: record.quantity_ = static_cast<Quantity>(value); break;
+        }
+    }
+
+    void WriteVarint(std::vector<std::uint8_t>& bytes, std::uint64_t value)
+    {
+        while(value >= 0x80)
+        {
+            bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<std::uint8_t>(value));
+    }
+}
+
+
+TradeLog::TradeLog(const std::string& path, const TradeLogOptions& options)
+    : options_{ options }
+    , file_{ path }
+    , firstSequence_{ }
+    , records_{ options.capacity_, options.waitStrategy_ }
+{
+    options_.blockSize_ = std::max<std::size_t>(options_.blockSize_, 1);
+
+    const auto size = file_.Size();
+    if(size < sizeof(TradeLogHeader))
+    {
+        const TradeLogHeader header;
+        file_.Truncate(0);
+        file_.Write(&header, sizeof(header));
+    }
+    else
+    {
+        TradeLogHeader header;
+        file_.ReadAt(&header, sizeof(header), 0);
+        CheckHeader(header, path);
+
+        // Walk the block headers to the last complete block, a block only partly written when the process died is
+        // dropped and the next one is written in its place.
+        std::uint64_t end = sizeof(TradeLogHeader);
+        while(end + sizeof(TradeBlockHeader) <= size)
+        {
+            TradeBlockHeader block;
+            file_.ReadAt(&block, sizeof(block), end);
+            if(block.magic_ != TradeBlockHeader::Magic || end + sizeof(TradeBlockHeader) + block.ColumnsSize() > size)
+                break;
+
+            end += sizeof(TradeBlockHeader) + block.ColumnsSize();
+            firstSequence_ = block.firstSequence_ + block.tradeCount_;
+        }
+
+        file_.Truncate(end);
+    }
+
+    block_.reserve(options_.blockSize_);
+    writtenSequence_.store(firstSequence_, std::memory_order_relaxed);
+    writerThread_ = std::thread{ [this] { Run(); } };
+}
+
+TradeLog::~TradeLog()
+{
+    shutdown_.store(true, std::memory_order_release);
+    records_.Wake();
+    writerThread_.join();
+}
+
+
+void TradeLog::WaitUntilWritten(std::uint64_t sequence) const
+{
+    for(auto written = GetWrittenSequence(); written <= sequence; written = GetWrittenSequence())
+        writtenSequence_.wait(written, std::memory_order_acquire);
+}
+
+
+void TradeLog::Run()
+{
+    auto sequence = firstSequence_;
+
+    while(true)
+    {
+        const auto consumed = records_.ConsumeBatch(options_.blockSize_ - block_.size(), [this, &sequence](const TradeLogRecord& record)
+        {
+            block_.push_back(record);
+            block_.back().sequence_ = sequence++;
+        });
+
+        // Keep filling the block while trades keep coming, write it once it is full or the ring has run dry.
+        if(block_.size() == options_.blockSize_ || (consumed == 0 && !block_.empty()))
+        {
+            WriteBlock();
+            continue;
+        }
+
+        if(consumed != 0)
+            continue;
+
+        // Trades appended before the shutdown request are still written, the ring is empty by the time we leave.
+        if(shutdown_.load(std::memory_order_acquire))
+            return;
+
+        records_.WaitForData();
+    }
+}
+
+
+void TradeLog::WriteBlock()
+{
+    TradeBlockHeader header;
+    header.tradeCount_ = static_cast<std::uint32_t>(block_.size());
+    header.firstSequence_ = block_.front().sequence_;
+
+    // The header goes in front of the columns once their sizes are known, so the block is a single write.
+    encoded_.assign(sizeof(TradeBlockHeader), 0);
+    for(std::size_t index = 0; index < TradeColumnCount; ++index)
+    {
+        const auto column = static_cast<TradeColumn>(index);
+        const auto columnStart = encoded_.size();
+
+        if(column == TradeColumn::Quantity)
+        {
+            for(const auto& record : block_)
+                WriteVarint(encoded_, static_cast<std::uint64_t>(ColumnValue(record, column)));
+        }
+        else
+        {
+            std::uint64_t previous{ };
+            for(const auto& record : block_)
+            {
+                const auto value = static_cast<std::uint64_t>(ColumnValue(record, column));
+                const auto delta = static_cast<std::int64_t>(value - previous);
+                WriteVarint(encoded_, static_cast<std::uint64_t>(delta) << 1 ^ static_cast<std::uint64_t>(delta >> 63));
+                previous = value;
+            }
+        }
+
+        header.columnBytes_[index] = static_cast<std::uint32_t>(encoded_.size() - columnStart);
+    }
+    std::memcpy(encoded_.data(), &header, sizeof(header));
+
+    // Like the journal, a failed write or sync ends the process (the exception leaves the writer thread) before
+    // the block is counted as written.
+    file_.Write(encoded_.data(), encoded_.size());
+    if(options_.syncOnWrite_)
+        file_.Sync();
+
+    writtenSequence_.fetch_add(block_.size(), std::memory_order_release);
+    writtenSequence_.notify_all();
+    block_.clear();
+}
+
+
+TradeLogReader::TradeLogReader(const std::string& path)
+    : file_{ path }
+{
+    const auto bytes = file_.Bytes();
+    const auto* data = reinterpret_cast<const std::uint8_t*>(bytes.data());
+
+    TradeLogHeader header{ .magic_ = 0 };
+    if(bytes.size() >= sizeof(TradeLogHeader))
+        std::memcpy(&header, data, sizeof(header));
+    CheckHeader(header, path);
+
+    // Blocks have any length, so their headers are copied out rather than used in place.
+    std::uint64_t offset = sizeof(TradeLogHeader);
+    while(offset + sizeof(TradeBlockHeader) <= bytes.size())
+    {
+        TradeBlockHeader blockHeader;
+        std::memcpy(&blockHeader, data + offset, sizeof(blockHeader));
+        if(blockHeader.magic_ != TradeBlockHeader::Magic || offset + sizeof(TradeBlockHeader) + blockHeader.ColumnsSize() > bytes.size())
+            break;
+
+        Block block{ blockHeader.tradeCount_, { }, blockHeader.columnBytes_ };
+        auto* column = data + offset + sizeof(TradeBlockHeader);
+        for(std::size_t index = 0; index < TradeColumnCount; ++index)
+        {
+            block.columns_[index] = column;
+            column += block.columnBytes_[index];
+        }
+
+        blocks_.push_back(block);
+        tradeCount_ += block.tradeCount_;
+        offset += sizeof(TradeBlockHeader) + blockHeader.ColumnsSize();
+    }
+
+    encodedSize_ = offset - sizeof(TradeLogHeader);
+}
+
+
+std::size_t TradeLogReader::ReadTrades(std::vector<TradeLogRecord>& trades) const
+{
+    trades.resize(static_cast<std::size_t>(tradeCount_));
+
+    std::size_t first{ };
+    for(const auto& block : blocks_)
+    {
+        for(std::size_t index = 0; index < TradeColumnCount; ++index)
+        {
+            const auto column = static_cast<TradeColumn>(index);
+            auto* record = trades.data() + first;
+            DecodeColumn(column, block.columns_[index], block.columnBytes_[index], block.tradeCount_,
+                [column, &record](std::int64_t value) { SetColumnValue(*record++, column, value); });
+        }
+
+        first += block.tradeCount_;
+    }
+
+    return trades.size();
+}
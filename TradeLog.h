@@ -0,0 +1,229 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Usings.h"
+#include "Trade.h"
+#include "RingBuffer.h"
+#include "AppendFile.h"
+#include "MappedFile.h"
+
+// One trade as the TradeLog keeps it, both legs in one record. 'timestamp_' is in nanoseconds since the book clock's epoch.
+struct TradeLogRecord
+{
+    std::uint64_t sequence_{ };
+    std::int64_t timestamp_{ };
+    OrderID bidOrderId_{ };
+    OrderID askOrderId_{ };
+    Price bidPrice_{ };
+    Price askPrice_{ };
+    Quantity quantity_{ };
+};
+
+// The columns of a TradeLog block, in the order they are stored.
+enum class TradeColumn : std::uint8_t
+{
+    Sequence,
+    Timestamp,
+    BidOrderId,
+    AskOrderId,
+    BidPrice,
+    AskPrice,
+    Quantity,
+};
+
+constexpr std::size_t TradeColumnCount = 7;
+
+// The trade log file starts with this header, the blocks follow it back to back.
+struct TradeLogHeader
+{
+    std::uint64_t magic_{ Magic };
+    std::uint32_t version_{ 1 };
+    std::uint32_t columnCount_{ TradeColumnCount };
+
+    static constexpr std::uint64_t Magic = 0x474f4c544b4f4f42;     // "BOOKTLOG" read as little-endian bytes.
+};
+
+// Every block starts with this header, its columns follow it back to back, 'columnBytes_[column]' bytes each.
+struct TradeBlockHeader
+{
+    std::uint32_t magic_{ Magic };
+    std::uint32_t tradeCount_{ };
+    std::uint64_t firstSequence_{ };
+    std::array<std::uint32_t, TradeColumnCount> columnBytes_{ };
+    std::uint32_t reserved_{ };
+
+    static constexpr std::uint32_t Magic = 0x4b4c4254;              // "TBLK" read as little-endian bytes.
+
+    std::uint64_t ColumnsSize() const
+    {
+        std::uint64_t size{ };
+        for(const auto bytes : columnBytes_)
+            size += bytes;
+        return size;
+    }
+};
+
+static_assert(sizeof(TradeBlockHeader) == 48, "TradeBlockHeader is written to disk as is and must not change size.");
+
+struct TradeLogOptions
+{
+    std::size_t capacity_{ 1 << 16 };       // Trades buffered between the books and the writer, Append() waits once they are all in use.
+    std::size_t blockSize_{ 4096 };         // Most trades in one block.
+    bool syncOnWrite_{ true };              // Sync every block to stable storage, off means the OS decides when the data reaches the disk.
+    WaitStrategy waitStrategy_{ WaitStrategy::Blocking };
+};
+
+/*
+** TradeLog is the on-disk record of every trade of the books it is attached to (see Orderbook::AttachTradeLog()),
+   laid out for analysis rather than replay: a column per field instead of a record per trade.
+** Append() only copies the trades into a lock-free ring, a background writer drains the ring into blocks of up to
+   'blockSize_' trades and writes each block with one write (and one sync). A block is written when it is full or
+   when the ring runs dry, so a quiet book still gets its trades on disk promptly, in smaller blocks.
+** Within a block every column is encoded on its own: the difference to the previous value, zigzagged and written as a
+   varint. Sequences go up by one, timestamps of one command are equal and prices and order ids of neighbouring trades
+   are close, so most values take one or two bytes instead of eight. Quantities are written as plain varints. Blocks
+   don't depend on each other.
+** Sequence numbers start at zero for the first trade ever written and go up by one per trade. Opening an existing
+   log appends to it, a block torn by a crash is cut off first.
+*/
+class TradeLog
+{
+public:
+    explicit TradeLog(const std::string& path, const TradeLogOptions& options = { });
+    TradeLog(const TradeLog&) = delete;
+    void operator=(const TradeLog&) = delete;
+    TradeLog(TradeLog&&) = delete;
+    void operator=(TradeLog&&) = delete;
+
+    // Writes out everything appended so far before closing the file.
+    ~TradeLog();
+
+    // Called by the book, under its lock or on its single writer thread, with the trades of one command.
+    void Append(std::span<const Trade> trades, std::int64_t timestamp)
+    {
+        for(const auto& trade : trades)
+        {
+            const auto& bid = trade.GetBidTrade();
+            const auto& ask = trade.GetAskTrade();
+            records_.Push(TradeLogRecord{ 0, timestamp, bid.orderid_, ask.orderid_, bid.price_, ask.price_, bid.quantity_ });
+        }
+    }
+
+    // The sequence number the next appended trade will get. Exact when no book is appending.
+    std::uint64_t GetNextSequence() const { return firstSequence_ + records_.PushedCount(); }
+
+    // Every trade with a sequence number below this one has been written (and synced, with syncOnWrite_).
+    std::uint64_t GetWrittenSequence() const { return writtenSequence_.load(std::memory_order_acquire); }
+
+    // Blocks until the trade with this sequence number has been written.
+    void WaitUntilWritten(std::uint64_t sequence) const;
+
+private:
+    TradeLogOptions options_;
+    AppendFile file_;
+    std::uint64_t firstSequence_;
+    RingBuffer<TradeLogRecord, ProducerMode::Multi> records_;
+    std::vector<TradeLogRecord> block_;
+    std::vector<std::uint8_t> encoded_;
+    alignas(CacheLineSize) std::atomic<std::uint64_t> writtenSequence_;
+    std::atomic<bool> shutdown_{ false };
+    std::thread writerThread_;
+
+    void Run();
+    void WriteBlock();
+};
+
+/*
+** TradeLogReader memory-maps a trade log read-only and indexes its blocks, nothing is decoded up front.
+** ScanColumn() decodes a single column and skips the bytes of all the others, so a scan of the prices or the
+   quantities of a whole session only touches those columns. ReadTrades() decodes every column.
+** A trailing partial block (a crash in the middle of a write) is ignored.
+*/
+class TradeLogReader
+{
+public:
+    explicit TradeLogReader(const std::string& path);
+    TradeLogReader(const TradeLogReader&) = delete;
+    void operator=(const TradeLogReader&) = delete;
+    TradeLogReader(TradeLogReader&&) = delete;
+    void operator=(TradeLogReader&&) = delete;
+
+    std::uint64_t Size() const { return tradeCount_; }
+    std::size_t BlockCount() const { return blocks_.size(); }
+
+    // The bytes of the blocks on disk, against the 48 bytes per trade the records take decoded.
+    std::uint64_t EncodedSize() const { return encodedSize_; }
+
+    // Calls function(value) with the value of 'column' for every trade, in sequence order. Returns how many there were.
+    template<typename Function>
+    std::uint64_t ScanColumn(TradeColumn column, Function function) const;
+
+    // Replaces the contents of 'trades' with every trade of the log. Returns how many there are.
+    std::size_t ReadTrades(std::vector<TradeLogRecord>& trades) const;
+
+private:
+    struct Block
+    {
+        std::uint32_t tradeCount_;
+        std::array<const std::uint8_t*, TradeColumnCount> columns_;
+        std::array<std::uint32_t, TradeColumnCount> columnBytes_;
+    };
+
+    MappedFile file_;
+    std::vector<Block> blocks_;
+    std::uint64_t tradeCount_{ };
+    std::uint64_t encodedSize_{ };
+
+    // Decodes one column of one block, calling function(value) for each of its 'count' values.
+    template<typename Function>
+    static void DecodeColumn(TradeColumn column, const std::uint8_t* data, std::uint32_t size, std::uint32_t count, Function function);
+};
+
+
+template<typename Function>
+std::uint64_t TradeLogReader::ScanColumn(TradeColumn column, Function function) const
+{
+    const auto index = static_cast<std::size_t>(column);
+    for(const auto& block : blocks_)
+        DecodeColumn(column, block.columns_[index], block.columnBytes_[index], block.tradeCount_, function);
+
+    return tradeCount_;
+}
+
+
+template<typename Function>
+void TradeLogReader::DecodeColumn(TradeColumn column, const std::uint8_t* data, std::uint32_t size, std::uint32_t count, Function function)
+{
+    const auto* end = data + size;
+    const bool delta = column != TradeColumn::Quantity;
+    std::uint64_t value{ };
+
+    for(std::uint32_t index = 0; index < count; ++index)
+    {
+        std::uint64_t encoded{ };
+        for(unsigned shift = 0; ; shift += 7)
+        {
+            if(data == end || shift > 63)
+                throw std::runtime_error(std::format("Trade log column ({}) is corrupt.", static_cast<int>(column)));
+
+            const auto byte = *data++;
+            encoded |= std::uint64_t{ byte & 0x7fu } << shift;
+            if(!(byte & 0x80))
+                break;
+        }
+
+        // Undo the zigzag, then add the difference to the previous value (in unsigned arithmetic, where it wraps).
+        value = delta ? value + ((encoded >> 1) ^ (0 - (encoded & 1))) : encoded;
+        function(static_cast<std::int64_t>(value));
+    }
+}
@@ -0,0 +1,60 @@
+// Summarises a TradeLog from its columns alone: trade count, volume, VWAP and price range, and how much the encoding
+// saved. Only the price and quantity columns are decoded.
+//
+//     TradeLogReport <trade log>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "TradeLog.h"
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cerr << "usage: TradeLogReport <trade log>\n";
+        return 2;
+    }
+
+    try
+    {
+        const TradeLogReader log{ argv[1] };
+        const auto start = std::chrono::steady_clock::now();
+
+        // The two columns are scanned one after the other, the prices are kept to weigh them by the quantities.
+        std::vector<std::int64_t> prices;
+        prices.reserve(static_cast<std::size_t>(log.Size()));
+        log.ScanColumn(TradeColumn::AskPrice, [&prices](std::int64_t price) { prices.push_back(price); });
+
+        std::uint64_t volume{ };
+        double notional{ };
+        std::size_t index{ };
+        log.ScanColumn(TradeColumn::Quantity, [&](std::int64_t quantity)
+        {
+            volume += static_cast<std::uint64_t>(quantity);
+            notional += static_cast<double>(prices[index++]) * static_cast<double>(quantity);
+        });
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const auto [low, high] = std::minmax_element(prices.begin(), prices.end());
+        const auto decodedSize = log.Size() * sizeof(TradeLogRecord);
+
+        std::cout << log.Size() << " trades in " << log.BlockCount() << " blocks, volume " << volume
+            << ", vwap " << (volume != 0 ? notional / static_cast<double>(volume) : 0.0);
+        if(!prices.empty())
+            std::cout << ", low " << *low << ", high " << *high;
+        std::cout << '\n' << log.EncodedSize() << " bytes encoded against " << decodedSize << " decoded ("
+            << (log.EncodedSize() != 0 ? static_cast<double>(decodedSize) / static_cast<double>(log.EncodedSize()) : 0.0) << "x), scanned in " << elapsed << "s\n";
+    }
+    catch(const std::exception& exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+// Appends trades whose prices, order IDs and timestamps jump between the extremes of their types, so that the zigzag
+// deltas span the whole range, and reads them back over many small blocks with ReadTrades() and ScanColumn(). The log
+// is then reopened to append more, and cut short in the middle of its last block, as a crash would leave it.
+//
+//     TradeLogTest
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "TradeLog.h"
+#include "TestCheck.h"
+
+namespace
+{
+    bool Same(const TradeLogRecord& left, const TradeLogRecord& right)
+    {
+        return left.sequence_ == right.sequence_ && left.timestamp_ == right.timestamp_ && left.bidOrderId_ == right.bidOrderId_ &&
+            left.askOrderId_ == right.askOrderId_ && left.bidPrice_ == right.bidPrice_ && left.askPrice_ == right.askPrice_ &&
+            left.quantity_ == right.quantity_;
+    }
+
+    std::int64_t ColumnOf(const TradeLogRecord& record, TradeColumn column)
+    {
+        switch(column)
+        {
+        case TradeColumn::Sequence: return static_cast<std::int64_t>(record.sequence_);
+        case TradeColumn::Timestamp: return record.timestamp_;
+        case TradeColumn::BidOrderId: return static_cast<std::int64_t>(record.bidOrderId_);
+        case TradeColumn::AskOrderId: return static_cast<std::int64_t>(record.askOrderId_);
+        case TradeColumn::BidPrice: return record.bidPrice_;
+        case TradeColumn::AskPrice: return record.askPrice_;
+        case TradeColumn::Quantity: return record.quantity_;
+        }
+
+        return 0;
+    }
+
+    // Small blocks, so a few hundred trades already make many of them. Not syncing keeps the test fast.
+    const TradeLogOptions Options{ .capacity_ = 1024, .blockSize_ = 16, .syncOnWrite_ = false };
+
+    // Every value jumps between the extremes of its type and random values, the deltas between neighbours span the
+    // whole range, both signs included. Each trade is appended on its own, with its own timestamp.
+    void AppendTrades(TradeLog& log, std::vector<TradeLogRecord>& expected, std::size_t count, std::mt19937_64& random)
+    {
+        constexpr auto PriceMin = std::numeric_limits<Price>::min();
+        constexpr auto PriceMax = std::numeric_limits<Price>::max();
+        constexpr auto IdMax = std::numeric_limits<OrderID>::max();
+        constexpr auto TimeMin = std::numeric_limits<std::int64_t>::min();
+        constexpr auto TimeMax = std::numeric_limits<std::int64_t>::max();
+
+        for(std::size_t index = 0; index < count; ++index)
+        {
+            const auto pick = random();
+            const auto extreme = index % 4 != 3;
+            const TradeLogRecord record{
+                .sequence_ = expected.size(),
+                .timestamp_ = extreme ? (index % 2 ? TimeMin : TimeMax) : static_cast<std::int64_t>(pick),
+                .bidOrderId_ = extreme ? (index % 2 ? IdMax : 0) : pick,
+                .askOrderId_ = extreme ? (index % 2 ? 1 : IdMax - 1) : pick >> 7,
+                .bidPrice_ = extreme ? (index % 2 ? PriceMin : PriceMax) : static_cast<Price>(pick),
+                .askPrice_ = extreme ? (index % 2 ? -1 : PriceMin + 1) : -static_cast<Price>(pick >> 40),
+                .quantity_ = extreme ? (index % 2 ? std::numeric_limits<Quantity>::max() : 1) : static_cast<Quantity>(pick >> 32),
+            };
+
+            const Trade trade{ TradeInfo{ record.bidOrderId_, record.bidPrice_, record.quantity_ }, TradeInfo{ record.askOrderId_, record.askPrice_, record.quantity_ } };
+            log.Append(std::span<const Trade>{ &trade, 1 }, record.timestamp_);
+            expected.push_back(record);
+        }
+
+        log.WaitUntilWritten(log.GetNextSequence() - 1);
+    }
+
+    void CheckReads(const std::string& path, const std::vector<TradeLogRecord>& expected, const char* what)
+    {
+        const TradeLogReader reader{ path };
+        Check(reader.Size() == expected.size(), what);
+
+        std::vector<TradeLogRecord> trades;
+        Check(reader.ReadTrades(trades) == expected.size() && std::equal(trades.begin(), trades.end(), expected.begin(), Same), "ReadTrades returns every trade appended");
+
+        for(std::size_t index = 0; index < TradeColumnCount; ++index)
+        {
+            const auto column = static_cast<TradeColumn>(index);
+            std::size_t next{ };
+            bool same = true;
+            reader.ScanColumn(column, [&](std::int64_t value)
+            {
+                same = same && next < expected.size() && value == ColumnOf(expected[next], column);
+                ++next;
+            });
+            Check(same && next == expected.size(), "ScanColumn returns the column of every trade appended");
+        }
+    }
+
+    void RoundTripAndTornBlock()
+    {
+        const auto path = (std::filesystem::temp_directory_path() / "TradeLogTest.log").string();
+        std::filesystem::remove(path);
+
+        std::mt19937_64 random{ 25 };
+        std::vector<TradeLogRecord> expected;
+
+        {
+            TradeLog log{ path, Options };
+            Check(log.GetNextSequence() == 0, "a new log starts at sequence 0");
+            AppendTrades(log, expected, 300, random);
+        }
+        CheckReads(path, expected, "a log reads back every trade");
+        Check(TradeLogReader{ path }.BlockCount() >= 300 / Options.blockSize_, "the trades are spread over several blocks");
+
+        // Reopening a log appends to it, the sequence numbers carry on.
+        {
+            TradeLog log{ path, Options };
+            Check(log.GetNextSequence() == expected.size(), "a reopened log carries on the sequence");
+            AppendTrades(log, expected, 200, random);
+        }
+        CheckReads(path, expected, "a reopened log reads back the trades of both sessions");
+
+        // Cut the last block short, as a crash in the middle of its write would.
+        const auto blocks = TradeLogReader{ path }.BlockCount();
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+
+        std::size_t kept{ };
+        {
+            const TradeLogReader reader{ path };
+            kept = static_cast<std::size_t>(reader.Size());
+            Check(reader.BlockCount() == blocks - 1 && kept < expected.size() && kept >= 300, "a reader ignores the torn block");
+        }
+        expected.resize(kept);
+        CheckReads(path, expected, "the trades before the torn block read back");
+
+        // The torn block is cut off on reopen and its sequence numbers are handed out again.
+        {
+            TradeLog log{ path, Options };
+            Check(log.GetNextSequence() == kept, "a log reopened after a torn block carries on from the last complete block");
+            AppendTrades(log, expected, 100, random);
+        }
+        CheckReads(path, expected, "the trades appended after the torn block follow the others");
+
+        std::filesystem::remove(path);
+    }
+}
+
+
+int main()
+{
+    RoundTripAndTornBlock();
+
+    return CheckResult("trade log");
+}
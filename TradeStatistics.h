@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "Usings.h"
+#include "RingBuffer.h"
+
+// The trading of a book since it was created (or since ResetTradeStatistics()). Prices are the execution prices.
+struct TradeStatistics
+{
+    Price lastPrice_{ };
+    Quantity lastQuantity_{ };
+    std::uint64_t tradeCount_{ };
+    std::uint64_t volume_{ };
+    double notional_{ };            // Sum of price * quantity, in double so a long session can't overflow it.
+
+    double Vwap() const { return volume_ != 0 ? notional_ / static_cast<double>(volume_) : 0.0; }
+};
+
+// The trades of one interval. Intervals without any trade have no bar.
+struct TradeBar
+{
+    std::chrono::system_clock::time_point start_;
+    Price open_{ };
+    Price high_{ };
+    Price low_{ };
+    Price close_{ };
+    std::uint64_t volume_{ };
+    std::uint64_t tradeCount_{ };
+    double notional_{ };
+
+    double Vwap() const { return volume_ != 0 ? notional_ / static_cast<double>(volume_) : 0.0; }
+};
+
+/*
+** TradeStatisticsRecorder keeps the TradeStatistics of a book and its last OHLCV bars up to date as trades happen,
+   each trade costing a handful of stores, so nobody downstream has to aggregate the Trades vectors again.
+** The book thread writes between Begin() and End(), once per batch of trades, and any number of threads read through
+   Read() and ReadBars() without a lock: like TopOfBookPublisher it is a seqlock over atomic words, readers retry
+   while a batch is being recorded and the writer never waits for them.
+** The bars are a fixed ring of 'barCount' intervals of 'barInterval', aligned to the clock's epoch (one minute bars
+   start on the minute). With a barCount of 0 no bars are kept and the book doesn't read the clock at all.
+*/
+class alignas(CacheLineSize) TradeStatisticsRecorder
+{
+public:
+    TradeStatisticsRecorder(std::chrono::nanoseconds barInterval, std::size_t barCount)
+        : barInterval_{ std::max<std::int64_t>(barInterval.count(), 1) }
+        , barCount_{ barCount }
+        , bars_{ barCount != 0 ? std::make_unique<BarWords[]>(barCount) : nullptr }
+    { }
+
+    bool KeepsBars() const { return barCount_ != 0; }
+
+    // Book thread only. Every Record() goes between a Begin() and an End().
+    void Begin()
+    {
+        const auto version = version_.load(std::memory_order_relaxed);
+        version_.store(version + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void End() { version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    void Record(Price price, Quantity quantity, std::chrono::system_clock::time_point time)
+    {
+        const auto notional = static_cast<double>(price) * static_cast<double>(quantity);
+        last_.store(Pack(price, quantity), std::memory_order_relaxed);
+        Add(tradeCount_, 1);
+        Add(volume_, quantity);
+        AddDouble(notional_, notional);
+
+        if(!KeepsBars())
+            return;
+
+        const auto since = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        const auto start = since - (since % barInterval_ + barInterval_) % barInterval_;
+        const auto written = barsWritten_.load(std::memory_order_relaxed);
+        auto* bar = written != 0 ? &bars_[(written - 1) % barCount_] : nullptr;
+
+        // A trade in a later interval opens the next bar of the ring, overwriting the oldest one. The trade clock is the
+        // wall clock, so a step backwards can time a trade before the current bar: it is counted in the current bar,
+        // the bars stay in order and no interval gets a second bar.
+        if(!bar || start > bar->start_.load(std::memory_order_relaxed))
+        {
+            bar = &bars_[written % barCount_];
+            bar->start_.store(start, std::memory_order_relaxed);
+            bar->openHigh_.store(Pack(price, static_cast<Quantity>(price)), std::memory_order_relaxed);
+            bar->lowClose_.store(Pack(price, static_cast<Quantity>(price)), std::memory_order_relaxed);
+            bar->volume_.store(0, std::memory_order_relaxed);
+            bar->tradeCount_.store(0, std::memory_order_relaxed);
+            bar->notional_.store(0, std::memory_order_relaxed);
+            barsWritten_.store(written + 1, std::memory_order_relaxed);
+        }
+
+        const auto openHigh = bar->openHigh_.load(std::memory_order_relaxed);
+        const auto lowClose = bar->lowClose_.load(std::memory_order_relaxed);
+        bar->openHigh_.store(Pack(UnpackPrice(openHigh), static_cast<Quantity>(std::max(price, UnpackSecond(openHigh)))), std::memory_order_relaxed);
+        bar->lowClose_.store(Pack(std::min(price, UnpackPrice(lowClose)), static_cast<Quantity>(price)), std::memory_order_relaxed);
+        Add(bar->volume_, quantity);
+        Add(bar->tradeCount_, 1);
+        AddDouble(bar->notional_, notional);
+    }
+
+    // Book thread only, between a Begin() and an End().
+    void Reset()
+    {
+        last_.store(0, std::memory_order_relaxed);
+        tradeCount_.store(0, std::memory_order_relaxed);
+        volume_.store(0, std::memory_order_relaxed);
+        notional_.store(0, std::memory_order_relaxed);
+        barsWritten_.store(0, std::memory_order_relaxed);
+    }
+
+    // Safe from any thread.
+    TradeStatistics Read() const
+    {
+        while(true)
+        {
+            const auto version = version_.load(std::memory_order_acquire);
+            if(version & 1)
+            {
+                CpuRelax();
+                continue;
+            }
+
+            const auto last = last_.load(std::memory_order_relaxed);
+            const TradeStatistics statistics{ UnpackPrice(last), static_cast<Quantity>(last), tradeCount_.load(std::memory_order_relaxed),
+                volume_.load(std::memory_order_relaxed), std::bit_cast<double>(notional_.load(std::memory_order_relaxed)) };
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(version_.load(std::memory_order_relaxed) == version)
+                return statistics;
+        }
+    }
+
+    // Safe from any thread. Replaces the contents of 'bars' with the bars in the ring, oldest first, the last one
+    // being the interval still in progress. Returns how many there are.
+    std::size_t ReadBars(std::vector<TradeBar>& bars) const
+    {
+        bars.reserve(barCount_);
+        while(true)
+        {
+            bars.clear();
+            const auto version = version_.load(std::memory_order_acquire);
+            if(version & 1)
+            {
+                CpuRelax();
+                continue;
+            }
+
+            const auto written = barsWritten_.load(std::memory_order_relaxed);
+            for(auto index = written > barCount_ ? written - barCount_ : 0; index < written; ++index)
+            {
+                const auto& bar = bars_[index % barCount_];
+                const auto openHigh = bar.openHigh_.load(std::memory_order_relaxed);
+                const auto lowClose = bar.lowClose_.load(std::memory_order_relaxed);
+                bars.push_back(TradeBar{ std::chrono::system_clock::time_point{ std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                        std::chrono::nanoseconds{ bar.start_.load(std::memory_order_relaxed) }) },
+                    UnpackPrice(openHigh), UnpackSecond(openHigh), UnpackPrice(lowClose), UnpackSecond(lowClose),
+                    bar.volume_.load(std::memory_order_relaxed), bar.tradeCount_.load(std::memory_order_relaxed),
+                    std::bit_cast<double>(bar.notional_.load(std::memory_order_relaxed)) });
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(version_.load(std::memory_order_relaxed) == version)
+                return bars.size();
+        }
+    }
+
+private:
+    struct BarWords
+    {
+        std::atomic<std::int64_t> start_{ };        // Nanoseconds since the clock's epoch.
+        std::atomic<std::uint64_t> openHigh_{ };
+        std::atomic<std::uint64_t> lowClose_{ };
+        std::atomic<std::uint64_t> volume_{ };
+        std::atomic<std::uint64_t> tradeCount_{ };
+        std::atomic<std::uint64_t> notional_{ };    // The bits of a double.
+    };
+
+    std::atomic<std::uint64_t> version_{ };
+    std::atomic<std::uint64_t> last_{ };
+    std::atomic<std::uint64_t> tradeCount_{ };
+    std::atomic<std::uint64_t> volume_{ };
+    std::atomic<std::uint64_t> notional_{ };
+    std::atomic<std::uint64_t> barsWritten_{ };
+    std::int64_t barInterval_;
+    std::size_t barCount_;
+    std::unique_ptr<BarWords[]> bars_;
+
+    // The writer is the only one changing these, so a load and a store is all an update takes.
+    static void Add(std::atomic<std::uint64_t>& word, std::uint64_t value) { word.store(word.load(std::memory_order_relaxed) + value, std::memory_order_relaxed); }
+    static void AddDouble(std::atomic<std::uint64_t>& word, double value)
+    {
+        word.store(std::bit_cast<std::uint64_t>(std::bit_cast<double>(word.load(std::memory_order_relaxed)) + value), std::memory_order_relaxed);
+    }
+
+    static std::uint64_t Pack(Price price, Quantity second) { return std::uint64_t{ static_cast<std::uint32_t>(price) } << 32 | second; }
+    static Price UnpackPrice(std::uint64_t word) { return static_cast<Price>(static_cast<std::uint32_t>(word >> 32)); }
+    static Price UnpackSecond(std::uint64_t word) { return static_cast<Price>(static_cast<std::uint32_t>(word)); }
+};
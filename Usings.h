@@ -1,9 +1,15 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 
 //Using Aliases helps us making the code more readable and eays to understand
 using Price = std::int32_t;
 using Quantity = std::uint32_t;
 using OrderID = std::uint64_t;
-using OrderIDs = std::vector<OrderID>;
\ No newline at end of file
+using OrderIDs = std::vector<OrderID>;
+using SymbolID = std::uint32_t;
+
+// The trading account an order belongs to, used by the book's pre-trade risk checks (see RiskGate). 0 is no account.
+using AccountID = std::uint32_t;
+constexpr AccountID NoAccount = 0;
\ No newline at end of file